@@ -906,6 +906,42 @@ void dma_desc_set_mode(uint32_t desc_base, enum dma_ch ch, enum dma_mode mode);
 #define dma_set_alt_mode(ch, mode)	\
 	dma_desc_set_mode(DMA_ALTCTRLBASE, ch, mode)
 
+/* Transfer engine, see dma_engine_common.c */
+
+#define DMA_ENGINE_CHANNELS	12
+
+/* buf value passed to the callback on a bus error */
+#define DMA_ENGINE_ERROR	(-1)
+
+/* buf is the ping-pong half that completed (0 or 1), 0 for the other
+ * transfer types, or DMA_ENGINE_ERROR */
+typedef void (*dma_engine_cb)(enum dma_ch ch, int buf, void *arg);
+
+void dma_desc_fill(struct dma_chan_desc *desc, uint32_t src,
+		enum dma_mem src_inc, uint32_t dest, enum dma_mem dest_inc,
+		enum dma_mem size, uint16_t count, enum dma_r_power r_power,
+		enum dma_mode mode);
+
+void dma_engine_init(void);
+struct dma_chan_desc *dma_engine_primary(enum dma_ch ch);
+struct dma_chan_desc *dma_engine_alternate(enum dma_ch ch);
+
+void dma_engine_basic(enum dma_ch ch, uint32_t source, uint32_t signal,
+		uint32_t src, enum dma_mem src_inc,
+		uint32_t dest, enum dma_mem dest_inc,
+		enum dma_mem size, uint16_t count,
+		dma_engine_cb cb, void *arg);
+void dma_engine_ping_pong(enum dma_ch ch, uint32_t source, uint32_t signal,
+		uint32_t reg, bool to_periph, enum dma_mem size,
+		void *buf0, void *buf1, uint16_t count,
+		dma_engine_cb cb, void *arg);
+void dma_engine_scatter_gather(enum dma_ch ch, uint32_t source,
+		uint32_t signal, const struct dma_chan_desc *tasks,
+		uint16_t ntasks, bool periph,
+		dma_engine_cb cb, void *arg);
+void dma_engine_stop(enum dma_ch ch);
+void dma_engine_irq(void);
+
 END_DECLS
 
 #endif
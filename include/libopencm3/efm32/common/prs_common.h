@@ -341,6 +341,28 @@ enum prs_ch {
 };
 /**@}*/
 
+#define PRS_CHANNELS		12
+
+/* Event inputs the chain builder can connect a PRS channel to */
+enum prs_consumer {
+	PRS_CONSUMER_ADC_SINGLE,	/* base ADC0, start single conversion */
+	PRS_CONSUMER_ADC_SCAN,		/* base ADC0, start scan sequence */
+	PRS_CONSUMER_DAC,		/* base DAC0, index channel, start */
+	PRS_CONSUMER_TIMER_CC,		/* base TIMERn, index CC, capture */
+};
+
+/* One producer to consumer link for prs_chain_build() */
+struct prs_link {
+	uint32_t source;	/* PRS_CH_CTRL_SOURCESEL_* */
+	uint32_t signal;	/* PRS_CH_CTRL_SIGSEL_* */
+	uint32_t edge;		/* PRS_CH_CTRL_EDSEL_* */
+	bool async;		/* for producers and consumers running in EM2 */
+	enum prs_consumer consumer;
+	uint32_t base;
+	uint8_t index;
+	int8_t ch;		/* channel used, set by prs_chain_build() */
+};
+
 BEGIN_DECLS
 
 void prs_enable_gpio_output(enum prs_ch ch);
@@ -357,6 +379,11 @@ void prs_set_edge(enum prs_ch ch, uint32_t edge);
 void prs_set_source(enum prs_ch ch, uint32_t source);
 void prs_set_signal(enum prs_ch ch, uint32_t sig);
 
+bool prs_chain_build(struct prs_link *links, int n);
+int prs_chain_connect(uint32_t source, uint32_t signal, uint32_t edge,
+		      enum prs_consumer consumer, uint32_t base, uint8_t index);
+void prs_chain_release(enum prs_ch ch);
+
 END_DECLS
 
 #endif
@@ -263,7 +263,7 @@
 #define TIMER_CC_CTRL_ICEDGE_NONE	3
 
 #define TIMER_CC_CTRL_FILT		(1 << 21)
-#define TIMER_CC_CTRL_INSEL		(1 << 21)
+#define TIMER_CC_CTRL_INSEL		(1 << 20)
 
 
 #define TIMER_CC_CTRL_PRSSEL_SHIFT	(16)
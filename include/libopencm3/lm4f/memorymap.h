@@ -68,4 +68,6 @@
 
 #define SYSCTL_BASE			(0x400FE000U)
 
+#define UDMA_BASE			(0x400FF000U)
+
 #endif
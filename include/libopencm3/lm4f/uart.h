@@ -437,6 +437,30 @@ enum uart_fifo_tx_trigger_level {
 	UART_FIFO_TX_TRIG_1_8	= UART_IFLS_TXIFLSEL_1_8
 };
 
+/** @ingroup uart_buffered
+ * @{
+ * \brief Ring buffer, the size is a power of two.  head and tail run freely
+ * and are masked on access.
+ */
+struct uart_ring {
+	uint8_t *buf;
+	uint16_t mask;
+	volatile uint16_t head;
+	volatile uint16_t tail;
+};
+
+/** \brief State of a ring buffered UART, see @ref uart_buffered_init() */
+struct uart_buffered {
+	uint32_t uart;
+	struct uart_ring rx;
+	struct uart_ring tx;
+	volatile uint32_t rx_dropped;	/* bytes lost, receive ring full */
+	volatile uint32_t rx_errors;	/* overrun, break, parity, framing */
+	int8_t tx_dma;			/* uDMA channel, -1 without */
+	volatile uint16_t tx_dma_len;	/* bytes of the running transfer */
+};
+/**@}*/
+
 /* =============================================================================
  * Function prototypes
  * ---------------------------------------------------------------------------*/
@@ -543,6 +567,20 @@ bool uart_is_interrupt_source(uint32_t uart, enum uart_interrupt_flag source)
 }
 /**@}*/
 
+void uart_buffered_init(struct uart_buffered *ub, uint32_t uart,
+			uint8_t *rxbuf, uint16_t rxsize,
+			uint8_t *txbuf, uint16_t txsize);
+void uart_buffered_use_tx_dma(struct uart_buffered *ub, uint8_t channel,
+			      uint8_t encoding);
+uint16_t uart_buffered_write(struct uart_buffered *ub, const uint8_t *data,
+			     uint16_t len);
+uint16_t uart_buffered_read(struct uart_buffered *ub, uint8_t *data,
+			    uint16_t len);
+uint16_t uart_buffered_rx_available(struct uart_buffered *ub);
+uint16_t uart_buffered_tx_free(struct uart_buffered *ub);
+void uart_buffered_flush(struct uart_buffered *ub);
+void uart_buffered_isr(struct uart_buffered *ub);
+
 END_DECLS
 
 /**@}*/
@@ -0,0 +1,175 @@
+/** @defgroup udma_defines Micro Direct Memory Access
+ *
+ * @brief <b>Defined Constants and Types for the LM4F Micro Direct Memory
+ * Access controller (uDMA)</b>
+ *
+ * @ingroup LM4Fxx_defines
+ *
+ * LGPL License Terms @ref lgpl_license
+ */
+
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LM4F_UDMA_H
+#define LM4F_UDMA_H
+
+/**@{*/
+
+#include <libopencm3/cm3/common.h>
+#include <libopencm3/lm4f/memorymap.h>
+
+/* =============================================================================
+ * uDMA registers
+ * ---------------------------------------------------------------------------*/
+
+#define UDMA_STAT			MMIO32(UDMA_BASE + 0x000)
+#define UDMA_CFG			MMIO32(UDMA_BASE + 0x004)
+#define UDMA_CTLBASE			MMIO32(UDMA_BASE + 0x008)
+#define UDMA_ALTBASE			MMIO32(UDMA_BASE + 0x00C)
+#define UDMA_WAITSTAT			MMIO32(UDMA_BASE + 0x010)
+#define UDMA_SWREQ			MMIO32(UDMA_BASE + 0x014)
+#define UDMA_USEBURSTSET		MMIO32(UDMA_BASE + 0x018)
+#define UDMA_USEBURSTCLR		MMIO32(UDMA_BASE + 0x01C)
+#define UDMA_REQMASKSET			MMIO32(UDMA_BASE + 0x020)
+#define UDMA_REQMASKCLR			MMIO32(UDMA_BASE + 0x024)
+#define UDMA_ENASET			MMIO32(UDMA_BASE + 0x028)
+#define UDMA_ENACLR			MMIO32(UDMA_BASE + 0x02C)
+#define UDMA_ALTSET			MMIO32(UDMA_BASE + 0x030)
+#define UDMA_ALTCLR			MMIO32(UDMA_BASE + 0x034)
+#define UDMA_PRIOSET			MMIO32(UDMA_BASE + 0x038)
+#define UDMA_PRIOCLR			MMIO32(UDMA_BASE + 0x03C)
+#define UDMA_ERRCLR			MMIO32(UDMA_BASE + 0x04C)
+#define UDMA_CHASGN			MMIO32(UDMA_BASE + 0x500)
+#define UDMA_CHIS			MMIO32(UDMA_BASE + 0x504)
+#define UDMA_CHMAP(n)			MMIO32(UDMA_BASE + 0x510 + (n) * 4)
+
+/* UDMA_STAT */
+#define UDMA_STAT_MASTEN		(1 << 0)
+
+/* UDMA_CFG */
+#define UDMA_CFG_MASTEN			(1 << 0)
+
+/* =============================================================================
+ * Channel control word
+ * ---------------------------------------------------------------------------*/
+
+#define UDMA_CHCTL_DSTINC_SHIFT		30
+#define UDMA_CHCTL_DSTINC_MASK		(3 << UDMA_CHCTL_DSTINC_SHIFT)
+#define UDMA_CHCTL_DSTSIZE_SHIFT	28
+#define UDMA_CHCTL_DSTSIZE_MASK		(3 << UDMA_CHCTL_DSTSIZE_SHIFT)
+#define UDMA_CHCTL_SRCINC_SHIFT		26
+#define UDMA_CHCTL_SRCINC_MASK		(3 << UDMA_CHCTL_SRCINC_SHIFT)
+#define UDMA_CHCTL_SRCSIZE_SHIFT	24
+#define UDMA_CHCTL_SRCSIZE_MASK		(3 << UDMA_CHCTL_SRCSIZE_SHIFT)
+#define UDMA_CHCTL_ARBSIZE_SHIFT	14
+#define UDMA_CHCTL_ARBSIZE_MASK		(0xf << UDMA_CHCTL_ARBSIZE_SHIFT)
+#define UDMA_CHCTL_XFERSIZE_SHIFT	4
+#define UDMA_CHCTL_XFERSIZE_MASK	(0x3ff << UDMA_CHCTL_XFERSIZE_SHIFT)
+#define UDMA_CHCTL_NXTUSEBURST		(1 << 3)
+#define UDMA_CHCTL_XFERMODE_SHIFT	0
+#define UDMA_CHCTL_XFERMODE_MASK	(7 << UDMA_CHCTL_XFERMODE_SHIFT)
+
+/* Most transfers one descriptor can do */
+#define UDMA_MAX_TRANSFER		1024
+
+/** Data size and address increment, for both sides */
+enum udma_size {
+	UDMA_SIZE_8	= 0,
+	UDMA_SIZE_16	= 1,
+	UDMA_SIZE_32	= 2,
+	UDMA_INC_NONE	= 3,	/* increment only */
+};
+
+/** Transfer mode */
+enum udma_mode {
+	UDMA_MODE_STOP		= 0,
+	UDMA_MODE_BASIC		= 1,
+	UDMA_MODE_AUTO		= 2,
+	UDMA_MODE_PINGPONG	= 3,
+	UDMA_MODE_MEM_SG	= 4,
+	UDMA_MODE_MEM_SG_ALT	= 5,
+	UDMA_MODE_PER_SG	= 6,
+	UDMA_MODE_PER_SG_ALT	= 7,
+};
+
+/* =============================================================================
+ * Channel assignments, encoding 0 unless noted
+ * ---------------------------------------------------------------------------*/
+
+#define UDMA_CH_USB_EP1_RX		0
+#define UDMA_CH_USB_EP1_TX		1
+#define UDMA_CH_USB_EP2_RX		2
+#define UDMA_CH_USB_EP2_TX		3
+#define UDMA_CH_USB_EP3_RX		4
+#define UDMA_CH_USB_EP3_TX		5
+#define UDMA_CH_UART0_RX		8
+#define UDMA_CH_UART0_TX		9
+#define UDMA_CH_SSI0_RX			10
+#define UDMA_CH_SSI0_TX			11
+#define UDMA_CH_UART1_RX		22
+#define UDMA_CH_UART1_TX		23
+#define UDMA_CH_SSI1_RX			24
+#define UDMA_CH_SSI1_TX			25
+#define UDMA_CH_UART2_RX		0	/* encoding 1 */
+#define UDMA_CH_UART2_TX		1	/* encoding 1 */
+
+#define UDMA_CHANNELS			32
+
+/** Channel control structure, the layout is fixed by the hardware */
+struct udma_ctl {
+	uint32_t src_end;
+	uint32_t dst_end;
+	uint32_t control;
+	uint32_t unused;
+};
+
+/* =============================================================================
+ * Function prototypes
+ * ---------------------------------------------------------------------------*/
+BEGIN_DECLS
+
+void udma_init(void);
+void udma_disable(void);
+struct udma_ctl *udma_primary(uint8_t channel);
+struct udma_ctl *udma_alternate(uint8_t channel);
+
+void udma_channel_assign(uint8_t channel, uint8_t encoding);
+void udma_channel_enable(uint8_t channel);
+void udma_channel_disable(uint8_t channel);
+bool udma_channel_is_enabled(uint8_t channel);
+void udma_channel_set_burst_only(uint8_t channel, bool burst);
+
+void udma_ctl_fill(struct udma_ctl *ctl, uint32_t src, enum udma_size src_inc,
+		   uint32_t dst, enum udma_size dst_inc, enum udma_size size,
+		   uint16_t count, uint8_t arb_log2, enum udma_mode mode);
+void udma_transfer_start(uint8_t channel, uint32_t src, enum udma_size src_inc,
+			 uint32_t dst, enum udma_size dst_inc,
+			 enum udma_size size, uint16_t count, uint8_t arb_log2);
+uint16_t udma_transfer_remaining(uint8_t channel);
+void udma_request(uint8_t channel);
+
+bool udma_channel_done(uint8_t channel);
+void udma_channel_clear_done(uint8_t channel);
+bool udma_error(void);
+void udma_clear_error(void);
+
+END_DECLS
+
+/**@}*/
+
+#endif
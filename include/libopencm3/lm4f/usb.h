@@ -366,6 +366,16 @@
 /** RESUME interrupt status and clear */
 #define USB_DRISC_RESUME		(1 << 0)
 
+/* =============================================================================
+ * USB_DMASEL values
+ *
+ * Each uDMA channel of the USB (0 to 5) has a 4 bit field holding the
+ * endpoint it serves, even channels receive, odd channels transmit.
+ * ---------------------------------------------------------------------------*/
+#define USB_DMASEL_SHIFT(ch)		((ch) * 4)
+#define USB_DMASEL_MASK(ch)		(0x0F << USB_DMASEL_SHIFT(ch))
+#define USB_DMASEL_CHANNELS		6
+
 /* =============================================================================
  * USB_PP values
  * ---------------------------------------------------------------------------*/
@@ -414,6 +424,8 @@ void usb_enable_interrupts(enum usb_interrupt ints,
 void usb_disable_interrupts(enum usb_interrupt ints,
 			    enum usb_ep_interrupt rx_ints,
 			    enum usb_ep_interrupt tx_ints);
+bool usb_ep_dma_enable(uint8_t addr);
+void usb_ep_dma_disable(uint8_t addr);
 
 END_DECLS
 
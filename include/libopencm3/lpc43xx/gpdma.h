@@ -36,6 +36,7 @@
 
 /**@{*/
 
+#include <stddef.h>
 #include <libopencm3/cm3/common.h>
 #include <libopencm3/lpc43xx/memorymap.h>
 
@@ -547,6 +548,104 @@
 #define GPDMA_CxCONFIG_H_MASK		(0x1 << GPDMA_CxCONFIG_H_SHIFT)
 #define GPDMA_CxCONFIG_H(x)		((x) << GPDMA_CxCONFIG_H_SHIFT)
 
+/* --- GPDMA driver -------------------------------------------------------- */
+
+#define GPDMA_NUM_CHANNELS		8
+
+/* Largest TRANSFERSIZE a single linked list item can move */
+#define GPDMA_MAX_TRANSFER		0xfff
+
+/* Transfer widths, for GPDMA_CCONTROL_SWIDTH / GPDMA_CCONTROL_DWIDTH */
+#define GPDMA_WIDTH_8			0x0
+#define GPDMA_WIDTH_16			0x1
+#define GPDMA_WIDTH_32			0x2
+
+/* Burst sizes, for GPDMA_CCONTROL_SBSIZE / GPDMA_CCONTROL_DBSIZE */
+#define GPDMA_BSIZE_1			0x0
+#define GPDMA_BSIZE_4			0x1
+#define GPDMA_BSIZE_8			0x2
+#define GPDMA_BSIZE_16			0x3
+#define GPDMA_BSIZE_32			0x4
+#define GPDMA_BSIZE_64			0x5
+#define GPDMA_BSIZE_128			0x6
+#define GPDMA_BSIZE_256			0x7
+
+/* Flow control and transfer type, for GPDMA_CCONFIG_FLOWCNTRL */
+#define GPDMA_FLOW_M2M			0x0
+#define GPDMA_FLOW_M2P			0x1
+#define GPDMA_FLOW_P2M			0x2
+#define GPDMA_FLOW_P2P			0x3
+
+/*
+ * DMA request lines and the CREG_DMAMUX selection that routes the
+ * peripheral to them, for GPDMA_CCONFIG_SRCPERIPHERAL /
+ * GPDMA_CCONFIG_DESTPERIPHERAL and gpdma_periph_select().
+ */
+#define GPDMA_PERIPH_USART0_TX		1
+#define GPDMA_PERIPH_USART0_TX_MUX	1
+#define GPDMA_PERIPH_USART0_RX		2
+#define GPDMA_PERIPH_USART0_RX_MUX	1
+#define GPDMA_PERIPH_UART1_TX		3
+#define GPDMA_PERIPH_UART1_TX_MUX	1
+#define GPDMA_PERIPH_UART1_RX		4
+#define GPDMA_PERIPH_UART1_RX_MUX	1
+#define GPDMA_PERIPH_USART2_TX		5
+#define GPDMA_PERIPH_USART2_TX_MUX	1
+#define GPDMA_PERIPH_USART2_RX		6
+#define GPDMA_PERIPH_USART2_RX_MUX	1
+#define GPDMA_PERIPH_USART3_TX		7
+#define GPDMA_PERIPH_USART3_TX_MUX	1
+#define GPDMA_PERIPH_USART3_RX		8
+#define GPDMA_PERIPH_USART3_RX_MUX	1
+#define GPDMA_PERIPH_SSP0_RX		9
+#define GPDMA_PERIPH_SSP0_RX_MUX	0
+#define GPDMA_PERIPH_SSP0_TX		10
+#define GPDMA_PERIPH_SSP0_TX_MUX	0
+#define GPDMA_PERIPH_SSP1_RX		11
+#define GPDMA_PERIPH_SSP1_RX_MUX	0
+#define GPDMA_PERIPH_SSP1_TX		12
+#define GPDMA_PERIPH_SSP1_TX_MUX	0
+
+/*
+ * Linked list item, the layout is fixed by the hardware.  Items must be
+ * word aligned and reachable by the DMA, ie not in the M4 local SRAM
+ * aliases.  next is the address of the following item or 0 to stop.
+ */
+struct gpdma_lli {
+	uint32_t src;
+	uint32_t dest;
+	uint32_t next;
+	uint32_t control;
+};
+
+BEGIN_DECLS
+
+void gpdma_controller_enable(void);
+void gpdma_controller_disable(void);
+void gpdma_periph_select(uint8_t periph, uint8_t mux);
+
+size_t gpdma_lli_build(struct gpdma_lli *lli, size_t nlli,
+		       uint32_t src, uint32_t dest, size_t count,
+		       uint32_t control);
+void gpdma_lli_link(struct gpdma_lli *lli, struct gpdma_lli *next);
+
+void gpdma_channel_start(uint8_t channel, const struct gpdma_lli *lli,
+			 uint32_t config);
+void gpdma_channel_stop(uint8_t channel);
+void gpdma_channel_halt(uint8_t channel);
+bool gpdma_channel_is_enabled(uint8_t channel);
+bool gpdma_channel_is_active(uint8_t channel);
+size_t gpdma_channel_remaining(uint8_t channel);
+
+bool gpdma_tc_flag(uint8_t channel);
+bool gpdma_error_flag(uint8_t channel);
+void gpdma_clear_flags(uint8_t channel);
+
+bool gpdma_memcpy(uint8_t channel, struct gpdma_lli *lli, size_t nlli,
+		  void *dest, const void *src, size_t len);
+
+END_DECLS
+
 /**@}*/
 
 #endif
@@ -23,8 +23,86 @@
 #include <libopencm3/cm3/common.h>
 #include <libopencm3/lpc43xx/memorymap.h>
 
+/* --- Shared memory transport ---------------------------------------------- */
+
+/*
+ * The M4 and M0 exchange messages through a region of SRAM both cores agree
+ * on (usually a section placed by both linker scripts, eg. in AHB SRAM).
+ * One core formats it with ipc_shm_init(), the other one calls
+ * ipc_shm_attach() with the same address.
+ *
+ * There is one single producer / single consumer message ring per direction,
+ * so no locking is needed (the M0 has no exclusive access instructions).
+ * Larger payloads travel zero-copy in buffers from a shared pool, the message
+ * only carries the buffer. A buffer is only ever written by the core that
+ * currently owns it, handing it over transfers the ownership.
+ *
+ * Every ipc_send() raises the peer's core interrupt through SEV (M4TXEV /
+ * M0TXEV), the handler (m0core_isr on the M4, m4core_isr on the M0) must
+ * call ipc_doorbell_clear() and then drain the ring with ipc_recv().
+ */
+
+#define IPC_SHM_MAGIC		0x43495043 /* "CPIC" */
+
+/* Message types below this value are free for the application */
+#define IPC_MSG_USER_MAX	0xff00
+#define IPC_MSG_PING		0xff00 /* answered by ipc_recv() on the peer */
+#define IPC_MSG_PONG		0xff01
+
+/* Owner / state of a pool buffer, only ever written by its current owner */
+#define IPC_BUF_FREE_M4		0
+#define IPC_BUF_FREE_M0		1
+#define IPC_BUF_BUSY_M4		2
+#define IPC_BUF_BUSY_M0		3
+
+struct ipc_msg {
+	uint16_t type;
+	uint16_t len;	/* bytes used in the buffer, if any */
+	int32_t buf;	/* pool buffer index, or -1 */
+	uint32_t arg;
+};
+
+struct ipc_ring {
+	volatile uint32_t head;	/* written by the producer only */
+	volatile uint32_t tail;	/* written by the consumer only */
+	uint32_t mask;		/* entries - 1, entries is a power of two */
+	struct ipc_msg *msgs;
+};
+
+struct ipc_shm {
+	volatile uint32_t magic;
+	struct ipc_ring to_m0;
+	struct ipc_ring to_m4;
+	uint32_t nbufs;
+	uint32_t nbufs_m4;	/* buffers [0, nbufs_m4) are returned to the M4 */
+	uint32_t buf_size;
+	volatile uint8_t *owner;
+	uint8_t *bufs;
+};
+
+BEGIN_DECLS
+
 void ipc_halt_m0(void);
 
 void ipc_start_m0(uint32_t cm0_baseaddr);
 
+bool ipc_shm_init(void *base, uint32_t size, uint32_t ring_entries,
+		  uint32_t nbufs, uint32_t buf_size, uint32_t nbufs_m4);
+bool ipc_shm_attach(void *base);
+void ipc_doorbell_ring(void);
+void ipc_doorbell_clear(void);
+void ipc_doorbell_enable_irq(void);
+bool ipc_send(uint16_t type, uint32_t arg);
+bool ipc_send_buf(uint16_t type, int32_t buf, uint16_t len, uint32_t arg);
+bool ipc_recv(struct ipc_msg *msg);
+int32_t ipc_buf_alloc(void);
+void *ipc_buf_ptr(int32_t buf);
+void ipc_buf_free(int32_t buf);
+#if defined(LPC43XX_M4)
+bool ipc_ping(void);
+uint32_t ipc_ping_cycles(void);
+#endif
+
+END_DECLS
+
 #endif
@@ -39,6 +39,7 @@ LGPL License Terms @ref lgpl_license
 
 #include <libopencm3/cm3/common.h>
 #include <libopencm3/lpc43xx/memorymap.h>
+#include <libopencm3/lpc43xx/gpdma.h>
 
 /* --- Convenience macros -------------------------------------------------- */
 
@@ -111,6 +112,9 @@ LGPL License Terms @ref lgpl_license
 /* RXDMAE: Transmit DMA enable */
 #define SSP_DMACR_TXDMAE                0x2
 
+/* Depth of the Tx and Rx FIFOs, in frames */
+#define SSP_FIFO_DEPTH                  8
+
 typedef enum {
 	SSP0_NUM = 0x0,
 	SSP1_NUM = 0x1
@@ -202,6 +206,20 @@ void ssp_init(ssp_num_t ssp_num,
 
 uint16_t ssp_transfer(ssp_num_t ssp_num, uint16_t data);
 
+/*
+ * Buffer level transfers.  Buffers are uint8_t for frames of up to 8 bits
+ * and uint16_t above, tx may be NULL to send all ones and rx may be NULL to
+ * discard the received frames.
+ */
+void ssp_transfer_buffer(ssp_num_t ssp_num, const void *tx, void *rx,
+			 size_t count);
+
+void ssp_dma_enable(ssp_num_t ssp_num);
+void ssp_dma_disable(ssp_num_t ssp_num);
+bool ssp_dma_transfer(ssp_num_t ssp_num, uint8_t tx_channel,
+		      uint8_t rx_channel, struct gpdma_lli *lli, size_t nlli,
+		      const void *tx, void *rx, size_t count);
+
 END_DECLS
 
 /**@}*/
@@ -22,6 +22,7 @@
 
 #include <libopencm3/cm3/common.h>
 #include <libopencm3/lpc43xx/memorymap.h>
+#include <libopencm3/lpc43xx/gpdma.h>
 
 /* --- Convenience macros -------------------------------------------------- */
 
@@ -418,6 +419,29 @@ typedef enum {
 	UART_RX_DATA_ERROR = 2
 } uart_rx_data_ready_t;
 
+/*
+* Ring buffer of the buffered driver, the size is a power of two.  head and
+* tail run freely and are masked on access.
+*/
+struct uart_ring {
+	uint8_t *buf;
+	uint16_t mask;
+	volatile uint16_t head;
+	volatile uint16_t tail;
+};
+
+/* State of a ring buffered UART, see uart_buffered_init() */
+struct uart_buffered {
+	uart_num_t uart;
+	struct uart_ring rx;
+	struct uart_ring tx;
+	volatile uint32_t rx_dropped;	/* bytes lost, receive ring full */
+	volatile uint32_t rx_errors;	/* overrun, parity, framing, break */
+	int8_t tx_dma;			/* GPDMA channel, -1 without */
+	volatile uint16_t tx_dma_len;	/* bytes of the running transfer */
+	struct gpdma_lli tx_lli;
+};
+
 /* function prototypes */
 
 BEGIN_DECLS
@@ -433,6 +457,21 @@ uint8_t uart_read_timeout(uart_num_t uart_num, uint32_t rx_timeout_nb_cycles,
 	    uart_error_t *error);
 void uart_write(uart_num_t uart_num, uint8_t data);
 
+/* Interrupt driven, ring buffered */
+void uart_buffered_init(struct uart_buffered *ub, uart_num_t uart_num,
+			uint8_t *rxbuf, uint16_t rxsize,
+			uint8_t *txbuf, uint16_t txsize);
+void uart_buffered_use_tx_dma(struct uart_buffered *ub, uint8_t channel);
+uint16_t uart_buffered_write(struct uart_buffered *ub, const uint8_t *data,
+			     uint16_t len);
+uint16_t uart_buffered_read(struct uart_buffered *ub, uint8_t *data,
+			    uint16_t len);
+uint16_t uart_buffered_rx_available(struct uart_buffered *ub);
+uint16_t uart_buffered_tx_free(struct uart_buffered *ub);
+void uart_buffered_flush(struct uart_buffered *ub);
+void uart_buffered_isr(struct uart_buffered *ub);
+void uart_buffered_dma_isr(struct uart_buffered *ub);
+
 END_DECLS
 
 #endif
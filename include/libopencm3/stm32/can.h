@@ -396,10 +396,12 @@ LGPL License Terms @ref lgpl_license
 /* --- CAN_ESR values ------------------------------------------------------ */
 
 /* REC[7:0]: Receive error counter */
-#define CAN_ESR_REC_MASK		(0xF << 24)
+#define CAN_ESR_REC_SHIFT		24
+#define CAN_ESR_REC_MASK		(0xFF << 24)
 
 /* TEC[7:0]: Least significant byte of the 9-bit transmit error counter */
-#define CAN_ESR_TEC_MASK		(0xF << 16)
+#define CAN_ESR_TEC_SHIFT		16
+#define CAN_ESR_TEC_MASK		(0xFF << 16)
 
 /* 15:7 Reserved, forced by hardware to 0 */
 
@@ -504,13 +506,13 @@ LGPL License Terms @ref lgpl_license
 /* --- CAN_TDTxR values ----------------------------------------------------- */
 
 /* TIME[15:0]: Message time stamp */
-#define CAN_TDTxR_TIME_MASK		(0xFFFF << 15)
-#define CAN_TDTxR_TIME_SHIFT		15
+#define CAN_TDTxR_TIME_MASK		(0xFFFF << 16)
+#define CAN_TDTxR_TIME_SHIFT		16
 
-/* 15:6 Reserved, forced by hardware to 0 */
+/* 15:9 Reserved, forced by hardware to 0 */
 
 /* TGT: Transmit global time */
-#define CAN_TDTxR_TGT			(1 << 5)
+#define CAN_TDTxR_TGT			(1 << 8)
 
 /* 7:4 Reserved, forced by hardware to 0 */
 
@@ -640,6 +642,98 @@ LGPL License Terms @ref lgpl_license
 
 /* FB[31:0]: Filter bits */
 
+/* --- Buffered CAN -------------------------------------------------------- */
+
+/** A CAN frame as queued by the buffered driver */
+struct can_frame {
+	uint32_t id;
+	bool ext;
+	bool rtr;
+	uint8_t length;
+	uint8_t fmi;		/* filter match index, received frames */
+	uint16_t timestamp;	/* time triggered mode only */
+	uint8_t data[8];
+};
+
+/** Transmit queue entry, a frame and its place in the queue */
+struct can_tx_slot {
+	struct can_frame frame;
+	uint32_t key;		/* arbitration order, lower goes first */
+	uint32_t order;		/* FIFO order among equal keys */
+};
+
+struct can_buffered_stats {
+	uint32_t rx_frames;
+	uint32_t tx_frames;
+	uint32_t rx_dropped;	/* receive ring full */
+	uint32_t rx_overruns;	/* lost in a hardware FIFO overrun */
+	uint32_t tx_dropped;	/* transmit queue full */
+	uint32_t tx_errors;	/* transmissions that failed for good */
+	uint32_t tx_preempted;	/* mailboxes aborted for a higher priority */
+	uint32_t bus_errors;	/* error frames, by last error code */
+	uint32_t error_passive;
+	uint32_t bus_off;
+	uint8_t last_error;	/* CAN_ESR_LEC_* >> 4 */
+	uint8_t tec;
+	uint8_t rec;
+};
+
+/** State of a buffered CAN port, see can_buffered_init() */
+struct can_buffered {
+	uint32_t canport;
+	struct can_frame *rx;
+	uint16_t rx_mask;
+	volatile uint16_t rx_head;
+	volatile uint16_t rx_tail;
+	struct can_tx_slot *tx;		/* binary heap, by key and order */
+	uint16_t tx_size;
+	volatile uint16_t tx_count;
+	uint32_t tx_order;
+	struct can_tx_slot mailbox[3];	/* frames in the mailboxes */
+	uint8_t mailbox_busy;		/* bit per loaded mailbox */
+	uint8_t abort_pending;		/* bit per mailbox aborted by us */
+	uint8_t error_flags;		/* CAN_ESR_BOFF and CAN_ESR_EPVF */
+	void (*tx_done)(const struct can_frame *frame);
+	struct can_buffered_stats stats;
+};
+
+/* --- Filter compiler ----------------------------------------------------- */
+
+/** IDs to accept, id to last inclusive, for can_filter_compile() */
+struct can_filter_rule {
+	uint32_t id;
+	uint32_t last;		/* same as id for a single ID */
+	bool ext;
+	uint8_t fifo;
+	uint8_t port;		/* 0 for CAN1, 1 for CAN2 */
+};
+
+/** Scratch space of can_filter_compile(), one per aligned ID block */
+struct can_filter_entry {
+	uint32_t id;
+	uint32_t size;		/* IDs in the block, a power of two */
+	uint8_t group;		/* port, fifo and ext */
+};
+
+/** One programmed filter bank, the arguments of can_filter_init() */
+struct can_filter_bank {
+	uint8_t nr;
+	bool scale_32bit;
+	bool id_list_mode;
+	uint8_t fifo;
+	uint32_t fr1;
+	uint32_t fr2;
+};
+
+/** Result of can_filter_compile() */
+struct can_filter_report {
+	uint8_t banks;		/* banks used */
+	uint8_t can2_start;	/* CAN2SB, first bank of CAN2 */
+	uint32_t wanted;	/* IDs asked for */
+	uint64_t accepted;	/* IDs the banks let through */
+	uint16_t false_accept_permille;	/* of the accepted IDs */
+};
+
 /* --- CAN functions -------------------------------------------------------- */
 
 BEGIN_DECLS
@@ -674,6 +768,25 @@ void can_receive(uint32_t canport, uint8_t fifo, bool release, uint32_t *id,
 
 void can_fifo_release(uint32_t canport, uint8_t fifo);
 bool can_available_mailbox(uint32_t canport);
+
+void can_buffered_init(struct can_buffered *cb, uint32_t canport,
+		       struct can_frame *rxbuf, uint16_t rxsize,
+		       struct can_tx_slot *txbuf, uint16_t txsize);
+bool can_buffered_send(struct can_buffered *cb,
+		       const struct can_frame *frame);
+bool can_buffered_receive(struct can_buffered *cb, struct can_frame *frame);
+uint16_t can_buffered_rx_available(struct can_buffered *cb);
+uint16_t can_buffered_tx_pending(struct can_buffered *cb);
+void can_buffered_get_stats(struct can_buffered *cb,
+			    struct can_buffered_stats *stats);
+void can_buffered_isr(struct can_buffered *cb);
+
+int can_filter_compile(const struct can_filter_rule *rules, uint16_t count,
+		       struct can_filter_entry *work, uint16_t work_size,
+		       struct can_filter_bank *banks, uint8_t max_banks,
+		       struct can_filter_report *report);
+void can_filter_apply(const struct can_filter_bank *banks, uint8_t count,
+		      uint8_t can2_start);
 END_DECLS
 
 /**@}*/
@@ -119,6 +119,40 @@
 /* API definitions                                                           */
 /*****************************************************************************/
 
+/** Counter reload for a target clock of ftarget and sync events at fsync */
+#define CRS_RELOAD(ftarget, fsync)	((ftarget) / (fsync) - 1)
+
+/** Frequency error limit for a target clock of ftarget and sync events at
+ * fsync, half the 0.14% trim step of HSI48 rounded */
+#define CRS_FELIM(ftarget, fsync)	\
+	(((ftarget) / (fsync) * 14 + 10000) / 20000)
+
+/** Sync configuration, see crs_configure() */
+struct crs_config {
+	uint32_t syncsrc;	/**< CRS_CFGR_SYNCSRC_xxx */
+	uint32_t syncdiv;	/**< CRS_CFGR_SYNCDIV_xxx */
+	bool falling;		/**< GPIO sync on the falling edge */
+	uint16_t reload;	/**< CRS_RELOAD() */
+	uint8_t felim;		/**< CRS_FELIM() */
+};
+
+/** Trim tracking counters, see crs_get_stats() */
+struct crs_stats {
+	uint32_t sync_ok;	/**< syncs within the error limit */
+	uint32_t sync_warn;	/**< syncs trimmed by more than one step */
+	uint32_t sync_err;	/**< error beyond 128 times the limit */
+	uint32_t sync_miss;	/**< sync event missing */
+	uint32_t trim_ovf;	/**< trim value at its end */
+	uint32_t locked;	/**< syncs within the limit in a row */
+	int32_t last_error;	/**< HSI48 cycles per sync, > 0 too fast */
+	int32_t min_error;
+	int32_t max_error;
+	int64_t error_sum;	/**< over sync_ok + sync_warn syncs */
+	uint8_t trim;
+	uint8_t min_trim;
+	uint8_t max_trim;
+};
+
 /*****************************************************************************/
 /* API Functions                                                             */
 /*****************************************************************************/
@@ -126,6 +160,14 @@
 BEGIN_DECLS
 
 void crs_autotrim_usb_enable(void);
+void crs_configure(const struct crs_config *config);
+void crs_disable(void);
+void crs_set_tracking(bool enable);
+void crs_handle_interrupt(void);
+void crs_get_stats(struct crs_stats *stats);
+void crs_reset_stats(void);
+bool crs_is_locked(uint32_t syncs);
+uint32_t crs_get_frequency(void);
 
 END_DECLS
 /**@}*/
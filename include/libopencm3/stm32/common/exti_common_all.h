@@ -79,6 +79,13 @@
 #define EXTI36				(1 << 4)
 #define EXTI37				(1 << 5)
 
+/** Mask of the lines first to last, e.g. EXTI_LINES(5, 9) for exti9_5_isr */
+#define EXTI_LINES(first, last)		(((2UL << (last)) - 1) & \
+					 ~((1UL << (first)) - 1))
+
+/** Lines with a callback slot in the dispatcher */
+#define EXTI_DISPATCH_LINES		32
+
 /* Trigger types */
 enum exti_trigger_type {
 	EXTI_TRIGGER_RISING,
@@ -86,6 +93,15 @@ enum exti_trigger_type {
 	EXTI_TRIGGER_BOTH,
 };
 
+/** Per line counters of the dispatcher, latencies in CPU cycles */
+struct exti_line_stats {
+	uint32_t count;		/**< callbacks run */
+	uint32_t last_latency;	/**< dispatch entry to callback */
+	uint32_t max_latency;	/**< worst seen since the last reset */
+};
+
+typedef void (*exti_callback_t)(uint8_t line, uint32_t timestamp, void *arg);
+
 BEGIN_DECLS
 
 void exti_set_trigger(uint32_t extis, enum exti_trigger_type trig);
@@ -95,6 +111,12 @@ void exti_reset_request(uint32_t extis);
 void exti_select_source(uint32_t exti, uint32_t gpioport);
 uint32_t exti_get_flag_status(uint32_t exti);
 
+void exti_set_callback(uint8_t line, exti_callback_t callback, void *arg);
+bool exti_set_timestamping(bool enable);
+void exti_dispatch(uint32_t lines);
+void exti_get_line_stats(uint8_t line, struct exti_line_stats *stats);
+void exti_reset_line_stats(void);
+
 END_DECLS
 /**@}*/
 
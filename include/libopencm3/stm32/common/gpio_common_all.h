@@ -40,6 +40,10 @@ specific memorymap.h header before including this header file.*/
 
 /* --- Convenience macros -------------------------------------------------- */
 
+/** BSRR word setting the pins in mask to data, leaving the others alone */
+#define GPIO_BSRR_MASKED(mask, data)	((((mask) & ~(data)) << 16) | \
+					 ((mask) & (data)))
+
 /* --- GPIO_LCKR values ---------------------------------------------------- */
 
 #define GPIO_LCKK			(1 << 16)
@@ -69,15 +73,38 @@ specific memorymap.h header before including this header file.*/
 #define GPIO_ALL			0xffff
 /**@}*/
 
+/** Parallel bus on pins of one port, bus bits in any pin order.  The
+ * tables map each nibble of a bus value to its pins, built by
+ * gpio_bus_init().
+ */
+struct gpio_bus {
+	uint32_t port;
+	uint16_t mask;		/**< all bus pins */
+	uint8_t width;		/**< 1 to 16 bits */
+	uint8_t pins[16];	/**< pin number of each bus bit */
+	uint16_t map[4][16];
+};
+
 BEGIN_DECLS
 
+#ifndef CM3_INLINE_ACCESSORS
 void gpio_set(uint32_t gpioport, uint16_t gpios);
 void gpio_clear(uint32_t gpioport, uint16_t gpios);
+#endif
 uint16_t gpio_get(uint32_t gpioport, uint16_t gpios);
 void gpio_toggle(uint32_t gpioport, uint16_t gpios);
 uint16_t gpio_port_read(uint32_t gpioport);
 void gpio_port_write(uint32_t gpioport, uint16_t data);
 void gpio_port_config_lock(uint32_t gpioport, uint16_t gpios);
+void gpio_port_write_masked(uint32_t gpioport, uint16_t gpios, uint16_t data);
+
+void gpio_bus_init(struct gpio_bus *bus, uint32_t gpioport,
+		   const uint8_t *pins, uint8_t width);
+uint32_t gpio_bus_bsrr(const struct gpio_bus *bus, uint16_t value);
+void gpio_bus_write(const struct gpio_bus *bus, uint16_t value);
+uint16_t gpio_bus_read(const struct gpio_bus *bus);
+void gpio_bus_encode(const struct gpio_bus *bus, const void *values,
+		     uint32_t *bsrr, uint32_t count);
 
 END_DECLS
 
@@ -124,6 +124,27 @@ specific memorymap.h header before including this header file.*/
 #define GPIOJ_AFRH			GPIO_AFRH(GPIOJ)
 #define GPIOK_AFRH			GPIO_AFRH(GPIOK)
 
+/* --- Timer paced bus output ---------------------------------------------- */
+
+/** DMA target of gpio_bus_dma_start() */
+enum gpio_bus_target {
+	GPIO_BUS_BSRR,		/**< 32 bit words from gpio_bus_encode() */
+	GPIO_BUS_ODR,		/**< 16 bit port values, whole port */
+};
+
+BEGIN_DECLS
+
+void gpio_bus_dma_start(const struct gpio_bus *bus, enum gpio_bus_target target,
+			const void *data, uint16_t count, bool circular,
+			uint32_t dma, uint8_t stream, uint32_t channel);
+void gpio_bus_dma_stop(uint32_t dma, uint8_t stream);
+bool gpio_bus_dma_busy(uint32_t dma, uint8_t stream);
+void gpio_bus_timer_start(uint32_t timer, uint32_t prescaler,
+			  uint32_t period);
+void gpio_bus_timer_stop(uint32_t timer);
+
+END_DECLS
+
 /**@}*/
 #endif
 /** @cond */
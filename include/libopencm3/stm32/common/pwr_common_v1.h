@@ -100,6 +100,40 @@ specific memorymap.h header before including this header file.*/
 /** WUF: Wakeup flag */
 #define PWR_CSR_WUF			(1 << 0)
 
+/* --- Idle manager ------------------------------------------------------- */
+
+/** Low power modes of pwr_idle(), from shallow to deep */
+enum pwr_idle_mode {
+	PWR_IDLE_SLEEP,
+	PWR_IDLE_STOP,		/**< Stop, main regulator on */
+	PWR_IDLE_STOP_LP,	/**< Stop, low power regulator */
+	PWR_IDLE_STANDBY,	/**< wakes up through reset */
+	PWR_IDLE_MODES,
+};
+
+/** @defgroup pwr_idle_needs What a constraint needs while idle
+@{*/
+/** Bus and peripheral clocks, limits idle to Sleep */
+#define PWR_IDLE_NEED_CLOCKS		(1 << 0)
+/** Main regulator, for fast wake up or peripherals running in Stop */
+#define PWR_IDLE_NEED_REGULATOR		(1 << 1)
+/**@}*/
+
+/** Limit registered by a driver with pwr_idle_add_constraint() */
+struct pwr_idle_constraint {
+	uint32_t max_latency_us;	/**< longest wake up, 0 for any */
+	uint32_t needs;			/**< @ref pwr_idle_needs */
+	struct pwr_idle_constraint *next;
+};
+
+/** Counters of one mode */
+struct pwr_idle_stats {
+	uint32_t entries;
+	uint64_t residency_us;		/**< only with pwr_idle_set_clock() */
+	uint32_t last_restore_cycles;	/**< wake up to clocks restored */
+	uint32_t max_restore_cycles;
+};
+
 /* --- PWR function prototypes ------------------------------------------- */
 
 BEGIN_DECLS
@@ -120,6 +154,16 @@ bool pwr_voltage_high(void);
 bool pwr_get_standby_flag(void);
 bool pwr_get_wakeup_flag(void);
 
+void pwr_idle_add_constraint(struct pwr_idle_constraint *constraint);
+void pwr_idle_remove_constraint(struct pwr_idle_constraint *constraint);
+void pwr_idle_set_latency(enum pwr_idle_mode mode, uint32_t latency_us);
+void pwr_idle_set_deepest(enum pwr_idle_mode mode);
+void pwr_idle_set_clock(uint32_t (*now_us)(void));
+enum pwr_idle_mode pwr_idle_select(uint32_t idle_us);
+enum pwr_idle_mode pwr_idle(uint32_t idle_us);
+void pwr_idle_get_stats(enum pwr_idle_mode mode, struct pwr_idle_stats *stats);
+void pwr_idle_reset_stats(void);
+
 END_DECLS
 
 /**@}*/
@@ -36,6 +36,22 @@
 
 /**@{*/
 
+/* Defined by the families with rcc_dvfs_set_level() */
+struct rcc_dvfs_level;
+
+enum rcc_dvfs_event {
+	RCC_DVFS_PRE_CHANGE,	/**< old clocks still running */
+	RCC_DVFS_POST_CHANGE,	/**< rcc_*_frequency are the new ones */
+};
+
+/** Frequency change listener, see rcc_dvfs_add_notifier() */
+struct rcc_dvfs_notifier {
+	void (*callback)(enum rcc_dvfs_event event,
+			 const struct rcc_dvfs_level *level, void *arg);
+	void *arg;
+	struct rcc_dvfs_notifier *next;
+};
+
 BEGIN_DECLS
 
 void rcc_peripheral_enable_clock(volatile uint32_t *reg, uint32_t en);
@@ -67,6 +83,11 @@ bool rcc_is_osc_ready(enum rcc_osc osc);
  */
 void rcc_wait_for_osc_ready(enum rcc_osc osc);
 
+void rcc_dvfs_add_notifier(struct rcc_dvfs_notifier *notifier);
+void rcc_dvfs_remove_notifier(struct rcc_dvfs_notifier *notifier);
+void rcc_dvfs_notify(enum rcc_dvfs_event event,
+		     const struct rcc_dvfs_level *level);
+
 END_DECLS
 /**@}*/
 
@@ -348,9 +348,29 @@ void spi_reset(uint32_t spi_peripheral);
 void spi_enable(uint32_t spi);
 void spi_disable(uint32_t spi);
 uint16_t spi_clean_disable(uint32_t spi);
+#ifdef CM3_INLINE_ACCESSORS
+/* Inlined versions of the data register accessors, see spi_common_all.c */
+static inline void spi_write(uint32_t spi, uint16_t data)
+{
+	SPI_DR(spi) = data;
+}
+
+static inline void spi_send(uint32_t spi, uint16_t data)
+{
+	while (!(SPI_SR(spi) & SPI_SR_TXE));
+	SPI_DR(spi) = data;
+}
+
+static inline uint16_t spi_read(uint32_t spi)
+{
+	while (!(SPI_SR(spi) & SPI_SR_RXNE));
+	return SPI_DR(spi);
+}
+#else
 void spi_write(uint32_t spi, uint16_t data);
 void spi_send(uint32_t spi, uint16_t data);
 uint16_t spi_read(uint32_t spi);
+#endif
 uint16_t spi_xfer(uint32_t spi, uint16_t data);
 void spi_set_bidirectional_mode(uint32_t spi);
 void spi_set_unidirectional_mode(uint32_t spi);
@@ -106,8 +106,10 @@ void usart_set_mode(uint32_t usart, uint32_t mode);
 void usart_set_flow_control(uint32_t usart, uint32_t flowcontrol);
 void usart_enable(uint32_t usart);
 void usart_disable(uint32_t usart);
+#ifndef CM3_INLINE_ACCESSORS
 void usart_send(uint32_t usart, uint16_t data);
 uint16_t usart_recv(uint32_t usart);
+#endif
 void usart_wait_send_ready(uint32_t usart);
 void usart_wait_recv_ready(uint32_t usart);
 void usart_send_blocking(uint32_t usart, uint16_t data);
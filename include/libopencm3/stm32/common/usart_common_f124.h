@@ -300,6 +300,19 @@ specific memorymap.h header before including this header file.*/
 
 /* TODO */ /* Note to Uwe: what needs to be done here? */
 
+#ifdef CM3_INLINE_ACCESSORS
+/* Inlined versions of the data register accessors, see usart_common_f124.c */
+static inline void usart_send(uint32_t usart, uint16_t data)
+{
+	USART_DR(usart) = (data & USART_DR_MASK);
+}
+
+static inline uint16_t usart_recv(uint32_t usart)
+{
+	return USART_DR(usart) & USART_DR_MASK;
+}
+#endif
+
 #endif
 /** @cond */
 #else
@@ -630,4 +630,17 @@ void usart_disable_rx_timeout(uint32_t usart);
 void usart_enable_rx_timeout_interrupt(uint32_t usart);
 void usart_disable_rx_timeout_interrupt(uint32_t usart);
 
+#ifdef CM3_INLINE_ACCESSORS
+/* Inlined versions of the data register accessors, see usart_common_v2.c */
+static inline void usart_send(uint32_t usart, uint16_t data)
+{
+	USART_TDR(usart) = (data & USART_TDR_MASK);
+}
+
+static inline uint16_t usart_recv(uint32_t usart)
+{
+	return USART_RDR(usart) & USART_RDR_MASK;
+}
+#endif
+
 END_DECLS
@@ -143,16 +143,65 @@
 #define TSC_IOGCSR_GxE(x)		(1 << ((x)-1))
 #define TSC_IOGCSR_GxS(x)		(1 << ((x)+15))
 
+/* TSC_IOGxCR Values --------------------------------------------------------*/
+
+#define TSC_IOGxCR_CNT_MASK		0x3FFF
+
 /*****************************************************************************/
 /* API definitions                                                           */
 /*****************************************************************************/
 
+/** Acquisition steps at most, one channel of every group per step */
+#define TSC_MAX_STEPS			4
+
+/** Touch key on one channel, see tsc_keypad_init() */
+struct tsc_key {
+	uint8_t group;		/**< 1 to 8 */
+	uint8_t io;		/**< 1 to 4 */
+	uint16_t threshold;	/**< count drop for a touch */
+	uint16_t hysteresis;	/**< release below threshold - hysteresis */
+
+	uint16_t count;		/**< last acquisition */
+	uint16_t baseline;	/**< untouched count */
+	uint32_t baseline_acc;
+	uint8_t step;
+	uint8_t debounce;
+	bool touched;
+};
+
+/** Keys scanned together, see tsc_keypad_init() */
+struct tsc_keypad {
+	struct tsc_key *keys;
+	uint8_t nkeys;
+	uint32_t config;	/**< TSC_CR timing, prescaler and max count */
+	uint32_t sampling;	/**< TSC_IOSCR sampling capacitor IOs */
+	uint8_t debounce;	/**< acquisitions in a row to change state */
+	uint8_t baseline_shift;	/**< baseline follows 1 / 2^shift per scan */
+	bool continuous;	/**< start the next scan at once */
+	void (*callback)(struct tsc_key *key, bool touched, void *arg);
+	void *arg;
+
+	uint32_t step_channels[TSC_MAX_STEPS];
+	uint32_t step_groups[TSC_MAX_STEPS];
+	uint8_t steps;
+	uint8_t step;
+	volatile bool busy;
+	uint32_t scans;		/**< scans completed */
+	uint32_t errors;	/**< acquisitions beyond max count */
+};
+
 /*****************************************************************************/
 /* API Functions                                                             */
 /*****************************************************************************/
 
 BEGIN_DECLS
 
+bool tsc_keypad_init(struct tsc_keypad *pad);
+void tsc_keypad_start(struct tsc_keypad *pad);
+void tsc_keypad_stop(struct tsc_keypad *pad);
+bool tsc_keypad_scan(struct tsc_keypad *pad);
+void tsc_handle_interrupt(struct tsc_keypad *pad);
+
 END_DECLS
 /**@}*/
 
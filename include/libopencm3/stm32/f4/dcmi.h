@@ -62,12 +62,30 @@
 #define DCMI_CR_CROP			(1 << 2)
 #define DCMI_CR_CM			(1 << 1)
 #define DCMI_CR_CAPTURE			(1 << 0)
+
+#define DCMI_CR_EDM_8BIT		0
+#define DCMI_CR_EDM_10BIT		DCMI_CR_EDM0
+#define DCMI_CR_EDM_12BIT		DCMI_CR_EDM1
+#define DCMI_CR_EDM_14BIT		(DCMI_CR_EDM1 | DCMI_CR_EDM0)
+
+#define DCMI_CR_FCRC_ALL		0
+#define DCMI_CR_FCRC_HALF		DCMI_CR_FCRC0
+#define DCMI_CR_FCRC_QUARTER		DCMI_CR_FCRC1
 /**@}*/
 
 /**
  * DCMI status register
  */
 #define DCMI_SR				MMIO32(DCMI_BASE + 0x04U)
+/**
+ * @defgroup dcmi_sr_values DCMI_SR Values
+ * @ingroup dcmi_defines
+ * @{
+ */
+#define DCMI_SR_FNE			(1 << 2)
+#define DCMI_SR_VSYNC			(1 << 1)
+#define DCMI_SR_HSYNC			(1 << 0)
+/**@}*/
 
 /**
  * DCMI raw interrupt status register
@@ -226,4 +244,54 @@
  */
 #define DCMI_DR				MMIO32(DCMI_BASE + 0x28U)
 
+/**
+ * DMA2 stream 1 or stream 7, channel 1 serves the DCMI
+ */
+#define DCMI_DMA			DMA2
+#define DCMI_DMA_STREAM			DMA_STREAM1
+#define DCMI_DMA_CHANNEL		DMA_SxCR_CHSEL_1
+
+/** Most frame buffers a capture can cycle through */
+#define DCMI_FRAMES_MAX			4
+
+/** A captured frame, timestamps are DWT cycle counter values */
+struct dcmi_frame {
+	void *buf;
+	uint32_t length;	/**< bytes, less than the buffer in JPEG mode */
+	uint32_t sequence;	/**< frames captured since the start */
+	uint32_t start;		/**< vertical sync before the frame */
+	uint32_t end;		/**< frame end */
+	uint16_t lines;		/**< only counted with a line callback */
+	uint8_t index;		/**< buffer index */
+};
+
+struct dcmi_stats {
+	uint32_t frames;
+	uint32_t overruns;	/**< frames lost to DCMI FIFO overruns */
+	uint32_t sync_errors;	/**< embedded synchronisation errors */
+	uint32_t dma_errors;
+	uint32_t oversize;	/**< JPEG frames longer than a buffer, dropped */
+};
+
+BEGIN_DECLS
+
+void dcmi_init(uint32_t flags);
+void dcmi_set_embedded_sync(uint8_t frame_start, uint8_t line_start,
+			    uint8_t line_end, uint8_t frame_end);
+void dcmi_set_crop(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+void dcmi_disable_crop(void);
+bool dcmi_capture_start(void *const *frames, uint8_t count,
+			uint32_t frame_bytes, bool snapshot, uint32_t dma,
+			uint8_t stream, uint32_t channel);
+void dcmi_capture_stop(void);
+bool dcmi_capture_running(void);
+void dcmi_set_frame_callback(void (*callback)(const struct dcmi_frame *));
+void dcmi_set_line_callback(void (*callback)(uint16_t line));
+bool dcmi_get_frame(struct dcmi_frame *frame);
+void dcmi_get_stats(struct dcmi_stats *stats);
+void dcmi_irq(void);
+void dcmi_dma_irq(void);
+
+END_DECLS
+
 /**@}*/
@@ -33,7 +33,7 @@
  */
 
 #include <libopencm3/stm32/memorymap.h>
-#include <stdint.h>
+#include <libopencm3/cm3/common.h>
 
 #ifndef DMA2D_H
 #define DMA2D_H
@@ -141,11 +141,12 @@
 /** DMA2D Output PFC Control Register */
 #define DMA2D_OPFCCR			MMIO32(DMA2D_BASE + 0x34U)
 #define DMA2D_OPFCCR_CM_SHIFT		0
-#define DMA2D_OPFCCR_CM_MASK		0x3
+#define DMA2D_OPFCCR_CM_MASK		0x7
 #define DMA2D_OPFCCR_CM_ARGB8888	0
 #define DMA2D_OPFCCR_CM_RGB888		1
 #define DMA2D_OPFCCR_CM_RGB565		2
-#define DMA2D_OPFCCR_CM_ARGB4444	3
+#define DMA2D_OPFCCR_CM_ARGB1555	3
+#define DMA2D_OPFCCR_CM_ARGB4444	4
 
 /** DMA2D Output Color Register */
 /* The format of this register depends on PFC control above */
@@ -183,5 +184,56 @@
 /** DMA2D Background Color Lookup table */
 #define DMA2D_BG_CLUT			(uint32_t *)(DMA2D_BASE + 0x800U)
 
+/* --- Function prototypes ------------------------------------------------- */
+
+/** Operations waiting in the queue, at most */
+#define DMA2D_QUEUE_LEN			16
+
+/** Pixel formats, the DMA2D_xPFCCR_CM values. Only the first five can be
+ * written by the DMA2D. */
+enum dma2d_format {
+	DMA2D_ARGB8888	= DMA2D_xPFCCR_CM_ARGB8888,
+	DMA2D_RGB888	= DMA2D_xPFCCR_CM_RGB888,
+	DMA2D_RGB565	= DMA2D_xPFCCR_CM_RGB565,
+	DMA2D_ARGB1555	= DMA2D_xPFCCR_CM_ARGB1555,
+	DMA2D_ARGB4444	= DMA2D_xPFCCR_CM_ARGB4444,
+	DMA2D_L8	= DMA2D_xPFCCR_CM_L8,
+	DMA2D_AL44	= DMA2D_xPFCCR_CM_AL44,
+	DMA2D_AL88	= DMA2D_xPFCCR_CM_AL88,
+	DMA2D_L4	= DMA2D_xPFCCR_CM_L4,
+	DMA2D_A8	= DMA2D_xPFCCR_CM_A8,
+	DMA2D_A4	= DMA2D_xPFCCR_CM_A4,
+};
+
+/** A framebuffer or bitmap in memory */
+struct dma2d_surface {
+	uint32_t addr;		/**< Address of the top left pixel */
+	uint16_t pitch;		/**< Pixels from one line to the next */
+	uint8_t format;		/**< enum dma2d_format */
+	/** RGB888 color of the pixels of an A8 or A4 surface */
+	uint32_t color;
+};
+
+BEGIN_DECLS
+
+void dma2d_init(void);
+bool dma2d_fill(const struct dma2d_surface *dst, uint16_t x, uint16_t y,
+		uint16_t w, uint16_t h, uint32_t color);
+bool dma2d_copy(const struct dma2d_surface *dst, uint16_t dx, uint16_t dy,
+		const struct dma2d_surface *src, uint16_t sx, uint16_t sy,
+		uint16_t w, uint16_t h);
+bool dma2d_blend(const struct dma2d_surface *dst, uint16_t dx, uint16_t dy,
+		 const struct dma2d_surface *fg, uint16_t fx, uint16_t fy,
+		 uint16_t w, uint16_t h, uint8_t alpha);
+bool dma2d_load_clut(bool background, const uint32_t *clut,
+		     uint16_t entries, bool rgb888);
+bool dma2d_idle(void);
+void dma2d_wait(void);
+void dma2d_abort(void);
+uint32_t dma2d_get_errors(void);
+void dma2d_irq(void);
+
+END_DECLS
+
 /**@}*/
 #endif
@@ -246,4 +246,48 @@ enum fmc_sdram_command { SDRAM_CLK_CONF, SDRAM_NORMAL, SDRAM_PALL,
 uint32_t sdram_timing(struct sdram_timing *t);
 void sdram_command(enum fmc_sdram_bank bank, enum fmc_sdram_command cmd,
 			int autorefresh, int modereg);
+
+/*
+ * SDRAM part description for sdram_init(), timings as in the data sheet.
+ * The clock counts are derived from the SDRAM clock when it is set up.
+ */
+struct sdram_device {
+	uint8_t columns;	/* address bits, 8 to 11 */
+	uint8_t rows;		/* address bits, 11 to 13 */
+	uint8_t width;		/* data bus, 8, 16 or 32 bits */
+	uint8_t banks;		/* internal banks, 2 or 4 */
+	uint8_t cas;		/* CAS latency in clocks, 1 to 3 */
+	uint8_t tmrd;		/* load mode register to active, clocks */
+	uint16_t trcd_ns;	/* active to read/write */
+	uint16_t trp_ns;	/* precharge */
+	uint16_t twr_ns;	/* write recovery */
+	uint16_t trc_ns;	/* row cycle */
+	uint16_t tras_ns;	/* minimum self refresh, tRAS */
+	uint16_t txsr_ns;	/* exit self refresh */
+	uint16_t refresh_ms;	/* every row refreshed once in, usually 64 */
+};
+
+/* Bump allocator over an SDRAM region, see sdram_arena_init() */
+struct sdram_arena {
+	uint32_t start;
+	uint32_t top;
+	uint32_t end;
+};
+
+void sdram_timing_from_ns(struct sdram_timing *t,
+			  const struct sdram_device *dev, uint32_t sdclk_hz);
+uint32_t sdram_refresh_count(const struct sdram_device *dev,
+			     uint32_t sdclk_hz);
+uint32_t sdram_bank_address(enum fmc_sdram_bank bank);
+uint32_t sdram_size(const struct sdram_device *dev);
+bool sdram_init(enum fmc_sdram_bank bank, const struct sdram_device *dev,
+		uint32_t hclk_hz, uint32_t sdclk_div);
+void sdram_clear_section(void);
+
+void sdram_arena_init(struct sdram_arena *arena, void *start, uint32_t size);
+void *sdram_arena_alloc(struct sdram_arena *arena, uint32_t size,
+			uint32_t align);
+uint32_t sdram_arena_available(const struct sdram_arena *arena);
+uint32_t sdram_arena_mark(const struct sdram_arena *arena);
+void sdram_arena_release(struct sdram_arena *arena, uint32_t mark);
 #endif
@@ -482,6 +482,29 @@ void ltdc_setup_windowing(
 		uint16_t active_width,  uint16_t active_height
 );
 
+/**
+ * framebuffer flipping on vertical blanking, see ltdc.c
+ */
+#define LTDC_FB_MAX 3
+
+struct ltdc_fb_stats {
+	uint32_t frames;	/* refreshes, counted on the line event */
+	uint32_t flips;		/* buffers presented, both layers count */
+	uint32_t dropped;	/* refreshes missed against the interval */
+	uint16_t last_interval;	/* refreshes between the last two flips */
+	uint16_t max_interval;
+};
+
+void ltdc_fb_init(uint8_t layer, const uint32_t *buffers, uint8_t count);
+uint32_t ltdc_fb_get_back(uint8_t layer);
+uint32_t ltdc_fb_get_front(uint8_t layer);
+bool ltdc_fb_flip(uint8_t layer);
+bool ltdc_fb_flip_pending(uint8_t layer);
+void ltdc_fb_set_line_callback(uint16_t line, void (*callback)(void));
+void ltdc_fb_stats_reset(uint8_t interval);
+void ltdc_fb_get_stats(struct ltdc_fb_stats *stats);
+void ltdc_fb_irq(void);
+
 
 
 /**
@@ -43,10 +43,21 @@ LGPL License Terms @ref lgpl_license
 
 /* --- PWR_CR values ------------------------------------------------------- */
 
-/* Bits [31:15]: Reserved */
+/* Bits [31:18]: Reserved */
 
-/* VOS: Regulator voltage scaling output selection */
+/* ODSWEN: Over-drive switching enabled (F42x, F43x, F446, F469, F479) */
+#define PWR_CR_ODSWEN			(1 << 17)
+
+/* ODEN: Over-drive enable (F42x, F43x, F446, F469, F479) */
+#define PWR_CR_ODEN			(1 << 16)
+
+/* VOS: Regulator voltage scaling output selection, bit 15 not on F40x */
 #define PWR_CR_VOS			(1 << 14)
+#define PWR_CR_VOS_SHIFT		14
+#define PWR_CR_VOS_MASK			0x3
+#define PWR_CR_VOS_SCALE_3		0x1
+#define PWR_CR_VOS_SCALE_2		0x2
+#define PWR_CR_VOS_SCALE_1		0x3
 
 /* Bits [13:10]: Reserved */
 
@@ -55,7 +66,13 @@ LGPL License Terms @ref lgpl_license
 
 /* --- PWR_CSR values ------------------------------------------------------ */
 
-/* Bits [31:15]: Reserved */
+/* Bits [31:18]: Reserved */
+
+/* ODSWRDY: Over-drive mode switching ready */
+#define PWR_CSR_ODSWRDY			(1 << 17)
+
+/* ODRDY: Over-drive mode ready */
+#define PWR_CSR_ODRDY			(1 << 16)
 
 /* VOSRDY: Regulator voltage scaling output selection ready bit */
 #define PWR_CSR_VOSRDY			(1 << 14)
@@ -75,11 +92,14 @@ LGPL License Terms @ref lgpl_license
 enum pwr_vos_scale {
 	PWR_SCALE1,
 	PWR_SCALE2,
+	PWR_SCALE3,		/* not on F40x */
 };
 
 BEGIN_DECLS
 
 void pwr_set_vos_scale(enum pwr_vos_scale scale);
+void pwr_enable_overdrive(void);
+void pwr_disable_overdrive(void);
 
 END_DECLS
 
@@ -1066,6 +1066,39 @@ enum rcc_periph_rst {
 
 #include <libopencm3/stm32/common/rcc_common_all.h>
 
+/** Performance level for rcc_dvfs_set_level() */
+struct rcc_dvfs_level {
+	uint8_t sysclk;		/**< RCC_CFGR_SW_HSI, _HSE or _PLL */
+	bool pll_hse;		/**< PLL input HSE, else HSI */
+	uint8_t pllm;
+	uint16_t plln;
+	uint8_t pllp;
+	uint8_t pllq;
+	uint8_t pllr;
+	uint8_t hpre;
+	uint8_t ppre1;
+	uint8_t ppre2;
+	uint32_t flash_config;
+	uint8_t vos;		/**< enum pwr_vos_scale */
+	bool overdrive;		/**< above 168MHz, F42x/F43x/F446/F469 */
+	uint32_t ahb_frequency;
+	uint32_t apb1_frequency;
+	uint32_t apb2_frequency;
+};
+
+/** Clock tree snapshot, see rcc_clock_save() */
+struct rcc_clock_state {
+	uint32_t cr;
+	uint32_t cfgr;
+	uint32_t pllcfgr;
+	uint32_t plli2scfgr;
+	uint32_t pllsaicfgr;
+	uint32_t flash_ws;
+	uint32_t ahb_frequency;
+	uint32_t apb1_frequency;
+	uint32_t apb2_frequency;
+};
+
 BEGIN_DECLS
 
 void rcc_osc_ready_int_clear(enum rcc_osc osc);
@@ -1093,6 +1126,12 @@ void rcc_set_main_pll_hse(uint32_t pllm, uint32_t plln, uint32_t pllp,
 			  uint32_t pllq, uint32_t pllr);
 uint32_t rcc_system_clock_source(void);
 void rcc_clock_setup_hse_3v3(const struct rcc_clock_scale *clock);
+void rcc_clock_save(struct rcc_clock_state *state);
+void rcc_clock_restore_start(const struct rcc_clock_state *state);
+bool rcc_clock_restore_poll(const struct rcc_clock_state *state);
+void rcc_clock_restore(const struct rcc_clock_state *state);
+void rcc_dvfs_set_level(const struct rcc_dvfs_level *level);
+const struct rcc_dvfs_level *rcc_dvfs_get_level(void);
 
 END_DECLS
 
@@ -143,6 +143,8 @@
 #define QSPI_BASE			(PERIPH_BASE_AHB3 + 0x30000000U)
 #define FMCC_BASE			(PERIPH_BASE_AHB3 + 0x40000000U)
 #define QSPIC_BASE			(PERIPH_BASE_AHB3 + 0x40001000U)
+#define QUADSPI_BANK			QSPI_BASE
+#define QUADSPI_BASE			QSPIC_BASE
 #define FMC5_BASE			(PERIPH_BASE_AHB3 + 0x60000000U)
 #define FMC6_BASE			(PERIPH_BASE_AHB3 + 0x70000000U)
 
@@ -42,3 +42,18 @@
 #       error "stm32 family not defined."
 #endif
 
+/* With CM3_INLINE_ACCESSORS defined, the single store accessors are
+ * inlined instead of being called from the library. They have to be defined
+ * here, after the family header has provided the register layout. */
+#ifdef CM3_INLINE_ACCESSORS
+static inline void gpio_set(uint32_t gpioport, uint16_t gpios)
+{
+	GPIO_BSRR(gpioport) = gpios;
+}
+
+static inline void gpio_clear(uint32_t gpioport, uint16_t gpios)
+{
+	GPIO_BSRR(gpioport) = (gpios << 16);
+}
+#endif
+
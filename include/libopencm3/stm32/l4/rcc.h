@@ -458,6 +458,7 @@ Twelve frequency ranges are available: 100 kHz, 200 kHz, 400 kHz, 800 kHz,
 #define RCC_APB1ENR1_USART2EN			(1 << 17)
 #define RCC_APB1ENR1_SPI3EN			(1 << 15)
 #define RCC_APB1ENR1_SPI2EN			(1 << 14)
+#define RCC_APB1ENR1_WWDGEN			(1 << 11)
 #define RCC_APB1ENR1_LCDEN			(1 << 9)
 #define RCC_APB1ENR1_TIM7EN			(1 << 5)
 #define RCC_APB1ENR1_TIM6EN			(1 << 4)
@@ -769,6 +770,7 @@ enum rcc_periph_clken {
 	RCC_USART2 = _REG_BIT(RCC_APB1ENR1_OFFSET, 17),
 	RCC_SPI3 = _REG_BIT(RCC_APB1ENR1_OFFSET, 15),
 	RCC_SPI2 = _REG_BIT(RCC_APB1ENR1_OFFSET, 14),
+	RCC_WWDG = _REG_BIT(RCC_APB1ENR1_OFFSET, 11),
 	RCC_LCD = _REG_BIT(RCC_APB1ENR1_OFFSET, 9),
 	RCC_TIM7 = _REG_BIT(RCC_APB1ENR1_OFFSET, 5),
 	RCC_TIM6 = _REG_BIT(RCC_APB1ENR1_OFFSET, 4),
@@ -940,6 +942,39 @@ enum rcc_periph_rst {
 };
 #include <libopencm3/stm32/common/rcc_common_all.h>
 
+/** Clock tree snapshot, see rcc_clock_save() */
+struct rcc_clock_state {
+	uint32_t cr;
+	uint32_t cfgr;
+	uint32_t pllcfgr;
+	uint32_t pllsai1cfgr;
+	uint32_t pllsai2cfgr;
+	uint32_t flash_ws;
+	uint32_t ahb_frequency;
+	uint32_t apb1_frequency;
+	uint32_t apb2_frequency;
+};
+
+/** Performance level for rcc_dvfs_set_level() */
+struct rcc_dvfs_level {
+	uint8_t sysclk;		/**< RCC_CFGR_SW_xxx */
+	uint8_t msi_range;	/**< @ref rcc_cr_msirange, if MSI is used */
+	uint8_t pllsrc;		/**< RCC_PLLCFGR_PLLSRC_xxx */
+	uint8_t pllm;
+	uint16_t plln;
+	uint8_t pllp;
+	uint8_t pllq;
+	uint8_t pllr;
+	uint8_t hpre;
+	uint8_t ppre1;
+	uint8_t ppre2;
+	uint8_t flash_waitstates;
+	uint8_t vos;		/**< enum pwr_vos_scale */
+	uint32_t ahb_frequency;
+	uint32_t apb1_frequency;
+	uint32_t apb2_frequency;
+};
+
 BEGIN_DECLS
 
 void rcc_osc_ready_int_clear(enum rcc_osc osc);
@@ -962,6 +997,13 @@ void rcc_set_main_pll(uint32_t source, uint32_t pllm, uint32_t plln, uint32_t pl
 uint32_t rcc_system_clock_source(void);
 void rcc_set_msi_range(uint32_t msi_range);
 void rcc_set_msi_range_standby(uint32_t msi_range);
+void rcc_set_stop_wakeup_clock(uint32_t stopwuck);
+void rcc_clock_save(struct rcc_clock_state *state);
+void rcc_clock_restore_start(const struct rcc_clock_state *state);
+bool rcc_clock_restore_poll(const struct rcc_clock_state *state);
+void rcc_clock_restore(const struct rcc_clock_state *state);
+void rcc_dvfs_set_level(const struct rcc_dvfs_level *level);
+const struct rcc_dvfs_level *rcc_dvfs_get_level(void);
 
 END_DECLS
 
@@ -22,6 +22,8 @@
 
 #if defined(STM32F4)
 #       include <libopencm3/stm32/f4/quadspi.h>
+#elif defined(STM32F7)
+#       include <libopencm3/stm32/f7/quadspi.h>
 #else
 #       error "quadspi.h not available for this family."
 #endif
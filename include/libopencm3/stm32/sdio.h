@@ -436,10 +436,56 @@
 #define SDIO_FIFOCNT_FIFOCOUNT_MASK	0xFFFFFF
 
 
-/* --- Function prototypes ------------------------------------------------- */
-
-
-/* TODO */
+/* --- SD card driver ------------------------------------------------------ */
 
+/* The driver (F2, F4 and F7) moves data with a DMA2 stream under SDIO flow
+ * control.  The SDIO request is on channel 4 of stream 3 or stream 6.
+ */
+#define SDIO_DMA			DMA2
+#define SDIO_DMA_STREAM			DMA_STREAM3
+#define SDIO_DMA_CHANNEL		DMA_SxCR_CHSEL_4
+
+#define SDIO_BLOCK_SIZE			512
+
+enum sdio_status {
+	SDIO_OK = 0,
+	SDIO_ETIMEOUT,		/**< no response, or data timeout */
+	SDIO_ECRC,		/**< command or data CRC error */
+	SDIO_ECARD,		/**< the card reported an error */
+	SDIO_EUNSUPPORTED,	/**< not an SD memory card we can drive */
+	SDIO_EDATA,		/**< FIFO or DMA error */
+};
+
+/** One SD memory card.  dma, dma_stream and dma_channel are filled in by the
+ * caller, usually with SDIO_DMA, SDIO_DMA_STREAM and SDIO_DMA_CHANNEL,
+ * everything else by sdio_card_init().
+ */
+struct sdio_card {
+	uint32_t dma;
+	uint8_t dma_stream;
+	uint32_t dma_channel;
+
+	uint32_t rca;			/**< relative card address << 16 */
+	uint32_t cid[4];
+	uint32_t csd[4];
+	uint32_t block_count;		/**< capacity in SDIO_BLOCK_SIZE */
+	uint32_t clock_hz;		/**< bus clock after init */
+	bool high_capacity;		/**< SDHC/SDXC, block addressed */
+	bool high_speed;		/**< running in high speed mode */
+};
+
+BEGIN_DECLS
+
+enum sdio_status sdio_card_init(struct sdio_card *card, uint32_t sdioclk_hz,
+				bool hw_flow_control);
+enum sdio_status sdio_read_blocks(struct sdio_card *card, uint32_t lba,
+				  void *buf, uint32_t count);
+enum sdio_status sdio_write_blocks(struct sdio_card *card, uint32_t lba,
+				   const void *buf, uint32_t count);
+enum sdio_status sdio_card_status(struct sdio_card *card, uint32_t *status);
+int sdio_read_block(uint32_t lba, uint8_t *copy_to);
+int sdio_write_block(uint32_t lba, const uint8_t *copy_from);
+
+END_DECLS
 
 #endif
@@ -76,8 +76,50 @@
 /* EWIF: Early wakeup interrupt flag */
 #define WWDG_SR_EWIF			(1 << 0)
 
+/* --- WWDG supervisor ---------------------------------------------------- */
+
+/** Counter value of the early wakeup interrupt */
+#define WWDG_CR_T_EWI			0x40
+#define WWDG_CR_T_MAX			0x7f
+
+/** wwdg_dump::magic of a valid dump */
+#define WWDG_DUMP_MAGIC			0x57574447
+
+/** Supervised task, see wwdg_supervisor_add_task() */
+struct wwdg_task {
+	const char *name;
+	uint8_t deadline;	/**< supervisor periods between check-ins, >= 1 */
+	volatile uint8_t missed;	/**< periods since the last check-in */
+	uint8_t max_missed;
+	struct wwdg_task *next;
+};
+
+/** What the early wakeup interrupt saw before the reset */
+struct wwdg_dump {
+	uint32_t magic;		/**< WWDG_DUMP_MAGIC if the supervisor reset */
+	const char *task;	/**< name of the first stalled task */
+	uint8_t missed;		/**< its periods without check-in */
+	uint8_t stalled;	/**< tasks stalled */
+	uint32_t periods;	/**< supervisor periods since start */
+};
+
 /* --- WWDG function prototypes---------------------------------------------- */
 
-/* TODO */
+BEGIN_DECLS
+
+void wwdg_start(uint8_t timebase, uint8_t window, uint8_t counter);
+void wwdg_reset(uint8_t counter);
+uint8_t wwdg_get_counter(void);
+void wwdg_enable_early_wakeup(void);
+void wwdg_clear_early_wakeup_flag(void);
+
+bool wwdg_supervisor_add_task(struct wwdg_task *task);
+void wwdg_supervisor_remove_task(struct wwdg_task *task);
+void wwdg_task_checkin(struct wwdg_task *task);
+uint32_t wwdg_supervisor_start(uint8_t timebase, struct wwdg_dump *dump,
+			       bool feed_iwdg);
+void wwdg_supervisor_handle_interrupt(void);
+
+END_DECLS
 
 #endif
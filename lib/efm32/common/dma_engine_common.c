@@ -0,0 +1,322 @@
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Transfer engine on top of the PL230 descriptors: owns the control block,
+ * sets up basic, ping-pong and scatter-gather transfers with one call each
+ * and dispatches the done interrupt to per channel callbacks.  Kept apart
+ * from dma_common.c so the control block is only linked in when used.
+ */
+
+#include <stddef.h>
+#include <libopencm3/efm32/dma.h>
+#include <libopencm3/efm32/cmu.h>
+#include <libopencm3/cm3/nvic.h>
+
+/* Primary descriptors at the base, alternates 0x100 further for up to 16
+ * channels, so only DMA_ENGINE_CHANNELS alternates are allocated. */
+#define DMA_ALT_OFFSET		16
+
+static struct dma_chan_desc dma_ctrl_block[DMA_ALT_OFFSET + DMA_ENGINE_CHANNELS]
+	__attribute__((aligned(256)));
+
+static struct {
+	dma_engine_cb cb;
+	void *arg;
+	uint32_t cfg[2];	/* descriptor cfg words to re-arm ping-pong */
+	bool ping_pong;
+	bool active;		/* started, not stopped or done yet */
+	uint8_t next;		/* ping-pong half that completes next */
+} dma_chan[DMA_ENGINE_CHANNELS];
+
+static uint32_t dma_desc_cfg(enum dma_mem size, enum dma_mem src_inc,
+			     enum dma_mem dest_inc, uint16_t count,
+			     enum dma_r_power r_power, enum dma_mode mode)
+{
+	return DMA_DESC_CH_CFG_DEST_INC(dest_inc) |
+	       DMA_DESC_CH_CFG_DEST_SIZE(size) |
+	       DMA_DESC_CH_CFG_SRC_INC(src_inc) |
+	       DMA_DESC_CH_CFG_SRC_SIZE(size) |
+	       DMA_DESC_CH_CFG_R_POWER(r_power) |
+	       DMA_DESC_CH_CFG_N_MINUS_1(count - 1) |
+	       DMA_DESC_CH_CFG_CYCLE_CTRL(mode);
+}
+
+static uint32_t dma_end_address(uint32_t start, enum dma_mem inc,
+				uint16_t count)
+{
+	if (inc == DMA_MEM_NONE) {
+		return start;
+	}
+	return start + ((uint32_t)(count - 1) << inc);
+}
+
+/**
+ * Fill a descriptor in one go.  Used for the engine's own descriptors and
+ * for the task lists of dma_engine_scatter_gather().
+ * @param[out] desc Descriptor
+ * @param[in] src Source start address
+ * @param[in] src_inc Source increment (use DMA_MEM_*)
+ * @param[in] dest Destination start address
+ * @param[in] dest_inc Destination increment (use DMA_MEM_*)
+ * @param[in] size Transfer size on both sides (use DMA_MEM_BYTE/HALF_WORD/WORD)
+ * @param[in] count Number of transfers, 1 to 1024
+ * @param[in] r_power Arbitrate after 2^r_power transfers
+ * @param[in] mode Cycle type (use DMA_MODE_*)
+ */
+void dma_desc_fill(struct dma_chan_desc *desc, uint32_t src,
+		   enum dma_mem src_inc, uint32_t dest, enum dma_mem dest_inc,
+		   enum dma_mem size, uint16_t count, enum dma_r_power r_power,
+		   enum dma_mode mode)
+{
+	desc->src_data_end_ptr = dma_end_address(src, src_inc, count);
+	desc->dst_data_end_ptr = dma_end_address(dest, dest_inc, count);
+	desc->cfg = dma_desc_cfg(size, src_inc, dest_inc, count, r_power,
+				 mode);
+	desc->user_data = 0;
+}
+
+/**
+ * Clock and enable the DMA with the engine's control block, and enable the
+ * DMA interrupt.  dma_engine_irq() must be called from dma_isr().
+ */
+void dma_engine_init(void)
+{
+	cmu_periph_clock_enable(CMU_DMA);
+	dma_set_desc_address((uint32_t)dma_ctrl_block);
+	dma_enable();
+	dma_enable_bus_error_interrupt();
+	nvic_enable_irq(NVIC_DMA_IRQ);
+}
+
+/** Primary descriptor of a channel */
+struct dma_chan_desc *dma_engine_primary(enum dma_ch ch)
+{
+	return &dma_ctrl_block[ch];
+}
+
+/** Alternate descriptor of a channel */
+struct dma_chan_desc *dma_engine_alternate(enum dma_ch ch)
+{
+	return &dma_ctrl_block[DMA_ALT_OFFSET + ch];
+}
+
+static void dma_engine_setup(enum dma_ch ch, uint32_t source, uint32_t signal,
+			     dma_engine_cb cb, void *arg)
+{
+	dma_channel_reset(ch);
+	DMA_CHx_CTRL(ch) = DMA_CH_CTRL_SOURCESEL(source) |
+			   DMA_CH_CTRL_SIGSEL(signal);
+	dma_chan[ch].cb = cb;
+	dma_chan[ch].arg = arg;
+	dma_chan[ch].ping_pong = false;
+	dma_chan[ch].active = true;
+	dma_chan[ch].next = 0;
+	if (source == DMA_CH_CTRL_SOURCESEL_NONE) {
+		dma_disable_periph_request(ch);
+	} else {
+		dma_enable_periph_request(ch);
+	}
+	dma_enable_single_and_burst(ch);
+	dma_enable_done_interrupt(ch);
+}
+
+/**
+ * Single transfer on the primary descriptor.  A memory to memory transfer
+ * (source DMA_CH_CTRL_SOURCESEL_NONE) is started right away, otherwise the
+ * peripheral requests drive it.
+ * @param[in] ch Channel (use DMA_CHx)
+ * @param[in] source Request source (use DMA_CH_CTRL_SOURCESEL_*)
+ * @param[in] signal Request signal (use DMA_CH_CTRL_SIGSEL_*)
+ * @param[in] src Source start address, @a dest destination start address
+ * @param[in] src_inc, dest_inc Increments, DMA_MEM_NONE for a register
+ * @param[in] size Transfer size
+ * @param[in] count Number of transfers, 1 to 1024
+ * @param[in] cb Called from dma_engine_irq() when done, may be NULL
+ */
+void dma_engine_basic(enum dma_ch ch, uint32_t source, uint32_t signal,
+		      uint32_t src, enum dma_mem src_inc,
+		      uint32_t dest, enum dma_mem dest_inc,
+		      enum dma_mem size, uint16_t count,
+		      dma_engine_cb cb, void *arg)
+{
+	bool mem = source == DMA_CH_CTRL_SOURCESEL_NONE;
+
+	dma_engine_setup(ch, source, signal, cb, arg);
+	dma_desc_fill(dma_engine_primary(ch), src, src_inc, dest, dest_inc,
+		      size, count, mem ? DMA_R_POWER_1024 : DMA_R_POWER_1,
+		      mem ? DMA_MODE_AUTO_REQUEST : DMA_MODE_BASIC);
+	dma_enable_channel(ch);
+	if (mem) {
+		dma_generate_software_request(ch);
+	}
+}
+
+/**
+ * Continuous peripheral stream into (or out of) two buffers.  While the DMA
+ * works on one buffer the callback gets the other one, buf 0 or 1, and
+ * the finished half is re-armed as soon as the callback returns, so the
+ * callback has one buffer time to consume (or refill) it.
+ * @param[in] ch Channel (use DMA_CHx)
+ * @param[in] source Request source (use DMA_CH_CTRL_SOURCESEL_*)
+ * @param[in] signal Request signal (use DMA_CH_CTRL_SIGSEL_*)
+ * @param[in] reg Peripheral data register
+ * @param[in] to_periph true to stream out of the buffers to @a reg
+ * @param[in] size Transfer size
+ * @param[in] buf0, buf1 The two buffers, @a count transfers each
+ * @param[in] count Number of transfers per buffer, 1 to 1024
+ * @param[in] cb Called from dma_engine_irq() for each completed buffer,
+ *		  may be NULL
+ */
+void dma_engine_ping_pong(enum dma_ch ch, uint32_t source, uint32_t signal,
+			  uint32_t reg, bool to_periph, enum dma_mem size,
+			  void *buf0, void *buf1, uint16_t count,
+			  dma_engine_cb cb, void *arg)
+{
+	struct dma_chan_desc *desc[2] = {
+		dma_engine_primary(ch), dma_engine_alternate(ch)
+	};
+	void *buf[2] = { buf0, buf1 };
+	int i;
+
+	dma_engine_setup(ch, source, signal, cb, arg);
+	for (i = 0; i < 2; i++) {
+		if (to_periph) {
+			dma_desc_fill(desc[i], (uint32_t)buf[i], size, reg,
+				      DMA_MEM_NONE, size, count,
+				      DMA_R_POWER_1, DMA_MODE_PING_PONG);
+		} else {
+			dma_desc_fill(desc[i], reg, DMA_MEM_NONE,
+				      (uint32_t)buf[i], size, size, count,
+				      DMA_R_POWER_1, DMA_MODE_PING_PONG);
+		}
+		dma_chan[ch].cfg[i] = desc[i]->cfg;
+	}
+	dma_chan[ch].ping_pong = true;
+	dma_enable_channel(ch);
+}
+
+/**
+ * Run a list of tasks, each a descriptor built with dma_desc_fill(), back
+ * to back on one channel.  The primary descriptor copies the tasks one by
+ * one into the alternate descriptor, which runs them.
+ *
+ * Every task but the last must use mode DMA_MODE_MEM_SCAT_GATH_ALT
+ * (@a periph false) or DMA_MODE_PERIPH_SCAT_GATH_ALT (@a periph true).  The
+ * last one uses DMA_MODE_AUTO_REQUEST or DMA_MODE_BASIC respectively.  The
+ * list must stay valid and unchanged until the callback.
+ * @param[in] ch Channel (use DMA_CHx)
+ * @param[in] source, signal Request, DMA_CH_CTRL_SOURCESEL_NONE for memory
+ * @param[in] tasks Task list, word aligned
+ * @param[in] ntasks Number of tasks, 1 to 256
+ * @param[in] periph Peripheral scatter-gather, each task waits for requests
+ * @param[in] cb Called from dma_engine_irq() after the last task
+ */
+void dma_engine_scatter_gather(enum dma_ch ch, uint32_t source,
+			       uint32_t signal,
+			       const struct dma_chan_desc *tasks,
+			       uint16_t ntasks, bool periph,
+			       dma_engine_cb cb, void *arg)
+{
+	struct dma_chan_desc *prim = dma_engine_primary(ch);
+	struct dma_chan_desc *alt = dma_engine_alternate(ch);
+
+	dma_engine_setup(ch, source, signal, cb, arg);
+
+	/* Each task is four words, copied in one arbitration slot */
+	dma_desc_fill(prim, (uint32_t)tasks, DMA_MEM_WORD, (uint32_t)alt,
+		      DMA_MEM_WORD, DMA_MEM_WORD, ntasks * 4, DMA_R_POWER_4,
+		      periph ? DMA_MODE_PERIPH_SCAT_GATH_PRIM :
+			       DMA_MODE_MEM_SCAT_GATH_PRIM);
+	/* The destination end is the last word of the alternate descriptor,
+	 * not of a block the size of the whole list. */
+	prim->dst_data_end_ptr = (uint32_t)&alt->user_data;
+
+	dma_enable_channel(ch);
+	if (!periph) {
+		dma_generate_software_request(ch);
+	}
+}
+
+/** Stop a channel and drop its callback */
+void dma_engine_stop(enum dma_ch ch)
+{
+	dma_disable_channel(ch);
+	dma_disable_done_interrupt(ch);
+	dma_clear_done_interrupt_flag(ch);
+	dma_chan[ch].cb = NULL;
+	dma_chan[ch].active = false;
+}
+
+/**
+ * Done and error interrupt handling, must be called from dma_isr().  On a
+ * bus error every running channel is stopped, and its callback told with
+ * buf DMA_ENGINE_ERROR.
+ */
+void dma_engine_irq(void)
+{
+	uint32_t flags = DMA_IF & DMA_IEN;
+	int ch;
+
+	DMA_IFC = flags;
+
+	for (ch = 0; ch < DMA_ENGINE_CHANNELS; ch++) {
+		dma_engine_cb cb = dma_chan[ch].cb;
+		void *arg = dma_chan[ch].arg;
+
+		if (flags & DMA_IF_ERR) {
+			if (dma_chan[ch].active) {
+				dma_engine_stop(ch);
+				if (cb) {
+					cb(ch, DMA_ENGINE_ERROR, arg);
+				}
+			}
+			continue;
+		}
+		if (!(flags & DMA_IF_CHxDONE(ch))) {
+			continue;
+		}
+
+		if (dma_chan[ch].ping_pong) {
+			int done = dma_chan[ch].next;
+
+			dma_chan[ch].next ^= 1;
+			if (cb) {
+				cb(ch, done, arg);
+			}
+			/* Re-arm unless the callback stopped the stream */
+			if (dma_chan[ch].active) {
+				struct dma_chan_desc *desc = done ?
+					dma_engine_alternate(ch) :
+					dma_engine_primary(ch);
+
+				desc->cfg = dma_chan[ch].cfg[done];
+			}
+		} else {
+			dma_chan[ch].cb = NULL;
+			dma_chan[ch].active = false;
+			dma_disable_done_interrupt(ch);
+			if (cb) {
+				cb(ch, 0, arg);
+			}
+		}
+	}
+
+	if (flags & DMA_IF_ERR) {
+		dma_clear_bus_error_flag();
+	}
+}
@@ -0,0 +1,185 @@
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * PRS event chains: connect producer signals to consumer inputs with the
+ * PRS channels allocated here.  A channel is taken when its SOURCESEL is
+ * not NONE, so channels set up by hand with prs_set_source() are left
+ * alone.  Producers that are routed twice share a channel.
+ */
+
+#include <libopencm3/efm32/prs.h>
+#include <libopencm3/efm32/adc.h>
+#include <libopencm3/efm32/dac.h>
+#include <libopencm3/efm32/timer.h>
+
+static uint32_t prs_chain_ctrl(const struct prs_link *link)
+{
+	return PRS_CH_CTRL_SOURCESEL(link->source) |
+	       PRS_CH_CTRL_SIGSEL(link->signal) |
+	       (link->edge & PRS_CH_CTRL_EDSEL_MASK) |
+	       (link->async ? PRS_CH_CTRL_ASYNC : 0);
+}
+
+static bool prs_chain_valid(const struct prs_link *link)
+{
+	if (link->source == PRS_CH_CTRL_SOURCESEL_NONE) {
+		return false;
+	}
+
+	switch (link->consumer) {
+	case PRS_CONSUMER_ADC_SINGLE:
+	case PRS_CONSUMER_ADC_SCAN:
+		return link->base == ADC0;
+	case PRS_CONSUMER_DAC:
+		return link->base == DAC0 && link->index < 2;
+	case PRS_CONSUMER_TIMER_CC:
+		return (link->base == TIMER0 || link->base == TIMER1 ||
+			link->base == TIMER2 || link->base == TIMER3) &&
+		       link->index < 3;
+	}
+	return false;
+}
+
+/* Channel already carrying the same signal, or a free one, or -1 */
+static int prs_chain_find(uint32_t ctrl, uint16_t taken)
+{
+	int ch;
+	int free_ch = -1;
+
+	for (ch = 0; ch < PRS_CHANNELS; ch++) {
+		uint32_t cur = PRS_CHx_CTRL(ch);
+
+		if ((cur & PRS_CH_CTRL_SOURCESEL_MASK) == 0) {
+			if (free_ch < 0 && !(taken & (1 << ch))) {
+				free_ch = ch;
+			}
+		} else if (cur == ctrl) {
+			return ch;
+		}
+	}
+	return free_ch;
+}
+
+static void prs_chain_consumer(const struct prs_link *link, int ch)
+{
+	switch (link->consumer) {
+	case PRS_CONSUMER_ADC_SINGLE:
+		ADC_SINGLECTRL(link->base) =
+			(ADC_SINGLECTRL(link->base) &
+			 ~ADC_SINGLECTRL_PRSSEL_MASK)
+			| ADC_SINGLECTRL_PRSSEL(ch) | ADC_SINGLECTRL_PRSEN;
+		break;
+	case PRS_CONSUMER_ADC_SCAN:
+		ADC_SCANCTRL(link->base) =
+			(ADC_SCANCTRL(link->base) & ~ADC_SCANCTRL_PRSSEL_MASK)
+			| ADC_SCANCTRL_PRSSEL(ch) | ADC_SCANCTRL_PRSEN;
+		break;
+	case PRS_CONSUMER_DAC:
+		DAC_CHx_CTRL(link->base, link->index) =
+			(DAC_CHx_CTRL(link->base, link->index) &
+			 ~DAC_CH_CTRL_PRSSEL_MASK)
+			| DAC_CH_CTRL_PRSSEL(ch) | DAC_CH_CTRL_PRSEN;
+		break;
+	case PRS_CONSUMER_TIMER_CC:
+		TIMER_CCx_CTRL(link->base, link->index) =
+			(TIMER_CCx_CTRL(link->base, link->index) &
+			 ~(TIMER_CC_CTRL_PRSSEL_MASK | TIMER_CC_CTRL_MODE_MASK))
+			| TIMER_CC_CTRL_PRSSEL(ch) | TIMER_CC_CTRL_INSEL
+			| TIMER_CC_CTRL_MODE(TIMER_CC_CTRL_MODE_INPUTCAPTURE);
+		break;
+	}
+}
+
+/**
+ * Route a set of producer to consumer links, all or nothing.  Every link is
+ * validated and given a channel before any register is touched, so on
+ * failure the PRS and the consumers are unchanged.
+ *
+ * Only event consumers are handled here.  Peripheral to DMA requests do not
+ * go through the PRS, pass the DMA_CH_CTRL_SOURCESEL_* / SIGSEL_* of the
+ * peripheral to the DMA engine for those.
+ *
+ * @param[in,out] links Links to route, the channel used is stored in ch
+ * @param[in] n Number of links
+ * @retval true if all links were routed
+ * @retval false if a link is invalid or the channels ran out
+ */
+bool prs_chain_build(struct prs_link *links, int n)
+{
+	uint16_t taken = 0;
+	int i, j;
+
+	for (i = 0; i < n; i++) {
+		uint32_t ctrl = prs_chain_ctrl(&links[i]);
+
+		if (!prs_chain_valid(&links[i])) {
+			return false;
+		}
+
+		/* Share a channel with an earlier link of the same set */
+		links[i].ch = -1;
+		for (j = 0; j < i; j++) {
+			if (prs_chain_ctrl(&links[j]) == ctrl) {
+				links[i].ch = links[j].ch;
+				break;
+			}
+		}
+		if (links[i].ch < 0) {
+			links[i].ch = prs_chain_find(ctrl, taken);
+		}
+		if (links[i].ch < 0) {
+			return false;
+		}
+		taken |= 1 << links[i].ch;
+	}
+
+	for (i = 0; i < n; i++) {
+		PRS_CHx_CTRL(links[i].ch) = prs_chain_ctrl(&links[i]);
+		prs_chain_consumer(&links[i], links[i].ch);
+	}
+	return true;
+}
+
+/**
+ * Route a single link.
+ * @return the PRS channel used, or -1 as for prs_chain_build()
+ */
+int prs_chain_connect(uint32_t source, uint32_t signal, uint32_t edge,
+		      enum prs_consumer consumer, uint32_t base, uint8_t index)
+{
+	struct prs_link link = {
+		.source = source,
+		.signal = signal,
+		.edge = edge,
+		.consumer = consumer,
+		.base = base,
+		.index = index,
+	};
+
+	return prs_chain_build(&link, 1) ? link.ch : -1;
+}
+
+/**
+ * Give a channel back.  Consumers still selecting it keep doing so, and
+ * see no more events.
+ * @param[in] ch Channel (use PRS_CHx)
+ */
+void prs_chain_release(enum prs_ch ch)
+{
+	PRS_CHx_CTRL(ch) = 0;
+}
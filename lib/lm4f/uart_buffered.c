@@ -0,0 +1,272 @@
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @defgroup uart_buffered UART ring buffered driver
+ * @ingroup uart_file
+ *
+ * \brief <b>Interrupt driven UART with receive and transmit ring buffers</b>
+ *
+ * The FIFOs are enabled and serviced in bursts: the receive interrupt fires
+ * at half full and the receive timeout interrupt picks up what is left in
+ * the FIFO once the line goes quiet.  The transmit FIFO is topped up every
+ * time it drains below half, or fed by a uDMA channel instead when
+ * @ref uart_buffered_use_tx_dma() is called.
+ *
+ * The ring sizes must be powers of two.  The UART must be configured and
+ * enabled, and its interrupt enabled in the NVIC:
+ * @code{.c}
+ *	static uint8_t rxbuf[256], txbuf[256];
+ *	static struct uart_buffered console;
+ *
+ *	uart_buffered_init(&console, UART0, rxbuf, sizeof(rxbuf),
+ *			   txbuf, sizeof(txbuf));
+ *	nvic_enable_irq(NVIC_UART0_IRQ);
+ *
+ *	void uart0_isr(void)
+ *	{
+ *		uart_buffered_isr(&console);
+ *	}
+ * @endcode
+ * @{
+ */
+
+#include <libopencm3/lm4f/uart.h>
+#include <libopencm3/lm4f/udma.h>
+#include <libopencm3/cm3/cortex.h>
+
+#define RING_USED(r)	((uint16_t)((r)->head - (r)->tail))
+#define RING_FREE(r)	((uint16_t)((r)->mask + 1 - RING_USED(r)))
+
+static void uart_buffered_fill(struct uart_buffered *ub)
+{
+	struct uart_ring *tx = &ub->tx;
+
+	while (tx->head != tx->tail && !uart_is_tx_fifo_full(ub->uart)) {
+		UART_DR(ub->uart) = tx->buf[tx->tail & tx->mask];
+		tx->tail++;
+	}
+}
+
+/* Called with the UART interrupt masked or from it */
+static void uart_buffered_dma_next(struct uart_buffered *ub)
+{
+	struct uart_ring *tx = &ub->tx;
+	uint16_t start = tx->tail & tx->mask;
+	uint16_t len = RING_USED(tx);
+
+	if (ub->tx_dma_len || !len) {
+		return;
+	}
+	if (len > tx->mask + 1 - start) {
+		len = tx->mask + 1 - start;
+	}
+	if (len > UDMA_MAX_TRANSFER) {
+		len = UDMA_MAX_TRANSFER;
+	}
+
+	/* Bursts of 4 match the half empty Tx FIFO request level */
+	ub->tx_dma_len = len;
+	udma_transfer_start(ub->tx_dma, (uint32_t)&tx->buf[start], UDMA_SIZE_8,
+			    (uint32_t)&UART_DR(ub->uart), UDMA_INC_NONE,
+			    UDMA_SIZE_8, len, 2);
+}
+
+static void uart_buffered_kick(struct uart_buffered *ub)
+{
+	if (ub->tx_dma >= 0) {
+		CM_ATOMIC_BLOCK() {
+			uart_buffered_dma_next(ub);
+		}
+		return;
+	}
+
+	uart_disable_interrupts(ub->uart, UART_INT_TX);
+	uart_buffered_fill(ub);
+	if (ub->tx.head != ub->tx.tail) {
+		uart_enable_interrupts(ub->uart, UART_INT_TX);
+	}
+}
+
+/**
+ * \brief Set up the ring buffers and the UART FIFOs and interrupts
+ *
+ * @param[out] ub Driver state
+ * @param[in] uart UART block register address base @ref uart_reg_base
+ * @param[in] rxbuf, rxsize Receive ring, size a power of two
+ * @param[in] txbuf, txsize Transmit ring, size a power of two
+ */
+void uart_buffered_init(struct uart_buffered *ub, uint32_t uart,
+			uint8_t *rxbuf, uint16_t rxsize,
+			uint8_t *txbuf, uint16_t txsize)
+{
+	ub->uart = uart;
+	ub->rx.buf = rxbuf;
+	ub->rx.mask = rxsize - 1;
+	ub->rx.head = ub->rx.tail = 0;
+	ub->tx.buf = txbuf;
+	ub->tx.mask = txsize - 1;
+	ub->tx.head = ub->tx.tail = 0;
+	ub->rx_dropped = 0;
+	ub->rx_errors = 0;
+	ub->tx_dma = -1;
+	ub->tx_dma_len = 0;
+
+	uart_enable_fifo(uart);
+	uart_set_fifo_trigger_levels(uart, UART_FIFO_RX_TRIG_1_2,
+				     UART_FIFO_TX_TRIG_1_2);
+	uart_clear_interrupt_flag(uart, UART_INT_RX | UART_INT_RT |
+					UART_INT_TX | UART_INT_OE);
+	uart_enable_interrupts(uart, UART_INT_RX | UART_INT_RT | UART_INT_OE);
+}
+
+/**
+ * \brief Feed the transmit FIFO from a uDMA channel
+ *
+ * @ref udma_init() must have been called.  Completion is signalled on the
+ * UART interrupt, so nothing changes for the ISR.
+ *
+ * @param[in] ub Driver state
+ * @param[in] channel uDMA channel of the UART transmitter, UDMA_CH_UARTn_TX
+ * @param[in] encoding Channel encoding for that channel
+ */
+void uart_buffered_use_tx_dma(struct uart_buffered *ub, uint8_t channel,
+			      uint8_t encoding)
+{
+	udma_channel_assign(channel, encoding);
+	udma_channel_clear_done(channel);
+	ub->tx_dma = channel;
+	uart_disable_interrupts(ub->uart, UART_INT_TX);
+	uart_enable_tx_dma(ub->uart);
+	uart_buffered_kick(ub);
+}
+
+/**
+ * \brief Queue data for transmission, without blocking
+ *
+ * @return the number of bytes queued, less than len if the ring is full
+ */
+uint16_t uart_buffered_write(struct uart_buffered *ub, const uint8_t *data,
+			     uint16_t len)
+{
+	struct uart_ring *tx = &ub->tx;
+	uint16_t n = RING_FREE(tx);
+	uint16_t i;
+
+	if (len < n) {
+		n = len;
+	}
+	for (i = 0; i < n; i++) {
+		tx->buf[(tx->head + i) & tx->mask] = data[i];
+	}
+	tx->head += n;
+
+	uart_buffered_kick(ub);
+	return n;
+}
+
+/**
+ * \brief Take received data out of the ring, without blocking
+ *
+ * @return the number of bytes copied to data
+ */
+uint16_t uart_buffered_read(struct uart_buffered *ub, uint8_t *data,
+			    uint16_t len)
+{
+	struct uart_ring *rx = &ub->rx;
+	uint16_t n = RING_USED(rx);
+	uint16_t i;
+
+	if (len < n) {
+		n = len;
+	}
+	for (i = 0; i < n; i++) {
+		data[i] = rx->buf[(rx->tail + i) & rx->mask];
+	}
+	rx->tail += n;
+	return n;
+}
+
+/** \brief Bytes waiting in the receive ring */
+uint16_t uart_buffered_rx_available(struct uart_buffered *ub)
+{
+	return RING_USED(&ub->rx);
+}
+
+/** \brief Room left in the transmit ring */
+uint16_t uart_buffered_tx_free(struct uart_buffered *ub)
+{
+	return RING_FREE(&ub->tx);
+}
+
+/** \brief Wait until everything queued has left the shift register */
+void uart_buffered_flush(struct uart_buffered *ub)
+{
+	while (ub->tx.head != ub->tx.tail);
+	while (UART_FR(ub->uart) & UART_FR_BUSY);
+}
+
+/**
+ * \brief Interrupt handler, must be called from the UART's ISR
+ */
+void uart_buffered_isr(struct uart_buffered *ub)
+{
+	uint32_t uart = ub->uart;
+	uint32_t mis = UART_MIS(uart);
+	struct uart_ring *rx = &ub->rx;
+
+	UART_ICR(uart) = mis;
+
+	if (mis & (UART_INT_RX | UART_INT_RT | UART_INT_OE)) {
+		if (mis & UART_INT_OE) {
+			ub->rx_errors++;
+		}
+		/* Drain the whole FIFO, not just up to the trigger level */
+		while (!uart_is_rx_fifo_empty(uart)) {
+			uint32_t data = UART_DR(uart);
+
+			if (data & (UART_DR_OE | UART_DR_BE | UART_DR_PE |
+				    UART_DR_FE)) {
+				ub->rx_errors++;
+			}
+			if (RING_FREE(rx)) {
+				rx->buf[rx->head & rx->mask] = data;
+				rx->head++;
+			} else {
+				ub->rx_dropped++;
+			}
+		}
+	}
+
+	if (ub->tx_dma >= 0) {
+		if (udma_channel_done(ub->tx_dma)) {
+			udma_channel_clear_done(ub->tx_dma);
+			ub->tx.tail += ub->tx_dma_len;
+			ub->tx_dma_len = 0;
+			uart_buffered_dma_next(ub);
+		}
+	} else if (mis & UART_INT_TX) {
+		uart_buffered_fill(ub);
+		if (ub->tx.head == ub->tx.tail) {
+			uart_disable_interrupts(uart, UART_INT_TX);
+		}
+	}
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,215 @@
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @defgroup udma_file uDMA
+ *
+ * @ingroup LM4Fxx
+ *
+ * \brief <b>libopencm3 LM4F Micro Direct Memory Access controller</b>
+ *
+ * The driver owns the channel control table, 32 primary structures followed
+ * by the 32 alternates, 1 KiB aligned as the hardware requires.
+ *
+ * A peripheral transfer is started with @ref udma_transfer_start() once the
+ * channel is assigned to the peripheral with @ref udma_channel_assign() and
+ * DMA is enabled in the peripheral.  When it completes, the interrupt of the
+ * peripheral fires and @ref udma_channel_done() tells which channel is done.
+ *
+ * @{
+ */
+
+#include <libopencm3/lm4f/udma.h>
+#include <libopencm3/lm4f/systemcontrol.h>
+
+static struct udma_ctl udma_table[2 * UDMA_CHANNELS]
+	__attribute__((aligned(1024)));
+
+/**
+ * \brief Clock and enable the uDMA controller with the driver's table
+ */
+void udma_init(void)
+{
+	periph_clock_enable(RCC_DMA);
+	__asm__("nop"); __asm__("nop"); __asm__("nop");
+	UDMA_CFG = UDMA_CFG_MASTEN;
+	UDMA_CTLBASE = (uint32_t)udma_table;
+}
+
+/**
+ * \brief Disable the uDMA controller
+ */
+void udma_disable(void)
+{
+	UDMA_CFG = 0;
+}
+
+/** \brief Primary control structure of a channel */
+struct udma_ctl *udma_primary(uint8_t channel)
+{
+	return &udma_table[channel];
+}
+
+/** \brief Alternate control structure of a channel */
+struct udma_ctl *udma_alternate(uint8_t channel)
+{
+	return &udma_table[UDMA_CHANNELS + channel];
+}
+
+/**
+ * \brief Select the peripheral a channel serves
+ *
+ * @param[in] channel uDMA channel
+ * @param[in] encoding Channel encoding, see the UDMA_CH_ definitions
+ */
+void udma_channel_assign(uint8_t channel, uint8_t encoding)
+{
+	uint32_t shift = (channel % 8) * 4;
+
+	UDMA_CHMAP(channel / 8) = (UDMA_CHMAP(channel / 8) & ~(0xf << shift)) |
+				  ((encoding & 0xf) << shift);
+}
+
+void udma_channel_enable(uint8_t channel)
+{
+	UDMA_ENASET = 1 << channel;
+}
+
+void udma_channel_disable(uint8_t channel)
+{
+	UDMA_ENACLR = 1 << channel;
+}
+
+bool udma_channel_is_enabled(uint8_t channel)
+{
+	return UDMA_ENASET & (1 << channel);
+}
+
+/**
+ * \brief Ignore single requests of the peripheral, only react to bursts
+ */
+void udma_channel_set_burst_only(uint8_t channel, bool burst)
+{
+	if (burst) {
+		UDMA_USEBURSTSET = 1 << channel;
+	} else {
+		UDMA_USEBURSTCLR = 1 << channel;
+	}
+}
+
+static uint32_t udma_end(uint32_t start, enum udma_size inc, uint16_t count)
+{
+	if (inc == UDMA_INC_NONE) {
+		return start;
+	}
+	return start + ((uint32_t)(count - 1) << inc);
+}
+
+/**
+ * \brief Fill a channel control structure
+ *
+ * @param[out] ctl Control structure
+ * @param[in] src Source start address
+ * @param[in] src_inc Source increment, usually the same as size, or
+ *		      UDMA_INC_NONE for a peripheral register
+ * @param[in] dst Destination start address
+ * @param[in] dst_inc Destination increment
+ * @param[in] size Data size
+ * @param[in] count Number of transfers, 1 to @ref UDMA_MAX_TRANSFER
+ * @param[in] arb_log2 Arbitrate every 2^arb_log2 transfers, match the burst
+ *		       request level of the peripheral
+ * @param[in] mode Transfer mode
+ */
+void udma_ctl_fill(struct udma_ctl *ctl, uint32_t src, enum udma_size src_inc,
+		   uint32_t dst, enum udma_size dst_inc, enum udma_size size,
+		   uint16_t count, uint8_t arb_log2, enum udma_mode mode)
+{
+	ctl->src_end = udma_end(src, src_inc, count);
+	ctl->dst_end = udma_end(dst, dst_inc, count);
+	ctl->control = ((uint32_t)dst_inc << UDMA_CHCTL_DSTINC_SHIFT) |
+		       ((uint32_t)size << UDMA_CHCTL_DSTSIZE_SHIFT) |
+		       ((uint32_t)src_inc << UDMA_CHCTL_SRCINC_SHIFT) |
+		       ((uint32_t)size << UDMA_CHCTL_SRCSIZE_SHIFT) |
+		       ((uint32_t)arb_log2 << UDMA_CHCTL_ARBSIZE_SHIFT) |
+		       ((uint32_t)(count - 1) << UDMA_CHCTL_XFERSIZE_SHIFT) |
+		       ((uint32_t)mode << UDMA_CHCTL_XFERMODE_SHIFT);
+}
+
+/**
+ * \brief Start a basic peripheral transfer on the primary structure
+ *
+ * See @ref udma_ctl_fill() for the parameters.
+ */
+void udma_transfer_start(uint8_t channel, uint32_t src, enum udma_size src_inc,
+			 uint32_t dst, enum udma_size dst_inc,
+			 enum udma_size size, uint16_t count, uint8_t arb_log2)
+{
+	UDMA_ALTCLR = 1 << channel;
+	udma_ctl_fill(udma_primary(channel), src, src_inc, dst, dst_inc, size,
+		      count, arb_log2, UDMA_MODE_BASIC);
+	UDMA_REQMASKCLR = 1 << channel;
+	udma_channel_enable(channel);
+}
+
+/**
+ * \brief Transfers left on the primary structure of a channel
+ */
+uint16_t udma_transfer_remaining(uint8_t channel)
+{
+	uint32_t control = udma_primary(channel)->control;
+
+	if ((control & UDMA_CHCTL_XFERMODE_MASK) == UDMA_MODE_STOP) {
+		return 0;
+	}
+	return ((control & UDMA_CHCTL_XFERSIZE_MASK) >>
+		UDMA_CHCTL_XFERSIZE_SHIFT) + 1;
+}
+
+/**
+ * \brief Software request, starts an auto mode (memory) transfer
+ */
+void udma_request(uint8_t channel)
+{
+	UDMA_SWREQ = 1 << channel;
+}
+
+/**
+ * \brief Check whether a channel raised its completion interrupt
+ */
+bool udma_channel_done(uint8_t channel)
+{
+	return UDMA_CHIS & (1 << channel);
+}
+
+void udma_channel_clear_done(uint8_t channel)
+{
+	UDMA_CHIS = 1 << channel;
+}
+
+bool udma_error(void)
+{
+	return UDMA_ERRCLR & 1;
+}
+
+void udma_clear_error(void)
+{
+	UDMA_ERRCLR = 1;
+}
+
+/**
+ * @}
+ */
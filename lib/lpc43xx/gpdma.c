@@ -0,0 +1,216 @@
+/** @defgroup gpdma_file GPDMA
+
+@ingroup LPC43xx
+
+@brief <b>libopencm3 LPC43xx General Purpose DMA</b>
+
+LGPL License Terms @ref lgpl_license
+*/
+
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**@{*/
+
+#include <libopencm3/lpc43xx/gpdma.h>
+#include <libopencm3/lpc43xx/ccu.h>
+#include <libopencm3/lpc43xx/creg.h>
+
+/* Enable the DMA branch clock and the controller, little endian on both
+ * AHB masters. */
+void gpdma_controller_enable(void)
+{
+	CCU1_CLK_M4_DMA_CFG |= 1; /* RUN */
+	GPDMA_CONFIG = GPDMA_CONFIG_E(1);
+	while ((GPDMA_CONFIG & GPDMA_CONFIG_E_MASK) == 0);
+}
+
+void gpdma_controller_disable(void)
+{
+	GPDMA_CONFIG = 0;
+}
+
+/* Route a peripheral to one of the 16 DMA request lines, see the
+ * GPDMA_PERIPH_xxx / GPDMA_PERIPH_xxx_MUX pairs. */
+void gpdma_periph_select(uint8_t periph, uint8_t mux)
+{
+	uint32_t shift = periph * 2;
+
+	CREG_DMAMUX = (CREG_DMAMUX & ~(0x3 << shift)) | ((mux & 0x3) << shift);
+}
+
+/*
+ * Fill an array of linked list items for a transfer of count source width
+ * units, splitting it in pieces of at most GPDMA_MAX_TRANSFER.  control
+ * holds the width, burst and increment settings, the transfer size and
+ * terminal count interrupt bits are set here, the latter on the last item
+ * only.  The items are chained in array order and the last one ends the
+ * list.  Returns the number of items used, or 0 if nlli is too small.
+ */
+size_t gpdma_lli_build(struct gpdma_lli *lli, size_t nlli,
+		       uint32_t src, uint32_t dest, size_t count,
+		       uint32_t control)
+{
+	uint32_t width = (control & GPDMA_CCONTROL_SWIDTH_MASK) >>
+			 GPDMA_CCONTROL_SWIDTH_SHIFT;
+	size_t used = 0;
+
+	control &= ~(GPDMA_CCONTROL_TRANSFERSIZE_MASK | GPDMA_CCONTROL_I_MASK);
+
+	if (count == 0 ||
+	    (count + GPDMA_MAX_TRANSFER - 1) / GPDMA_MAX_TRANSFER > nlli) {
+		return 0;
+	}
+
+	while (count) {
+		size_t chunk = count > GPDMA_MAX_TRANSFER ?
+			       GPDMA_MAX_TRANSFER : count;
+
+		lli[used].src = src;
+		lli[used].dest = dest;
+		lli[used].control = control |
+				    GPDMA_CCONTROL_TRANSFERSIZE(chunk);
+		lli[used].next = 0;
+		if (used) {
+			lli[used - 1].next = (uint32_t)&lli[used];
+		}
+
+		if (control & GPDMA_CCONTROL_SI_MASK) {
+			src += chunk << width;
+		}
+		if (control & GPDMA_CCONTROL_DI_MASK) {
+			dest += chunk << width;
+		}
+		count -= chunk;
+		used++;
+	}
+	lli[used - 1].control |= GPDMA_CCONTROL_I(1);
+
+	return used;
+}
+
+/* Chain the list ending in lli to next, pass lli itself as next to make a
+ * circular list. */
+void gpdma_lli_link(struct gpdma_lli *lli, struct gpdma_lli *next)
+{
+	lli->next = (uint32_t)next;
+}
+
+/*
+ * Load the first item of a list into a channel and enable it.  config holds
+ * the peripherals, flow control and interrupt masks, the enable bit is set
+ * here.  Clears any stale flags of the channel first.
+ */
+void gpdma_channel_start(uint8_t channel, const struct gpdma_lli *lli,
+			 uint32_t config)
+{
+	gpdma_clear_flags(channel);
+
+	GPDMA_CSRCADDR(channel) = lli->src;
+	GPDMA_CDESTADDR(channel) = lli->dest;
+	GPDMA_CLLI(channel) = lli->next;
+	GPDMA_CCONTROL(channel) = lli->control;
+	GPDMA_CCONFIG(channel) = config | GPDMA_CCONFIG_E(1);
+}
+
+/* Stop a channel immediately, data in the channel FIFO is lost. */
+void gpdma_channel_stop(uint8_t channel)
+{
+	GPDMA_CCONFIG(channel) &= ~GPDMA_CCONFIG_E_MASK;
+	while (GPDMA_ENBLDCHNS & (1 << channel));
+}
+
+/* Ignore further requests and let the channel drain its FIFO, then disable
+ * it. */
+void gpdma_channel_halt(uint8_t channel)
+{
+	GPDMA_CCONFIG(channel) |= GPDMA_CCONFIG_H(1);
+	while (GPDMA_CCONFIG(channel) & GPDMA_CCONFIG_A_MASK);
+	GPDMA_CCONFIG(channel) &= ~(GPDMA_CCONFIG_E_MASK |
+				    GPDMA_CCONFIG_H_MASK);
+}
+
+bool gpdma_channel_is_enabled(uint8_t channel)
+{
+	return GPDMA_ENBLDCHNS & (1 << channel);
+}
+
+/* True while the channel FIFO still holds data. */
+bool gpdma_channel_is_active(uint8_t channel)
+{
+	return GPDMA_CCONFIG(channel) & GPDMA_CCONFIG_A_MASK;
+}
+
+/* Transfers left in the current linked list item. */
+size_t gpdma_channel_remaining(uint8_t channel)
+{
+	return (GPDMA_CCONTROL(channel) & GPDMA_CCONTROL_TRANSFERSIZE_MASK) >>
+	       GPDMA_CCONTROL_TRANSFERSIZE_SHIFT;
+}
+
+bool gpdma_tc_flag(uint8_t channel)
+{
+	return GPDMA_INTTCSTAT & (1 << channel);
+}
+
+bool gpdma_error_flag(uint8_t channel)
+{
+	return GPDMA_INTERRSTAT & (1 << channel);
+}
+
+void gpdma_clear_flags(uint8_t channel)
+{
+	GPDMA_INTTCCLEAR = 1 << channel;
+	GPDMA_INTERRCLR = 1 << channel;
+}
+
+/*
+ * Memory to memory copy, in words when both pointers and the length allow
+ * it.  lli must have room for len / GPDMA_MAX_TRANSFER + 1 items and stay
+ * valid until the copy is done.  Returns false if the list did not fit,
+ * completion is signalled by gpdma_tc_flag() or the DMA interrupt.
+ */
+bool gpdma_memcpy(uint8_t channel, struct gpdma_lli *lli, size_t nlli,
+		  void *dest, const void *src, size_t len)
+{
+	uint32_t width = GPDMA_WIDTH_8;
+	uint32_t control;
+
+	if ((((uint32_t)dest | (uint32_t)src | len) & 3) == 0) {
+		width = GPDMA_WIDTH_32;
+		len >>= 2;
+	}
+
+	control = GPDMA_CCONTROL_SBSIZE(GPDMA_BSIZE_8) |
+		  GPDMA_CCONTROL_DBSIZE(GPDMA_BSIZE_8) |
+		  GPDMA_CCONTROL_SWIDTH(width) |
+		  GPDMA_CCONTROL_DWIDTH(width) |
+		  GPDMA_CCONTROL_S(0) | GPDMA_CCONTROL_D(1) |
+		  GPDMA_CCONTROL_SI(1) | GPDMA_CCONTROL_DI(1);
+
+	if (gpdma_lli_build(lli, nlli, (uint32_t)src, (uint32_t)dest, len,
+			    control) == 0) {
+		return false;
+	}
+
+	gpdma_channel_start(channel, lli,
+			    GPDMA_CCONFIG_FLOWCNTRL(GPDMA_FLOW_M2M) |
+			    GPDMA_CCONFIG_IE(1) | GPDMA_CCONFIG_ITC(1));
+	return true;
+}
+
+/**@}*/
@@ -0,0 +1,358 @@
+/*
+* This file is part of the libopencm3 project.
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Shared memory messaging between the M4 and M0 cores, see ipc.h */
+
+#include <libopencm3/lpc43xx/ipc.h>
+#include <libopencm3/lpc43xx/creg.h>
+#include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/sync.h>
+#if defined(LPC43XX_M4)
+#include <libopencm3/cm3/dwt.h>
+#endif
+
+#if defined(LPC43XX_M4)
+#define IPC_BUF_FREE_SELF	IPC_BUF_FREE_M4
+#define IPC_BUF_BUSY_SELF	IPC_BUF_BUSY_M4
+#define IPC_BUF_BUSY_PEER	IPC_BUF_BUSY_M0
+#define IPC_TX_RING		to_m0
+#define IPC_RX_RING		to_m4
+#else
+#define IPC_BUF_FREE_SELF	IPC_BUF_FREE_M0
+#define IPC_BUF_BUSY_SELF	IPC_BUF_BUSY_M0
+#define IPC_BUF_BUSY_PEER	IPC_BUF_BUSY_M4
+#define IPC_TX_RING		to_m4
+#define IPC_RX_RING		to_m0
+#endif
+
+static struct ipc_shm *ipc;
+
+#if defined(LPC43XX_M4)
+static volatile uint32_t ipc_rtt;
+#endif
+
+/* Round up to a multiple of 4, keeps everything word aligned */
+#define IPC_ALIGN(x)		(((x) + 3) & ~3)
+
+/*---------------------------------------------------------------------------*/
+/** @brief Format the shared memory region
+
+Lays out the header, both message rings, the buffer owner table and the buffer
+pool in the given region, then publishes it. Call this on one core only.
+
+@param[in] base Start of the shared region, word aligned.
+@param[in] size Size of the region in bytes.
+@param[in] ring_entries Messages per direction, must be a power of two.
+@param[in] nbufs Number of pool buffers.
+@param[in] buf_size Size of each pool buffer in bytes.
+@param[in] nbufs_m4 How many of the buffers belong to the M4, the rest belong
+to the M0. Freed buffers always go back to the core they belong to.
+@returns false if the parameters are invalid or don't fit into the region.
+*/
+bool ipc_shm_init(void *base, uint32_t size, uint32_t ring_entries,
+		  uint32_t nbufs, uint32_t buf_size, uint32_t nbufs_m4)
+{
+	struct ipc_shm *shm = base;
+	uint8_t *p = (uint8_t *)base + IPC_ALIGN(sizeof(*shm));
+	uint32_t i;
+
+	if ((ring_entries == 0) || (ring_entries & (ring_entries - 1)) ||
+	    (nbufs_m4 > nbufs)) {
+		return false;
+	}
+
+	buf_size = IPC_ALIGN(buf_size);
+	if (IPC_ALIGN(sizeof(*shm)) +
+	    2 * ring_entries * sizeof(struct ipc_msg) +
+	    IPC_ALIGN(nbufs) + nbufs * buf_size > size) {
+		return false;
+	}
+
+	shm->magic = 0;
+	__dmb();
+
+	shm->to_m0.head = shm->to_m0.tail = 0;
+	shm->to_m0.mask = ring_entries - 1;
+	shm->to_m0.msgs = (struct ipc_msg *)p;
+	p += ring_entries * sizeof(struct ipc_msg);
+
+	shm->to_m4.head = shm->to_m4.tail = 0;
+	shm->to_m4.mask = ring_entries - 1;
+	shm->to_m4.msgs = (struct ipc_msg *)p;
+	p += ring_entries * sizeof(struct ipc_msg);
+
+	shm->nbufs = nbufs;
+	shm->nbufs_m4 = nbufs_m4;
+	shm->buf_size = buf_size;
+	shm->owner = p;
+	for (i = 0; i < nbufs; i++) {
+		shm->owner[i] = (i < nbufs_m4) ? IPC_BUF_FREE_M4 :
+						 IPC_BUF_FREE_M0;
+	}
+	p += IPC_ALIGN(nbufs);
+	shm->bufs = p;
+
+	/* Publish the layout only once it is complete */
+	__dmb();
+	shm->magic = IPC_SHM_MAGIC;
+	ipc = shm;
+
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Attach to a shared memory region formatted by the other core
+
+@param[in] base Start of the shared region, same address as on the other core.
+@returns false if the region has not been formatted (yet).
+*/
+bool ipc_shm_attach(void *base)
+{
+	struct ipc_shm *shm = base;
+
+	if (shm->magic != IPC_SHM_MAGIC) {
+		return false;
+	}
+	__dmb();
+	ipc = shm;
+
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Raise the other core's core interrupt (M4TXEV / M0TXEV)
+*/
+void ipc_doorbell_ring(void)
+{
+	/* Make the ring and buffer updates visible before the event */
+	__asm__ volatile ("dsb\n\tsev" : : : "memory");
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Acknowledge a doorbell from the other core
+
+Must be called from the m0core_isr (M4) / m4core_isr (M0) handler.
+*/
+void ipc_doorbell_clear(void)
+{
+#if defined(LPC43XX_M4)
+	CREG_M0TXEVENT = 0;
+#else
+	CREG_M4TXEVENT = 0;
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Enable the interrupt raised by the other core's doorbell
+*/
+void ipc_doorbell_enable_irq(void)
+{
+	ipc_doorbell_clear();
+#if defined(LPC43XX_M4)
+	nvic_enable_irq(NVIC_M0CORE_IRQ);
+#else
+	nvic_enable_irq(NVIC_M4CORE_IRQ);
+#endif
+}
+
+static bool ipc_ring_full(struct ipc_ring *ring)
+{
+	return ring->head - ring->tail > ring->mask;
+}
+
+/* Only called by the producer, after checking ipc_ring_full() */
+static void ipc_ring_put(struct ipc_ring *ring, const struct ipc_msg *msg)
+{
+	uint32_t head = ring->head;
+
+	ring->msgs[head & ring->mask] = *msg;
+	__dmb();
+	ring->head = head + 1;
+}
+
+static bool ipc_ring_get(struct ipc_ring *ring, struct ipc_msg *msg)
+{
+	uint32_t tail = ring->tail;
+
+	if (tail == ring->head) {
+		return false;
+	}
+
+	__dmb();
+	*msg = ring->msgs[tail & ring->mask];
+	__dmb();
+	ring->tail = tail + 1;
+
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Send a message with a pool buffer to the other core
+
+Ownership of the buffer passes to the other core, it must not be touched by the
+sender afterwards.
+
+@param[in] type Message type, below @ref IPC_MSG_USER_MAX for application
+messages.
+@param[in] buf Buffer from ipc_buf_alloc() or -1 for none.
+@param[in] len Bytes of the buffer in use.
+@param[in] arg Free for the application.
+@returns false if the ring is full, the buffer stays with the sender then.
+*/
+bool ipc_send_buf(uint16_t type, int32_t buf, uint16_t len, uint32_t arg)
+{
+	struct ipc_msg msg = {
+		.type = type,
+		.len = len,
+		.buf = buf,
+		.arg = arg,
+	};
+	struct ipc_ring *ring = &ipc->IPC_TX_RING;
+
+	if (ipc_ring_full(ring)) {
+		return false;
+	}
+	if (buf >= 0) {
+		/* Buffer contents must be complete before the handover */
+		__dmb();
+		ipc->owner[buf] = IPC_BUF_BUSY_PEER;
+	}
+	ipc_ring_put(ring, &msg);
+	ipc_doorbell_ring();
+
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Send a message without buffer to the other core
+
+@param[in] type Message type, below @ref IPC_MSG_USER_MAX for application
+messages.
+@param[in] arg Free for the application.
+@returns false if the ring is full.
+*/
+bool ipc_send(uint16_t type, uint32_t arg)
+{
+	return ipc_send_buf(type, -1, 0, arg);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Receive the next message from the other core
+
+Pings are answered here and not returned to the caller. A buffer received with
+the message is owned by the caller, and has to be released with ipc_buf_free()
+or passed on with ipc_send_buf().
+
+@param[out] msg Received message.
+@returns false if there is no message pending.
+*/
+bool ipc_recv(struct ipc_msg *msg)
+{
+	while (ipc_ring_get(&ipc->IPC_RX_RING, msg)) {
+		switch (msg->type) {
+		case IPC_MSG_PING:
+			/* Spins on a full ring, the peer is draining it */
+			while (!ipc_send(IPC_MSG_PONG, msg->arg));
+			break;
+#if defined(LPC43XX_M4)
+		case IPC_MSG_PONG:
+			ipc_rtt = dwt_read_cycle_counter() - msg->arg;
+			break;
+#endif
+		default:
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Allocate a buffer from the shared pool
+
+Only buffers currently free on the calling core are considered, see
+ipc_shm_init().
+
+@returns buffer index, or -1 if none is free.
+*/
+int32_t ipc_buf_alloc(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < ipc->nbufs; i++) {
+		if (ipc->owner[i] == IPC_BUF_FREE_SELF) {
+			ipc->owner[i] = IPC_BUF_BUSY_SELF;
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Address of a pool buffer
+
+@param[in] buf Buffer index.
+@returns pointer to the buffer data, valid on both cores.
+*/
+void *ipc_buf_ptr(int32_t buf)
+{
+	return ipc->bufs + buf * ipc->buf_size;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Release a buffer owned by the calling core
+
+The buffer goes back to the free list of the core it belongs to.
+
+@param[in] buf Buffer index.
+*/
+void ipc_buf_free(int32_t buf)
+{
+	__dmb();
+	ipc->owner[buf] = ((uint32_t)buf < ipc->nbufs_m4) ? IPC_BUF_FREE_M4 :
+							     IPC_BUF_FREE_M0;
+}
+
+#if defined(LPC43XX_M4)
+/*---------------------------------------------------------------------------*/
+/** @brief Start a round trip latency measurement
+
+The M0 answers from its ipc_recv(), the answer is processed by the
+ipc_recv() on the M4, after which ipc_ping_cycles() returns the result.
+
+@returns false if the ring is full or the cycle counter is not available.
+*/
+bool ipc_ping(void)
+{
+	if (!dwt_enable_cycle_counter()) {
+		return false;
+	}
+	return ipc_send(IPC_MSG_PING, dwt_read_cycle_counter());
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Result of the last ipc_ping()
+
+@returns round trip time from send to processing of the answer in M4 cycles,
+0 if no answer was received yet.
+*/
+uint32_t ipc_ping_cycles(void)
+{
+	return ipc_rtt;
+}
+#endif
@@ -34,6 +34,12 @@ LGPL License Terms @ref lgpl_license
 
 #include <libopencm3/lpc43xx/ssp.h>
 #include <libopencm3/lpc43xx/cgu.h>
+#include <libopencm3/lpc43xx/gpdma.h>
+
+/* Frame sent when a transfer has no tx buffer, and where received frames
+ * go when it has no rx buffer.  Both must be reachable by the DMA. */
+static uint16_t ssp_dma_fill = 0xffff;
+static uint16_t ssp_dma_sink;
 
 /* Disable SSP */
 void ssp_disable(ssp_num_t ssp_num)
@@ -135,6 +141,160 @@ uint16_t ssp_transfer(ssp_num_t ssp_num, uint16_t data)
 	return SSP_DR(ssp_port);
 }
 
+/*
+ * Exchange count frames, keeping up to SSP_FIFO_DEPTH frames in flight so
+ * the frames go out back to back instead of one per call.  The buffers are
+ * uint8_t for frames of up to 8 bits and uint16_t above.  tx may be NULL to
+ * send all ones, rx may be NULL to discard what is received.  Returns once
+ * the last frame is received, so the bus is idle again.
+ */
+void ssp_transfer_buffer(ssp_num_t ssp_num, const void *tx, void *rx,
+			 size_t count)
+{
+	uint32_t ssp_port;
+	bool wide;
+	size_t sent = 0;
+	size_t received = 0;
 
-/**@}*/
+	if (ssp_num == SSP0_NUM) {
+		ssp_port = SSP0;
+	} else {
+		ssp_port = SSP1;
+	}
+	wide = (SSP_CR0(ssp_port) & 0xf) > SSP_DATA_8BITS;
+
+	/* Drop anything left over in the Rx FIFO */
+	while (SSP_SR(ssp_port) & SSP_SR_RNE) {
+		(void)SSP_DR(ssp_port);
+	}
+
+	while (received < count) {
+		uint32_t sr = SSP_SR(ssp_port);
 
+		if (sr & SSP_SR_RNE) {
+			uint16_t data = SSP_DR(ssp_port);
+
+			if (rx && wide) {
+				((uint16_t *)rx)[received] = data;
+			} else if (rx) {
+				((uint8_t *)rx)[received] = data;
+			}
+			received++;
+		}
+
+		/* Never more in flight than the Rx FIFO can hold */
+		if (sent < count && (sr & SSP_SR_TNF) &&
+		    sent - received < SSP_FIFO_DEPTH) {
+			uint16_t data = ssp_dma_fill;
+
+			if (tx && wide) {
+				data = ((const uint16_t *)tx)[sent];
+			} else if (tx) {
+				data = ((const uint8_t *)tx)[sent];
+			}
+			SSP_DR(ssp_port) = data;
+			sent++;
+		}
+	}
+}
+
+void ssp_dma_enable(ssp_num_t ssp_num)
+{
+	if (ssp_num == SSP0_NUM) {
+		SSP_DMACR(SSP0) = SSP_DMACR_RXDMAE | SSP_DMACR_TXDMAE;
+	} else {
+		SSP_DMACR(SSP1) = SSP_DMACR_RXDMAE | SSP_DMACR_TXDMAE;
+	}
+}
+
+void ssp_dma_disable(ssp_num_t ssp_num)
+{
+	if (ssp_num == SSP0_NUM) {
+		SSP_DMACR(SSP0) = 0;
+	} else {
+		SSP_DMACR(SSP1) = 0;
+	}
+}
+
+/*
+ * Exchange count frames with two GPDMA channels, one feeding the Tx FIFO
+ * and one draining the Rx FIFO, so the transfer runs at the full bit rate
+ * without the CPU.  lli is split in halves between the two channels and
+ * must stay valid until the transfer is done, each half needs one item per
+ * GPDMA_MAX_TRANSFER frames.  tx and rx may be NULL as for
+ * ssp_transfer_buffer().  Completion is the terminal count flag of
+ * rx_channel, which also raises the DMA interrupt.  The GPDMA controller
+ * must be enabled.  Returns false if the lists did not fit.
+ */
+bool ssp_dma_transfer(ssp_num_t ssp_num, uint8_t tx_channel,
+		      uint8_t rx_channel, struct gpdma_lli *lli, size_t nlli,
+		      const void *tx, void *rx, size_t count)
+{
+	uint32_t ssp_port;
+	uint8_t tx_periph, rx_periph;
+	uint32_t width, control;
+	size_t half = nlli / 2;
+
+	if (ssp_num == SSP0_NUM) {
+		ssp_port = SSP0;
+		tx_periph = GPDMA_PERIPH_SSP0_TX;
+		rx_periph = GPDMA_PERIPH_SSP0_RX;
+		gpdma_periph_select(tx_periph, GPDMA_PERIPH_SSP0_TX_MUX);
+		gpdma_periph_select(rx_periph, GPDMA_PERIPH_SSP0_RX_MUX);
+	} else {
+		ssp_port = SSP1;
+		tx_periph = GPDMA_PERIPH_SSP1_TX;
+		rx_periph = GPDMA_PERIPH_SSP1_RX;
+		gpdma_periph_select(tx_periph, GPDMA_PERIPH_SSP1_TX_MUX);
+		gpdma_periph_select(rx_periph, GPDMA_PERIPH_SSP1_RX_MUX);
+	}
+
+	if ((SSP_CR0(ssp_port) & 0xf) > SSP_DATA_8BITS) {
+		width = GPDMA_WIDTH_16;
+	} else {
+		width = GPDMA_WIDTH_8;
+	}
+
+	/* The peripheral side is on AHB master 0, memory on master 1 */
+	control = GPDMA_CCONTROL_SBSIZE(GPDMA_BSIZE_4) |
+		  GPDMA_CCONTROL_DBSIZE(GPDMA_BSIZE_4) |
+		  GPDMA_CCONTROL_SWIDTH(width) |
+		  GPDMA_CCONTROL_DWIDTH(width) |
+		  GPDMA_CCONTROL_S(0) | GPDMA_CCONTROL_D(1) |
+		  GPDMA_CCONTROL_DI(rx ? 1 : 0);
+	if (gpdma_lli_build(lli, half, (uint32_t)&SSP_DR(ssp_port),
+			    rx ? (uint32_t)rx : (uint32_t)&ssp_dma_sink,
+			    count, control) == 0) {
+		return false;
+	}
+
+	control = GPDMA_CCONTROL_SBSIZE(GPDMA_BSIZE_4) |
+		  GPDMA_CCONTROL_DBSIZE(GPDMA_BSIZE_4) |
+		  GPDMA_CCONTROL_SWIDTH(width) |
+		  GPDMA_CCONTROL_DWIDTH(width) |
+		  GPDMA_CCONTROL_S(1) | GPDMA_CCONTROL_D(0) |
+		  GPDMA_CCONTROL_SI(tx ? 1 : 0);
+	if (gpdma_lli_build(lli + half, nlli - half,
+			    tx ? (uint32_t)tx : (uint32_t)&ssp_dma_fill,
+			    (uint32_t)&SSP_DR(ssp_port), count, control) == 0) {
+		return false;
+	}
+
+	while (SSP_SR(ssp_port) & SSP_SR_RNE) {
+		(void)SSP_DR(ssp_port);
+	}
+	ssp_dma_enable(ssp_num);
+
+	/* Rx first, so it is ready before the first frame comes back */
+	gpdma_channel_start(rx_channel, lli,
+			    GPDMA_CCONFIG_SRCPERIPHERAL(rx_periph) |
+			    GPDMA_CCONFIG_FLOWCNTRL(GPDMA_FLOW_P2M) |
+			    GPDMA_CCONFIG_IE(1) | GPDMA_CCONFIG_ITC(1));
+	gpdma_channel_start(tx_channel, lli + half,
+			    GPDMA_CCONFIG_DESTPERIPHERAL(tx_periph) |
+			    GPDMA_CCONFIG_FLOWCNTRL(GPDMA_FLOW_M2P) |
+			    GPDMA_CCONFIG_IE(1));
+	return true;
+}
+
+/**@}*/
@@ -0,0 +1,285 @@
+/*
+* This file is part of the libopencm3 project.
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Interrupt driven UART with receive and transmit ring buffers.
+ *
+ * The 16 byte FIFOs are serviced in bursts: the receive data interrupt fires
+ * at 8 bytes, the character timeout interrupt picks up what is left once the
+ * line goes quiet, and the transmit FIFO is refilled with up to 16 bytes each
+ * time it runs empty.  Optionally a GPDMA channel feeds the transmitter.
+ *
+ * Usage, after uart_init():
+ *	uart_buffered_init(&console, UART0_NUM, rxbuf, sizeof(rxbuf),
+ *			   txbuf, sizeof(txbuf));
+ *	nvic_enable_irq(NVIC_USART0_IRQ);
+ * and call uart_buffered_isr(&console) from usart0_isr().
+ */
+
+#include <libopencm3/lpc43xx/uart.h>
+#include <libopencm3/cm3/cortex.h>
+
+#define RING_USED(r)	((uint16_t)((r)->head - (r)->tail))
+#define RING_FREE(r)	((uint16_t)((r)->mask + 1 - RING_USED(r)))
+
+/* Only called when THRE is set, ie the Tx FIFO is empty */
+static void uart_buffered_fill(struct uart_buffered *ub)
+{
+	struct uart_ring *tx = &ub->tx;
+	int n = UART_TX_FIFO_SIZE;
+
+	while (tx->head != tx->tail && n--) {
+		UART_THR(ub->uart) = tx->buf[tx->tail & tx->mask];
+		tx->tail++;
+	}
+}
+
+/* Called with interrupts masked or from the DMA interrupt */
+static void uart_buffered_dma_next(struct uart_buffered *ub)
+{
+	struct uart_ring *tx = &ub->tx;
+	uint16_t start = tx->tail & tx->mask;
+	uint16_t len = RING_USED(tx);
+	uint8_t periph;
+
+	if (ub->tx_dma_len || !len) {
+		return;
+	}
+	if (len > tx->mask + 1 - start) {
+		len = tx->mask + 1 - start;
+	}
+	if (len > GPDMA_MAX_TRANSFER) {
+		len = GPDMA_MAX_TRANSFER;
+	}
+
+	switch (ub->uart) {
+	case UART0_NUM:
+		periph = GPDMA_PERIPH_USART0_TX;
+		break;
+	case UART1_NUM:
+		periph = GPDMA_PERIPH_UART1_TX;
+		break;
+	case UART2_NUM:
+		periph = GPDMA_PERIPH_USART2_TX;
+		break;
+	default:
+		periph = GPDMA_PERIPH_USART3_TX;
+		break;
+	}
+
+	ub->tx_dma_len = len;
+	gpdma_lli_build(&ub->tx_lli, 1, (uint32_t)&tx->buf[start],
+			(uint32_t)&UART_THR(ub->uart), len,
+			GPDMA_CCONTROL_SBSIZE(GPDMA_BSIZE_1) |
+			GPDMA_CCONTROL_DBSIZE(GPDMA_BSIZE_1) |
+			GPDMA_CCONTROL_SWIDTH(GPDMA_WIDTH_8) |
+			GPDMA_CCONTROL_DWIDTH(GPDMA_WIDTH_8) |
+			GPDMA_CCONTROL_S(1) | GPDMA_CCONTROL_D(0) |
+			GPDMA_CCONTROL_SI(1));
+	gpdma_channel_start(ub->tx_dma, &ub->tx_lli,
+			    GPDMA_CCONFIG_DESTPERIPHERAL(periph) |
+			    GPDMA_CCONFIG_FLOWCNTRL(GPDMA_FLOW_M2P) |
+			    GPDMA_CCONFIG_IE(1) | GPDMA_CCONFIG_ITC(1));
+}
+
+static void uart_buffered_kick(struct uart_buffered *ub)
+{
+	if (ub->tx_dma >= 0) {
+		CM_ATOMIC_BLOCK() {
+			uart_buffered_dma_next(ub);
+		}
+		return;
+	}
+
+	UART_IER(ub->uart) &= ~UART_IER_THREINT_EN;
+	if (UART_LSR(ub->uart) & UART_LSR_THRE) {
+		uart_buffered_fill(ub);
+	}
+	if (ub->tx.head != ub->tx.tail) {
+		UART_IER(ub->uart) |= UART_IER_THREINT_EN;
+	}
+}
+
+/*
+ * Set up the rings and switch the UART to FIFO mode with interrupts.  The
+ * ring sizes must be powers of two.
+ */
+void uart_buffered_init(struct uart_buffered *ub, uart_num_t uart_num,
+			uint8_t *rxbuf, uint16_t rxsize,
+			uint8_t *txbuf, uint16_t txsize)
+{
+	ub->uart = uart_num;
+	ub->rx.buf = rxbuf;
+	ub->rx.mask = rxsize - 1;
+	ub->rx.head = ub->rx.tail = 0;
+	ub->tx.buf = txbuf;
+	ub->tx.mask = txsize - 1;
+	ub->tx.head = ub->tx.tail = 0;
+	ub->rx_dropped = 0;
+	ub->rx_errors = 0;
+	ub->tx_dma = -1;
+	ub->tx_dma_len = 0;
+
+	UART_FCR(uart_num) = UART_FCR_FIFO_EN | UART_FCR_RX_RS |
+			     UART_FCR_TX_RS | UART_FCR_TRG_LEV2;
+	UART_IER(uart_num) = UART_IER_RBRINT_EN | UART_IER_RLSINT_EN;
+}
+
+/*
+ * Feed the transmitter from a GPDMA channel.  The GPDMA controller must be
+ * enabled, and uart_buffered_dma_isr() called from dma_isr().
+ */
+void uart_buffered_use_tx_dma(struct uart_buffered *ub, uint8_t channel)
+{
+	switch (ub->uart) {
+	case UART0_NUM:
+		gpdma_periph_select(GPDMA_PERIPH_USART0_TX,
+				    GPDMA_PERIPH_USART0_TX_MUX);
+		break;
+	case UART1_NUM:
+		gpdma_periph_select(GPDMA_PERIPH_UART1_TX,
+				    GPDMA_PERIPH_UART1_TX_MUX);
+		break;
+	case UART2_NUM:
+		gpdma_periph_select(GPDMA_PERIPH_USART2_TX,
+				    GPDMA_PERIPH_USART2_TX_MUX);
+		break;
+	case UART3_NUM:
+		gpdma_periph_select(GPDMA_PERIPH_USART3_TX,
+				    GPDMA_PERIPH_USART3_TX_MUX);
+		break;
+	}
+
+	UART_IER(ub->uart) &= ~UART_IER_THREINT_EN;
+	UART_FCR(ub->uart) = UART_FCR_FIFO_EN | UART_FCR_DMAMODE_SEL |
+			     UART_FCR_TRG_LEV2;
+	ub->tx_dma = channel;
+	uart_buffered_kick(ub);
+}
+
+/* Queue data for transmission, returns how much fitted in the ring. */
+uint16_t uart_buffered_write(struct uart_buffered *ub, const uint8_t *data,
+			     uint16_t len)
+{
+	struct uart_ring *tx = &ub->tx;
+	uint16_t n = RING_FREE(tx);
+	uint16_t i;
+
+	if (len < n) {
+		n = len;
+	}
+	for (i = 0; i < n; i++) {
+		tx->buf[(tx->head + i) & tx->mask] = data[i];
+	}
+	tx->head += n;
+
+	uart_buffered_kick(ub);
+	return n;
+}
+
+/* Take received data out of the ring, returns the number of bytes copied. */
+uint16_t uart_buffered_read(struct uart_buffered *ub, uint8_t *data,
+			    uint16_t len)
+{
+	struct uart_ring *rx = &ub->rx;
+	uint16_t n = RING_USED(rx);
+	uint16_t i;
+
+	if (len < n) {
+		n = len;
+	}
+	for (i = 0; i < n; i++) {
+		data[i] = rx->buf[(rx->tail + i) & rx->mask];
+	}
+	rx->tail += n;
+	return n;
+}
+
+uint16_t uart_buffered_rx_available(struct uart_buffered *ub)
+{
+	return RING_USED(&ub->rx);
+}
+
+uint16_t uart_buffered_tx_free(struct uart_buffered *ub)
+{
+	return RING_FREE(&ub->tx);
+}
+
+/* Wait until everything queued has left the shift register. */
+void uart_buffered_flush(struct uart_buffered *ub)
+{
+	while (ub->tx.head != ub->tx.tail);
+	while (!(UART_LSR(ub->uart) & UART_LSR_TEMT));
+}
+
+static void uart_buffered_drain(struct uart_buffered *ub)
+{
+	struct uart_ring *rx = &ub->rx;
+	uint32_t lsr;
+
+	while ((lsr = UART_LSR(ub->uart)) & UART_LSR_RDR) {
+		uint8_t data = UART_RBR(ub->uart);
+
+		if (lsr & UART_LSR_ERROR_MASK) {
+			ub->rx_errors++;
+		}
+		if (RING_FREE(rx)) {
+			rx->buf[rx->head & rx->mask] = data;
+			rx->head++;
+		} else {
+			ub->rx_dropped++;
+		}
+	}
+}
+
+/* Interrupt handler, must be called from the UART's ISR. */
+void uart_buffered_isr(struct uart_buffered *ub)
+{
+	uint32_t iir;
+
+	while (!((iir = UART_IIR(ub->uart)) & UART_IIR_INTSTAT_PEND)) {
+		switch (iir & UART_IIR_INTID_MASK) {
+		case UART_IIR_INTID_RLS:
+		case UART_IIR_INTID_RDA:
+		case UART_IIR_INTID_CTI:
+			/* The whole FIFO, not just up to the trigger level */
+			uart_buffered_drain(ub);
+			break;
+		case UART_IIR_INTID_THRE:
+			uart_buffered_fill(ub);
+			if (ub->tx.head == ub->tx.tail) {
+				UART_IER(ub->uart) &= ~UART_IER_THREINT_EN;
+			}
+			break;
+		default:
+			/* Modem status (UART1), not enabled by this driver */
+			return;
+		}
+	}
+}
+
+/* Transmit DMA completion, must be called from dma_isr() when DMA is used. */
+void uart_buffered_dma_isr(struct uart_buffered *ub)
+{
+	if (ub->tx_dma < 0 || !gpdma_tc_flag(ub->tx_dma)) {
+		return;
+	}
+	gpdma_clear_flags(ub->tx_dma);
+	ub->tx.tail += ub->tx_dma_len;
+	ub->tx_dma_len = 0;
+	uart_buffered_dma_next(ub);
+}
@@ -0,0 +1,403 @@
+/** @addtogroup can_file
+
+Buffered CAN: interrupt driven operation on top of the mailbox and FIFO
+functions above.
+
+Frames to send go into a software queue ordered like bus arbitration, by
+identifier with standard before extended and data before remote frames,
+and in submission order among equal identifiers.  The transmit mailbox
+empty interrupt keeps the three mailboxes filled from the head of the
+queue.  When all three are busy and a frame that would win arbitration over
+one of them is queued, that mailbox is aborted and its frame goes back into
+the queue, so a burst of low priority frames can not hold up a high
+priority one.
+
+The message pending interrupts drain both receive FIFOs completely into a
+ring, so a FIFO only has to hold the frames that arrive while the interrupt
+is held off.  Frames lost to a FIFO overrun or to a full ring, bus errors,
+error passive and bus off events are counted in struct can_buffered_stats.
+With time triggered communication mode (ttcm in can_init()) received frames
+carry their timestamp, and so do sent frames handed to the tx_done callback.
+
+can_init() and the filters are set up as before.  can_buffered_isr() must
+be called from every interrupt of the port: usb_hp_can_tx_isr(),
+usb_lp_can_rx0_isr(), can_rx1_isr() and can_sce_isr() on F1 for example.
+
+LGPL License Terms @ref lgpl_license
+*/
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <libopencm3/stm32/can.h>
+#include <libopencm3/cm3/cortex.h>
+
+/**@{*/
+
+static const uint32_t can_mailbox[3] = {CAN_MBOX0, CAN_MBOX1, CAN_MBOX2};
+
+/* Bus arbitration order: base identifier, then SRR/RTR, IDE, extended
+ * identifier and RTR, lower wins.
+ */
+static uint32_t can_arbitration_key(const struct can_frame *f)
+{
+	if (f->ext) {
+		return (((f->id >> 18) & 0x7ff) << 21) | (1 << 20) | (1 << 19) |
+		       ((f->id & 0x3ffff) << 1) | (f->rtr ? 1 : 0);
+	}
+	return ((f->id & 0x7ff) << 21) | (f->rtr ? (1 << 20) : 0);
+}
+
+static bool can_slot_before(const struct can_tx_slot *a,
+			    const struct can_tx_slot *b)
+{
+	if (a->key != b->key) {
+		return a->key < b->key;
+	}
+	return (int32_t)(a->order - b->order) < 0;
+}
+
+static void can_heap_push(struct can_buffered *cb,
+			  const struct can_tx_slot *slot)
+{
+	uint16_t i = cb->tx_count++;
+	uint16_t parent;
+
+	while (i > 0) {
+		parent = (i - 1) / 2;
+		if (!can_slot_before(slot, &cb->tx[parent])) {
+			break;
+		}
+		cb->tx[i] = cb->tx[parent];
+		i = parent;
+	}
+	cb->tx[i] = *slot;
+}
+
+static void can_heap_pop(struct can_buffered *cb)
+{
+	struct can_tx_slot *last = &cb->tx[--cb->tx_count];
+	uint16_t i = 0;
+	uint16_t child;
+
+	while ((child = 2 * i + 1) < cb->tx_count) {
+		if (child + 1 < cb->tx_count &&
+		    can_slot_before(&cb->tx[child + 1], &cb->tx[child])) {
+			child++;
+		}
+		if (!can_slot_before(&cb->tx[child], last)) {
+			break;
+		}
+		cb->tx[i] = cb->tx[child];
+		i = child;
+	}
+	cb->tx[i] = *last;
+}
+
+/* All three mailboxes are busy, abort the lowest priority one if the head
+ * of the queue would beat it.
+ */
+static void can_buffered_preempt(struct can_buffered *cb)
+{
+	int worst = 0;
+	int i;
+
+	if (cb->abort_pending) {
+		return;
+	}
+	for (i = 1; i < 3; i++) {
+		if (can_slot_before(&cb->mailbox[worst], &cb->mailbox[i])) {
+			worst = i;
+		}
+	}
+	if (cb->tx[0].key < cb->mailbox[worst].key) {
+		cb->abort_pending |= 1 << worst;
+		CAN_TSR(cb->canport) = CAN_TSR_ABRQ0 << (8 * worst);
+	}
+}
+
+/* Move frames from the head of the queue into free mailboxes */
+static void can_buffered_refill(struct can_buffered *cb)
+{
+	struct can_tx_slot *head;
+	struct can_frame *f;
+	int mb;
+	int i;
+
+	while (cb->tx_count) {
+		head = &cb->tx[0];
+		if (!can_available_mailbox(cb->canport)) {
+			if (cb->mailbox_busy == 7) {
+				can_buffered_preempt(cb);
+			}
+			return;
+		}
+
+		/* The mailboxes go out by identifier, equal ones by mailbox
+		 * number, so hold a frame back while one with the same key is
+		 * still loaded to keep their order.
+		 */
+		for (i = 0; i < 3; i++) {
+			if ((cb->mailbox_busy & (1 << i)) &&
+			    cb->mailbox[i].key == head->key) {
+				return;
+			}
+		}
+
+		f = &head->frame;
+		mb = can_transmit(cb->canport, f->id, f->ext, f->rtr,
+				  f->length, f->data);
+		if (mb < 0) {
+			return;
+		}
+		cb->mailbox[mb] = *head;
+		cb->mailbox_busy |= 1 << mb;
+		can_heap_pop(cb);
+	}
+}
+
+static void can_buffered_tx_irq(struct can_buffered *cb)
+{
+	uint32_t tsr = CAN_TSR(cb->canport);
+	uint32_t done;
+	struct can_tx_slot *slot;
+	bool aborted;
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		done = tsr >> (8 * i);
+		if (!(done & CAN_TSR_RQCP0)) {
+			continue;
+		}
+		/* Clears RQCP, TXOK, ALST and TERR */
+		CAN_TSR(cb->canport) = CAN_TSR_RQCP0 << (8 * i);
+		if (!(cb->mailbox_busy & (1 << i))) {
+			continue;
+		}
+		/* An aborted mailbox keeps ALST or TERR of an earlier attempt
+		 * with automatic retransmission, so go by our own request.
+		 */
+		aborted = cb->abort_pending & (1 << i);
+		cb->abort_pending &= ~(1 << i);
+		cb->mailbox_busy &= ~(1 << i);
+		slot = &cb->mailbox[i];
+
+		if (done & CAN_TSR_TXOK0) {
+			cb->stats.tx_frames++;
+			slot->frame.timestamp =
+				(CAN_TDTxR(cb->canport, can_mailbox[i]) &
+				 CAN_TDTxR_TIME_MASK) >> CAN_TDTxR_TIME_SHIFT;
+			if (cb->tx_done) {
+				cb->tx_done(&slot->frame);
+			}
+		} else if (!aborted) {
+			/* Only final without automatic retransmission */
+			cb->stats.tx_errors++;
+		} else if (cb->tx_count < cb->tx_size) {
+			/* Aborted for a higher priority frame */
+			cb->stats.tx_preempted++;
+			can_heap_push(cb, slot);
+		} else {
+			cb->stats.tx_dropped++;
+		}
+	}
+	can_buffered_refill(cb);
+}
+
+static void can_buffered_rx_irq(struct can_buffered *cb, uint8_t fifo)
+{
+	volatile uint32_t *rfr = fifo ? &CAN_RF1R(cb->canport) :
+				 &CAN_RF0R(cb->canport);
+	struct can_frame *f;
+
+	if (*rfr & CAN_RF0R_FOVR0) {
+		*rfr = CAN_RF0R_FOVR0;
+		cb->stats.rx_overruns++;
+	}
+
+	while (*rfr & CAN_RF0R_FMP0_MASK) {
+		if ((uint16_t)(cb->rx_head - cb->rx_tail) > cb->rx_mask) {
+			can_fifo_release(cb->canport, fifo);
+			cb->stats.rx_dropped++;
+			continue;
+		}
+		f = &cb->rx[cb->rx_head & cb->rx_mask];
+		can_receive(cb->canport, fifo, true, &f->id, &f->ext, &f->rtr,
+			    &f->fmi, &f->length, f->data, &f->timestamp);
+		cb->rx_head++;
+		cb->stats.rx_frames++;
+	}
+}
+
+static void can_buffered_error_irq(struct can_buffered *cb)
+{
+	uint32_t esr = CAN_ESR(cb->canport);
+	uint8_t lec = (esr & CAN_ESR_LEC_MASK) >> 4;
+	uint8_t flags = esr & (CAN_ESR_BOFF | CAN_ESR_EPVF);
+
+	CAN_MSR(cb->canport) = CAN_MSR_ERRI;
+
+	if (lec != 0 && lec != 7) {
+		cb->stats.bus_errors++;
+		cb->stats.last_error = lec;
+		/* Software code, so the next error is seen as new */
+		CAN_ESR(cb->canport) = CAN_ESR_LEC_SOFT_ERROR;
+	}
+	if ((flags & ~cb->error_flags) & CAN_ESR_BOFF) {
+		cb->stats.bus_off++;
+	}
+	if ((flags & ~cb->error_flags) & CAN_ESR_EPVF) {
+		cb->stats.error_passive++;
+	}
+	cb->error_flags = flags;
+	cb->stats.tec = (esr & CAN_ESR_TEC_MASK) >> CAN_ESR_TEC_SHIFT;
+	cb->stats.rec = (esr & CAN_ESR_REC_MASK) >> CAN_ESR_REC_SHIFT;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Set up buffered operation of an initialised CAN port
+
+Enables the transmit, receive and error interrupts of the port, the NVIC
+side is up to the caller.
+
+@param[in] cb State of the port.
+@param[in] canport CAN block register base @ref can_reg_base.
+@param[in] rxbuf Receive ring.
+@param[in] rxsize Receive ring size in frames, a power of two.
+@param[in] txbuf Transmit queue.
+@param[in] txsize Transmit queue size in frames.
+*/
+void can_buffered_init(struct can_buffered *cb, uint32_t canport,
+		       struct can_frame *rxbuf, uint16_t rxsize,
+		       struct can_tx_slot *txbuf, uint16_t txsize)
+{
+	struct can_buffered_stats zero = { 0 };
+
+	cb->canport = canport;
+	cb->rx = rxbuf;
+	cb->rx_mask = rxsize - 1;
+	cb->rx_head = 0;
+	cb->rx_tail = 0;
+	cb->tx = txbuf;
+	cb->tx_size = txsize;
+	cb->tx_count = 0;
+	cb->tx_order = 0;
+	cb->mailbox_busy = 0;
+	cb->abort_pending = 0;
+	cb->error_flags = 0;
+	cb->stats = zero;
+
+	CAN_ESR(canport) = CAN_ESR_LEC_SOFT_ERROR;
+	can_enable_irq(canport, CAN_IER_TMEIE | CAN_IER_FMPIE0 |
+		       CAN_IER_FOVIE0 | CAN_IER_FMPIE1 | CAN_IER_FOVIE1 |
+		       CAN_IER_ERRIE | CAN_IER_LECIE | CAN_IER_BOFIE |
+		       CAN_IER_EPVIE);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Queue a frame for transmission
+
+@param[in] cb State of the port.
+@param[in] frame Frame to send, copied.
+@returns false if the queue is full.
+*/
+bool can_buffered_send(struct can_buffered *cb, const struct can_frame *frame)
+{
+	struct can_tx_slot slot;
+	bool queued = false;
+
+	slot.frame = *frame;
+	slot.key = can_arbitration_key(frame);
+
+	CM_ATOMIC_BLOCK() {
+		if (cb->tx_count < cb->tx_size) {
+			slot.order = cb->tx_order++;
+			can_heap_push(cb, &slot);
+			can_buffered_refill(cb);
+			queued = true;
+		} else {
+			cb->stats.tx_dropped++;
+		}
+	}
+	return queued;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Take the oldest received frame
+
+@param[in] cb State of the port.
+@param[out] frame Received frame.
+@returns false if no frame was waiting.
+*/
+bool can_buffered_receive(struct can_buffered *cb, struct can_frame *frame)
+{
+	if (cb->rx_head == cb->rx_tail) {
+		return false;
+	}
+	*frame = cb->rx[cb->rx_tail & cb->rx_mask];
+	cb->rx_tail++;
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Number of received frames waiting
+*/
+uint16_t can_buffered_rx_available(struct can_buffered *cb)
+{
+	return cb->rx_head - cb->rx_tail;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Number of frames not sent yet, in the queue and the mailboxes
+*/
+uint16_t can_buffered_tx_pending(struct can_buffered *cb)
+{
+	uint16_t pending;
+
+	CM_ATOMIC_BLOCK() {
+		pending = cb->tx_count +
+			  ((cb->mailbox_busy >> 0) & 1) +
+			  ((cb->mailbox_busy >> 1) & 1) +
+			  ((cb->mailbox_busy >> 2) & 1);
+	}
+	return pending;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Copy the statistics of the port
+*/
+void can_buffered_get_stats(struct can_buffered *cb,
+			    struct can_buffered_stats *stats)
+{
+	CM_ATOMIC_BLOCK() {
+		*stats = cb->stats;
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Interrupt handling, call from every interrupt of the port
+*/
+void can_buffered_isr(struct can_buffered *cb)
+{
+	can_buffered_tx_irq(cb);
+	can_buffered_rx_irq(cb, 0);
+	can_buffered_rx_irq(cb, 1);
+	if (CAN_MSR(cb->canport) & CAN_MSR_ERRI) {
+		can_buffered_error_irq(cb);
+	}
+}
+
+/**@}*/
@@ -0,0 +1,529 @@
+/** @addtogroup can_file
+
+Filter compiler: packs a set of IDs and ID ranges into as few filter banks
+as possible.
+
+Every rule is split into aligned power of two blocks of IDs.  Single IDs go
+into list banks, four standard IDs per 16 bit bank or two extended IDs per
+32 bit bank, blocks into mask banks, two standard blocks per 16 bit bank or
+one extended block per 32 bit bank.  Rules for different FIFOs, ID types
+and ports never share a bank.  CAN1 gets the banks from 0, CAN2 the banks
+from the CAN2SB split on, see can_filter_report.
+
+If the result needs more banks than available, neighbouring blocks are
+merged into the smallest aligned block covering both, always picking the
+merge that lets through the fewest IDs that were not asked for, until the
+banks fit.  The report gives the number of IDs wanted and accepted, and the
+false accept rate, the share of accepted IDs nobody asked for.
+
+The compiler does not touch the hardware, can_filter_apply() programs the
+result in one go.  For fixed ID sets, scripts/can_filter_compile.py runs the
+same algorithm at build time and writes out the bank table.
+
+List banks compare the RTR bit, so they pass data frames only, mask banks
+pass data and remote frames.
+
+LGPL License Terms @ref lgpl_license
+*/
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <libopencm3/stm32/can.h>
+
+/**@{*/
+
+#define CAN_FILTER_GROUPS	8
+#define CAN_FILTER_EXT(g)	((g) & 1)
+#define CAN_FILTER_FIFO(g)	(((g) >> 1) & 1)
+#define CAN_FILTER_PORT(g)	((g) >> 2)
+
+#define CAN_STD_ID_MASK		0x7ff
+#define CAN_EXT_ID_MASK		0x1fffffff
+
+/* Filter register layouts, IDE is always compared */
+#define CAN_F16_STD(id)		((uint32_t)(id) << 5)
+#define CAN_F16_MASK(size)	(((~((size) - 1) & CAN_STD_ID_MASK) << 5) | \
+				 (1 << 3))
+#define CAN_F32_EXT(id)		(((uint32_t)(id) << 3) | (1 << 2))
+#define CAN_F32_MASK(size)	(((~((size) - 1) & CAN_EXT_ID_MASK) << 3) | \
+				 (1 << 2))
+
+struct can_filter_state {
+	struct can_filter_entry *e;
+	uint16_t n;
+	uint16_t size;
+	struct can_filter_bank *banks;
+	uint8_t max;
+	uint8_t used;
+	uint8_t nr;
+	bool overflow;
+};
+
+static bool can_filter_add(struct can_filter_state *st, uint32_t id,
+			   uint32_t size, uint8_t group)
+{
+	if (st->n == st->size) {
+		return false;
+	}
+	st->e[st->n].id = id;
+	st->e[st->n].size = size;
+	st->e[st->n].group = group;
+	st->n++;
+	return true;
+}
+
+/* Split id..last into aligned power of two blocks */
+static bool can_filter_expand(struct can_filter_state *st, uint32_t id,
+			      uint32_t last, uint8_t group)
+{
+	uint32_t size;
+
+	while (id <= last) {
+		size = id ? (id & -id) : (1U << 29);
+		while (size > last - id + 1) {
+			size >>= 1;
+		}
+		if (!can_filter_add(st, id, size, group)) {
+			return false;
+		}
+		if (last - id < size) {
+			break;
+		}
+		id += size;
+	}
+	return true;
+}
+
+static bool can_filter_before(const struct can_filter_entry *a,
+			      const struct can_filter_entry *b)
+{
+	if (a->group != b->group) {
+		return a->group < b->group;
+	}
+	if (a->id != b->id) {
+		return a->id < b->id;
+	}
+	return a->size > b->size;
+}
+
+static void can_filter_sort(struct can_filter_state *st)
+{
+	struct can_filter_entry tmp;
+	uint16_t i, j;
+
+	for (i = 1; i < st->n; i++) {
+		tmp = st->e[i];
+		for (j = i; j > 0 && can_filter_before(&tmp, &st->e[j - 1]);
+		     j--) {
+			st->e[j] = st->e[j - 1];
+		}
+		st->e[j] = tmp;
+	}
+}
+
+/* Drop blocks inside the block before them, aligned blocks nest and the
+ * bigger of two blocks with the same base sorts first.
+ */
+static void can_filter_dedup(struct can_filter_state *st)
+{
+	uint16_t i, out = 0;
+	struct can_filter_entry *prev;
+
+	for (i = 0; i < st->n; i++) {
+		prev = out ? &st->e[out - 1] : NULL;
+		if (prev && prev->group == st->e[i].group &&
+		    st->e[i].id - prev->id < prev->size) {
+			continue;
+		}
+		st->e[out++] = st->e[i];
+	}
+	st->n = out;
+}
+
+/* Banks for s single IDs and m blocks of a standard ID group, singles can
+ * fill up free mask slots.
+ */
+static uint16_t can_filter_std_banks(uint16_t s, uint16_t m, uint16_t *moved)
+{
+	uint16_t k, banks, best = 0xffff;
+
+	for (k = 0; k <= s && k < 4; k++) {
+		banks = (s - k + 3) / 4 + (m + k + 1) / 2;
+		if (banks < best) {
+			best = banks;
+			*moved = k;
+		}
+	}
+	return best;
+}
+
+static uint16_t can_filter_count_banks(uint8_t group, uint16_t s,
+				       uint16_t m, uint16_t *moved)
+{
+	*moved = 0;
+	if (CAN_FILTER_EXT(group)) {
+		return (s + 1) / 2 + m;
+	}
+	return can_filter_std_banks(s, m, moved);
+}
+
+static void can_filter_count(struct can_filter_state *st, uint16_t *s,
+			     uint16_t *m)
+{
+	uint16_t i;
+
+	for (i = 0; i < CAN_FILTER_GROUPS; i++) {
+		s[i] = 0;
+		m[i] = 0;
+	}
+	for (i = 0; i < st->n; i++) {
+		if (st->e[i].size == 1) {
+			s[st->e[i].group]++;
+		} else {
+			m[st->e[i].group]++;
+		}
+	}
+}
+
+static uint32_t can_filter_banks(struct can_filter_state *st)
+{
+	uint16_t s[CAN_FILTER_GROUPS], m[CAN_FILTER_GROUPS], moved;
+	uint32_t total = 0;
+	uint8_t g;
+
+	can_filter_count(st, s, m);
+	for (g = 0; g < CAN_FILTER_GROUPS; g++) {
+		total += can_filter_count_banks(g, s[g], m[g], &moved);
+	}
+	return total;
+}
+
+/* Merge neighbours into one block.  Prefer merges that free a bank, and
+ * among those the one adding the fewest unwanted IDs.
+ */
+static bool can_filter_merge(struct can_filter_state *st)
+{
+	struct can_filter_entry *e = st->e;
+	uint16_t s[CAN_FILTER_GROUPS], m[CAN_FILTER_GROUPS];
+	uint32_t x, size, base, cost, best_cost = 0xffffffff;
+	uint64_t covered;
+	uint16_t i, j0, j1, k, ns, nm, moved, best_j0 = 0, best_j1 = 0;
+	uint32_t best_base = 0, best_size = 0;
+	bool saves, best_saves = false;
+	uint8_t g;
+
+	can_filter_count(st, s, m);
+	for (i = 0; i + 1 < st->n; i++) {
+		g = e[i].group;
+		if (g != e[i + 1].group) {
+			continue;
+		}
+
+		/* Smallest aligned block holding both */
+		x = e[i].id ^ (e[i + 1].id + e[i + 1].size - 1);
+		size = 1;
+		while (x) {
+			x >>= 1;
+			size <<= 1;
+		}
+		base = e[i].id & ~(size - 1);
+
+		j0 = i;
+		while (j0 > 0 && e[j0 - 1].group == g &&
+		       e[j0 - 1].id >= base) {
+			j0--;
+		}
+		j1 = i + 1;
+		while (j1 + 1 < st->n && e[j1 + 1].group == g &&
+		       e[j1 + 1].id - base < size) {
+			j1++;
+		}
+		covered = 0;
+		ns = s[g];
+		nm = m[g] + 1;
+		for (k = j0; k <= j1; k++) {
+			covered += e[k].size;
+			if (e[k].size == 1) {
+				ns--;
+			} else {
+				nm--;
+			}
+		}
+		cost = size - covered;
+		saves = can_filter_count_banks(g, ns, nm, &moved) <
+			can_filter_count_banks(g, s[g], m[g], &moved);
+
+		if (best_saves && !saves) {
+			continue;
+		}
+		if ((saves && !best_saves) || cost < best_cost ||
+		    (cost == best_cost && j1 - j0 > best_j1 - best_j0)) {
+			best_saves = saves;
+			best_cost = cost;
+			best_j0 = j0;
+			best_j1 = j1;
+			best_base = base;
+			best_size = size;
+		}
+	}
+	if (best_cost == 0xffffffff) {
+		return false;
+	}
+
+	e[best_j0].id = best_base;
+	e[best_j0].size = best_size;
+	for (k = best_j1 + 1; k < st->n; k++) {
+		e[k - (best_j1 - best_j0)] = e[k];
+	}
+	st->n -= best_j1 - best_j0;
+	return true;
+}
+
+static void can_filter_emit(struct can_filter_state *st, bool scale_32bit,
+			    bool id_list_mode, uint8_t group, uint32_t fr1,
+			    uint32_t fr2)
+{
+	struct can_filter_bank *b;
+
+	if (st->used >= st->max) {
+		st->overflow = true;
+		return;
+	}
+	b = &st->banks[st->used++];
+	b->nr = st->nr++;
+	b->scale_32bit = scale_32bit;
+	b->id_list_mode = id_list_mode;
+	b->fifo = CAN_FILTER_FIFO(group);
+	b->fr1 = fr1;
+	b->fr2 = fr2;
+}
+
+static void can_filter_emit_std(struct can_filter_state *st, uint8_t group)
+{
+	uint32_t list[4], mask[4];
+	uint16_t s[CAN_FILTER_GROUPS], m[CAN_FILTER_GROUPS];
+	uint16_t moved, nl = 0, nm = 0, i;
+	struct can_filter_entry *e;
+
+	can_filter_count(st, s, m);
+	can_filter_count_banks(group, s[group], m[group], &moved);
+	for (i = 0; i < st->n; i++) {
+		e = &st->e[i];
+		if (e->group != group) {
+			continue;
+		}
+		if (e->size == 1 && moved == 0) {
+			list[nl++] = CAN_F16_STD(e->id);
+			if (nl == 4) {
+				can_filter_emit(st, false, true, group,
+						(list[0] << 16) | list[1],
+						(list[2] << 16) | list[3]);
+				nl = 0;
+			}
+			continue;
+		}
+		if (e->size == 1) {
+			moved--;
+		}
+		mask[nm++] = (CAN_F16_MASK(e->size) << 16) | CAN_F16_STD(e->id);
+		if (nm == 2) {
+			can_filter_emit(st, false, false, group, mask[0],
+					mask[1]);
+			nm = 0;
+		}
+	}
+	if (nl) {
+		for (i = nl; i < 4; i++) {
+			list[i] = list[0];
+		}
+		can_filter_emit(st, false, true, group,
+				(list[0] << 16) | list[1],
+				(list[2] << 16) | list[3]);
+	}
+	if (nm) {
+		can_filter_emit(st, false, false, group, mask[0], mask[0]);
+	}
+}
+
+static void can_filter_emit_ext(struct can_filter_state *st, uint8_t group)
+{
+	uint32_t list[2];
+	uint16_t nl = 0, i;
+	struct can_filter_entry *e;
+
+	for (i = 0; i < st->n; i++) {
+		e = &st->e[i];
+		if (e->group != group) {
+			continue;
+		}
+		if (e->size > 1) {
+			can_filter_emit(st, true, false, group,
+					CAN_F32_EXT(e->id),
+					CAN_F32_MASK(e->size));
+			continue;
+		}
+		list[nl++] = CAN_F32_EXT(e->id);
+		if (nl == 2) {
+			can_filter_emit(st, true, true, group, list[0],
+					list[1]);
+			nl = 0;
+		}
+	}
+	if (nl) {
+		can_filter_emit(st, true, true, group, list[0], list[0]);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Compile accepted IDs into filter banks
+
+@param[in] rules IDs and ranges to accept.
+@param[in] count Number of rules.
+@param[in] work Scratch space, one entry per aligned block of the rules.  A
+single ID takes one entry, a range at most 2 per ID bit.
+@param[in] work_size Number of scratch entries.
+@param[out] banks Filter banks, max_banks entries.
+@param[in] max_banks Banks available, 14 on single CAN parts and 28 on
+parts with CAN2.
+@param[out] report Result summary, may be NULL.
+@returns Number of banks used, -1 if the scratch space is too small or
+the rules do not fit in max_banks.
+*/
+int can_filter_compile(const struct can_filter_rule *rules, uint16_t count,
+		       struct can_filter_entry *work, uint16_t work_size,
+		       struct can_filter_bank *banks, uint8_t max_banks,
+		       struct can_filter_report *report)
+{
+	struct can_filter_state st = {
+		.e = work,
+		.size = work_size,
+		.banks = banks,
+		.max = max_banks,
+	};
+	const struct can_filter_rule *r;
+	uint32_t mask, wanted = 0;
+	uint64_t accepted = 0;
+	uint8_t g, port, can2_start = max_banks;
+	uint16_t i;
+
+	for (i = 0; i < count; i++) {
+		r = &rules[i];
+		mask = r->ext ? CAN_EXT_ID_MASK : CAN_STD_ID_MASK;
+		if (r->id > r->last || r->last > mask) {
+			return -1;
+		}
+		g = (r->port ? 4 : 0) | (r->fifo ? 2 : 0) | (r->ext ? 1 : 0);
+		if (!can_filter_expand(&st, r->id, r->last, g)) {
+			return -1;
+		}
+	}
+	can_filter_sort(&st);
+	can_filter_dedup(&st);
+	for (i = 0; i < st.n; i++) {
+		wanted += st.e[i].size;
+	}
+
+	while (can_filter_banks(&st) > max_banks) {
+		if (!can_filter_merge(&st)) {
+			return -1;
+		}
+	}
+
+	for (port = 0; port < 2; port++) {
+		/* Groups are sorted, CAN2 blocks come last */
+		if (port == 1 && st.n &&
+		    CAN_FILTER_PORT(st.e[st.n - 1].group)) {
+			can2_start = st.used;
+		}
+		for (g = port * 4; g < port * 4 + 4; g++) {
+			if (CAN_FILTER_EXT(g)) {
+				can_filter_emit_ext(&st, g);
+			} else {
+				can_filter_emit_std(&st, g);
+			}
+		}
+	}
+	if (st.overflow) {
+		return -1;
+	}
+
+	if (report) {
+		for (i = 0; i < st.n; i++) {
+			accepted += st.e[i].size;
+		}
+		report->banks = st.used;
+		report->can2_start = can2_start;
+		report->wanted = wanted;
+		report->accepted = accepted;
+		report->false_accept_permille = accepted ?
+			(accepted - wanted) * 1000 / accepted : 0;
+	}
+	return st.used;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Program compiled filter banks
+
+All other banks are switched off.  On parts with CAN2, the filter banks are
+split between the ports at can2_start.
+
+@param[in] banks Banks from can_filter_compile() or the build time table.
+@param[in] count Number of banks.
+@param[in] can2_start CAN2SB from the report, 0xff on parts without CAN2.
+*/
+void can_filter_apply(const struct can_filter_bank *banks, uint8_t count,
+		      uint8_t can2_start)
+{
+	uint32_t bit, active = 0;
+	uint8_t i;
+
+	CAN_FMR(CAN1) |= CAN_FMR_FINIT;
+	CAN_FA1R(CAN1) = 0;
+
+	if (can2_start != 0xff) {
+		CAN_FMR(CAN1) = (CAN_FMR(CAN1) & ~CAN_FMR_CAN2SB_MASK) |
+				((uint32_t)can2_start << CAN_FMR_CAN2SB_SHIFT);
+	}
+
+	for (i = 0; i < count; i++) {
+		bit = 1UL << banks[i].nr;
+		if (banks[i].scale_32bit) {
+			CAN_FS1R(CAN1) |= bit;
+		} else {
+			CAN_FS1R(CAN1) &= ~bit;
+		}
+		if (banks[i].id_list_mode) {
+			CAN_FM1R(CAN1) |= bit;
+		} else {
+			CAN_FM1R(CAN1) &= ~bit;
+		}
+		if (banks[i].fifo) {
+			CAN_FFA1R(CAN1) |= bit;
+		} else {
+			CAN_FFA1R(CAN1) &= ~bit;
+		}
+		CAN_FiR1(CAN1, banks[i].nr) = banks[i].fr1;
+		CAN_FiR2(CAN1, banks[i].nr) = banks[i].fr2;
+		active |= bit;
+	}
+
+	CAN_FA1R(CAN1) = active;
+	CAN_FMR(CAN1) &= ~CAN_FMR_FINIT;
+}
+
+/**@}*/
@@ -8,6 +8,35 @@
  *
  * @date 5 Feb 2014
  *
+ * The CRS trims HSI48 against a reference: USB start of frame packets at
+ * 1kHz, LSE or a clock on the CRS_SYNC pin.  crs_configure() sets up any
+ * of them, crs_autotrim_usb_enable() is the short form for USB:
+ *
+ * @code
+ *	struct crs_config usb = {
+ *		.syncsrc = CRS_CFGR_SYNCSRC_USB_SOF,
+ *		.syncdiv = CRS_CFGR_SYNCDIV_NODIV,
+ *		.reload = CRS_RELOAD(48000000, 1000),
+ *		.felim = CRS_FELIM(48000000, 1000),
+ *	};
+ *
+ *	crs_configure(&usb);
+ *	crs_set_tracking(true);
+ * @endcode
+ *
+ * With tracking, every sync event raises an interrupt and
+ * crs_handle_interrupt(), called from rcc_isr() on F0 and L0 and from the
+ * CRS vector elsewhere, records its outcome, the frequency error measured
+ * and the trim value.  That is one interrupt per millisecond with USB, turn
+ * tracking off once the figures are known.  The error is counted in HSI48
+ * cycles per sync period, positive when HSI48 runs fast; one trim step is
+ * about twice the error limit.
+ *
+ * Once crs_is_locked(), HSI48 is within one trim step of the reference
+ * and can clock peripherals that need an accurate clock, e.g. a USART at
+ * high baud rates.  crs_get_frequency() gives the measured frequency to
+ * derive their dividers from.
+ *
  * LGPL License Terms @ref lgpl_license
  */
 
@@ -28,6 +57,7 @@
  * along with this library.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <libopencm3/cm3/cortex.h>
 #include <libopencm3/stm32/crs.h>
 #include <libopencm3/stm32/rcc.h>
 
@@ -46,3 +76,166 @@ void crs_autotrim_usb_enable(void)
 	CRS_CR |= CRS_CR_CEN;
 }
 
+
+static struct crs_stats crs_stats;
+
+/**
+ * Start trimming HSI48 against a sync source.
+ * The sync pin has to be set to its alternate function for GPIO sync.
+ * @param config sync source, divider, polarity, reload and error limit
+ */
+void crs_configure(const struct crs_config *config)
+{
+	rcc_periph_clock_enable(RCC_CRS);
+
+	CRS_CR &= ~(CRS_CR_CEN | CRS_CR_AUTOTRIMEN);
+	CRS_CFGR = config->syncsrc | config->syncdiv |
+		   (config->falling ? CRS_CFGR_SYNCPOL : 0) |
+		   CRS_CFGR_FELIM_VAL(config->felim) |
+		   CRS_CFGR_RELOAD_VAL(config->reload);
+	CRS_ICR = CRS_ICR_ESYNCC | CRS_ICR_ERRC | CRS_ICR_SYNCWARNC |
+		  CRS_ICR_SYNCOKC;
+
+	CRS_CR |= CRS_CR_AUTOTRIMEN;
+	CRS_CR |= CRS_CR_CEN;
+}
+
+/**
+ * Stop trimming, HSI48 keeps the last trim value.
+ */
+void crs_disable(void)
+{
+	CRS_CR &= ~(CRS_CR_CEN | CRS_CR_AUTOTRIMEN | CRS_CR_ERRIE |
+		    CRS_CR_SYNCWARNIE | CRS_CR_SYNCOKIE);
+}
+
+/**
+ * Switch the per sync interrupts for crs_handle_interrupt() on or off.
+ * The interrupt has to be enabled in the NVIC as well.
+ * @param enable true to track every sync event
+ */
+void crs_set_tracking(bool enable)
+{
+	const uint32_t irqs = CRS_CR_ERRIE | CRS_CR_SYNCWARNIE |
+			      CRS_CR_SYNCOKIE;
+
+	if (enable) {
+		CRS_ICR = CRS_ICR_ERRC | CRS_ICR_SYNCWARNC | CRS_ICR_SYNCOKC;
+		CRS_CR |= irqs;
+	} else {
+		CRS_CR &= ~irqs;
+	}
+}
+
+/**
+ * Record the sync events pending.
+ * Call from the interrupt handler of the CRS.
+ */
+void crs_handle_interrupt(void)
+{
+	uint32_t isr = CRS_ISR;
+	uint8_t trim = (CRS_CR & CRS_CR_TRIM) >> CRS_CR_TRIM_SHIFT;
+	int32_t error;
+
+	CRS_ICR = isr & (CRS_ICR_ESYNCC | CRS_ICR_ERRC | CRS_ICR_SYNCWARNC |
+			 CRS_ICR_SYNCOKC);
+
+	if (isr & CRS_ISR_ERRF) {
+		if (isr & CRS_ISR_SYNCERR) {
+			crs_stats.sync_err++;
+		}
+		if (isr & CRS_ISR_SYNCMISS) {
+			crs_stats.sync_miss++;
+		}
+		if (isr & CRS_ISR_TRIMOVF) {
+			crs_stats.trim_ovf++;
+		}
+		crs_stats.locked = 0;
+	}
+	if (!(isr & (CRS_ISR_SYNCOOKF | CRS_ISR_SYNCWARNF))) {
+		return;
+	}
+
+	/* Counting down at the sync means HSI48 was slow */
+	error = (isr & CRS_ISR_FECAP) >> CRS_ISR_FECAP_SHIFT;
+	if (isr & CRS_ISR_FEDIR) {
+		error = -error;
+	}
+
+	if (isr & CRS_ISR_SYNCWARNF) {
+		crs_stats.sync_warn++;
+		crs_stats.locked = 0;
+	} else {
+		crs_stats.sync_ok++;
+		crs_stats.locked++;
+	}
+	if (crs_stats.sync_ok + crs_stats.sync_warn == 1) {
+		crs_stats.min_error = error;
+		crs_stats.max_error = error;
+		crs_stats.min_trim = trim;
+		crs_stats.max_trim = trim;
+	}
+	if (error < crs_stats.min_error) {
+		crs_stats.min_error = error;
+	}
+	if (error > crs_stats.max_error) {
+		crs_stats.max_error = error;
+	}
+	if (trim < crs_stats.min_trim) {
+		crs_stats.min_trim = trim;
+	}
+	if (trim > crs_stats.max_trim) {
+		crs_stats.max_trim = trim;
+	}
+	crs_stats.last_error = error;
+	crs_stats.error_sum += error;
+	crs_stats.trim = trim;
+}
+
+/**
+ * Read the tracking counters.
+ * @param stats sync outcomes, frequency errors and trim values
+ */
+void crs_get_stats(struct crs_stats *stats)
+{
+	CM_ATOMIC_BLOCK() {
+		*stats = crs_stats;
+	}
+}
+
+/**
+ * Clear the tracking counters.
+ */
+void crs_reset_stats(void)
+{
+	CM_ATOMIC_BLOCK() {
+		crs_stats = (struct crs_stats) { 0 };
+	}
+}
+
+/**
+ * Check if HSI48 follows the sync source.
+ * Needs tracking, see crs_set_tracking().
+ * @param syncs number of syncs in a row that have to be within the error
+ * limit
+ * @returns true if the last syncs were
+ */
+bool crs_is_locked(uint32_t syncs)
+{
+	return crs_stats.locked >= syncs;
+}
+
+/**
+ * Measured HSI48 frequency.
+ * Scales 48MHz by the last frequency error over the reload value, with
+ * tracking on.
+ * @returns HSI48 frequency in Hz, 48MHz before the first sync
+ */
+uint32_t crs_get_frequency(void)
+{
+	uint32_t cycles = ((CRS_CFGR & CRS_CFGR_RELOAD) >>
+			   CRS_CFGR_RELOAD_SHIFT) + 1;
+	int32_t error = crs_stats.last_error;
+
+	return (uint32_t)(48000000 + (int64_t)48000000 * error / cycles);
+}
@@ -0,0 +1,177 @@
+/** @addtogroup exti_file
+
+EXTI dispatcher: per line callbacks behind the shared EXTI vectors.
+
+Lines 5 to 9 and 10 to 15 (4 to 15, 0 and 1, 2 and 3 on F0 and L0) share an
+interrupt vector, so the handler has to find out which lines fired.  With
+the dispatcher, the vector handler is one call:
+
+@code
+void exti9_5_isr(void)
+{
+	exti_dispatch(EXTI_LINES(5, 9));
+}
+@endcode
+
+exti_dispatch() takes the pending lines of its vector from EXTI_PR in one
+read, clears them in one write and runs the callbacks with a count leading
+zeros loop, highest line first, so the line number is the priority among
+lines of one vector.  Edges arriving while callbacks run are left pending
+and tail chain into the next dispatch, the loop never goes back to EXTI_PR.
+
+The callback of line n runs at most
+    exception entry (12 cycles on M3/M4) + wait for higher priority IRQs
+    + dispatch overhead + callbacks of the lines above n pending together
+after the edge was synchronised, and it is blocked by a single pass of its
+own vector only.  With exti_set_timestamping() the DWT cycle counter is read
+on dispatch entry and handed to the callbacks as edge timestamp, and the
+cycles from there to each callback are kept per line, see
+exti_get_line_stats().  ARMv6-M parts have no cycle counter, timestamps and
+latencies read 0 there.
+
+LGPL License Terms @ref lgpl_license
+*/
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/cm3/dwt.h>
+#include <libopencm3/stm32/exti.h>
+
+/**@{*/
+
+static struct {
+	exti_callback_t callback;
+	void *arg;
+} exti_lines[EXTI_DISPATCH_LINES];
+
+static struct exti_line_stats exti_stats[EXTI_DISPATCH_LINES];
+static bool exti_timestamping;
+
+/*---------------------------------------------------------------------------*/
+/** @brief Set the callback of an EXTI line
+
+Register the callback before exti_enable_request() on the line.  A line
+without callback is cleared and ignored by exti_dispatch().
+
+@param[in] line Line number, 0 to 31.
+@param[in] callback Called from exti_dispatch() with the line, the timestamp
+and arg, NULL to remove.
+@param[in] arg Passed to the callback.
+*/
+void exti_set_callback(uint8_t line, exti_callback_t callback, void *arg)
+{
+	if (line >= EXTI_DISPATCH_LINES) {
+		return;
+	}
+	CM_ATOMIC_BLOCK() {
+		exti_lines[line].callback = callback;
+		exti_lines[line].arg = arg;
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Switch edge timestamps and latency measurement on or off
+
+Starts the DWT cycle counter if needed.
+
+@param[in] enable true to timestamp edges.
+@returns false if the core has no cycle counter.
+*/
+bool exti_set_timestamping(bool enable)
+{
+	if (enable && !dwt_enable_cycle_counter()) {
+		exti_timestamping = false;
+		return false;
+	}
+	exti_timestamping = enable;
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Run the callbacks of pending lines
+
+Call from the EXTI vector handlers with the lines the vector serves.
+
+@param[in] lines Lines of the calling vector, see EXTI_LINES().
+*/
+void exti_dispatch(uint32_t lines)
+{
+	uint32_t stamp = 0, latency, pending;
+	struct exti_line_stats *st;
+	uint8_t line;
+
+	if (exti_timestamping) {
+		stamp = dwt_read_cycle_counter();
+	}
+
+	pending = EXTI_PR & EXTI_IMR & lines;
+	EXTI_PR = pending;
+
+	while (pending) {
+		line = 31 - __builtin_clz(pending);
+		pending &= ~(1UL << line);
+
+		if (!exti_lines[line].callback) {
+			continue;
+		}
+
+		st = &exti_stats[line];
+		if (exti_timestamping) {
+			latency = dwt_read_cycle_counter() - stamp;
+			st->last_latency = latency;
+			if (latency > st->max_latency) {
+				st->max_latency = latency;
+			}
+		}
+		st->count++;
+		exti_lines[line].callback(line, stamp, exti_lines[line].arg);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Read the counters of a line
+
+@param[in] line Line number, 0 to 31.
+@param[out] stats Callbacks run and latencies from dispatch entry.
+*/
+void exti_get_line_stats(uint8_t line, struct exti_line_stats *stats)
+{
+	if (line >= EXTI_DISPATCH_LINES) {
+		return;
+	}
+	CM_ATOMIC_BLOCK() {
+		*stats = exti_stats[line];
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Clear the counters of all lines */
+void exti_reset_line_stats(void)
+{
+	uint8_t i;
+
+	CM_ATOMIC_BLOCK() {
+		for (i = 0; i < EXTI_DISPATCH_LINES; i++) {
+			exti_stats[i].count = 0;
+			exti_stats[i].last_latency = 0;
+			exti_stats[i].max_latency = 0;
+		}
+	}
+}
+
+/**@}*/
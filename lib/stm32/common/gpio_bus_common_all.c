@@ -0,0 +1,162 @@
+/** @addtogroup gpio_file
+
+Parallel buses on GPIO pins.
+
+A bus of up to 16 bits can sit on any pins of one port, in any order.
+gpio_bus_init() turns the pin list into four tables, one per nibble of the
+bus value, so writing a value takes up to four table loads and a single
+write to the set/reset register: all bus pins change on the same bus cycle
+and pins outside the bus are never touched, also when an interrupt handler
+drives them at the same time.
+
+For streaming, gpio_bus_encode() converts a buffer of bus values to
+set/reset words ahead of time, which DMA can feed to BSRR paced by a timer
+on parts with a stream DMA (gpio_bus_dma_start()).  A bus owning a whole
+port can skip the encoding and stream to ODR.
+
+LGPL License Terms @ref lgpl_license
+*/
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <libopencm3/stm32/gpio.h>
+
+/**@{*/
+
+/*---------------------------------------------------------------------------*/
+/** @brief Set up a Parallel Bus
+
+The pins are not configured, set them up as outputs with gpio_mode_setup()
+or gpio_set_mode() first.
+
+@param[out] bus Bus to set up.
+@param[in] gpioport Unsigned int32. Port identifier @ref gpio_port_id
+@param[in] pins Pin number (0 to 15) of each bus bit, least significant
+first.
+@param[in] width Number of bus bits, 1 to 16.
+*/
+void gpio_bus_init(struct gpio_bus *bus, uint32_t gpioport,
+		   const uint8_t *pins, uint8_t width)
+{
+	uint8_t bit, nibble, value;
+	uint16_t set;
+
+	if (width > 16) {
+		width = 16;
+	}
+	bus->port = gpioport;
+	bus->width = width;
+	bus->mask = 0;
+
+	for (bit = 0; bit < width; bit++) {
+		bus->pins[bit] = pins[bit] & 15;
+		bus->mask |= 1 << bus->pins[bit];
+	}
+
+	for (nibble = 0; nibble < 4; nibble++) {
+		for (value = 0; value < 16; value++) {
+			set = 0;
+			for (bit = 0; bit < 4; bit++) {
+				if ((value & (1 << bit)) &&
+				    nibble * 4 + bit < width) {
+					set |= 1 << bus->pins[nibble * 4 + bit];
+				}
+			}
+			bus->map[nibble][value] = set;
+		}
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Set/reset Word of a Bus Value
+
+@param[in] bus Bus from gpio_bus_init().
+@param[in] value Bus value.
+@return Word for the set/reset register of the bus port.
+*/
+uint32_t gpio_bus_bsrr(const struct gpio_bus *bus, uint16_t value)
+{
+	uint32_t set;
+
+	set = bus->map[0][value & 15] | bus->map[1][(value >> 4) & 15];
+	if (bus->width > 8) {
+		set |= bus->map[2][(value >> 8) & 15] |
+		       bus->map[3][value >> 12];
+	}
+	return GPIO_BSRR_MASKED((uint32_t)bus->mask, set);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Write a Value to a Bus Atomic
+
+@param[in] bus Bus from gpio_bus_init().
+@param[in] value Bus value.
+*/
+void gpio_bus_write(const struct gpio_bus *bus, uint16_t value)
+{
+	GPIO_BSRR(bus->port) = gpio_bus_bsrr(bus, value);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Read a Value from a Bus
+
+The pins are sampled in a single read of the input register.
+
+@param[in] bus Bus from gpio_bus_init().
+@return Bus value.
+*/
+uint16_t gpio_bus_read(const struct gpio_bus *bus)
+{
+	uint16_t port = gpio_port_read(bus->port), value = 0;
+	uint8_t bit;
+
+	for (bit = 0; bit < bus->width; bit++) {
+		if (port & (1 << bus->pins[bit])) {
+			value |= 1 << bit;
+		}
+	}
+	return value;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Convert Bus Values to Set/reset Words
+
+@param[in] bus Bus from gpio_bus_init().
+@param[in] values Bus values, bytes for buses of up to 8 bits, halfwords for
+wider buses.
+@param[out] bsrr Set/reset words, count entries.
+@param[in] count Number of values.
+*/
+void gpio_bus_encode(const struct gpio_bus *bus, const void *values,
+		     uint32_t *bsrr, uint32_t count)
+{
+	const uint8_t *v8 = values;
+	const uint16_t *v16 = values;
+	uint32_t i;
+
+	if (bus->width > 8) {
+		for (i = 0; i < count; i++) {
+			bsrr[i] = gpio_bus_bsrr(bus, v16[i]);
+		}
+	} else {
+		for (i = 0; i < count; i++) {
+			bsrr[i] = gpio_bus_bsrr(bus, v8[i]);
+		}
+	}
+}
+
+/**@}*/
@@ -0,0 +1,151 @@
+/** @addtogroup gpio_file
+
+Timer paced bus output on the stream DMA of F2 and F4 parts.
+
+Every update event of the timer makes the DMA copy one word to the bus
+port, so a buffer goes out at timer clock / ((prescaler + 1) * (period + 1))
+without the CPU.  Only DMA2 can reach the GPIO ports, take a stream and
+channel of the update request of the pacing timer, e.g. TIM1_UP on DMA2
+stream 5 channel 6 or TIM8_UP on DMA2 stream 1 channel 7.
+
+@code
+	gpio_bus_encode(&lcd, pixels, words, n);
+	gpio_bus_dma_start(&lcd, GPIO_BUS_BSRR, words, n, false,
+			   DMA2, DMA_STREAM5, DMA_SxCR_CHSEL_6);
+	gpio_bus_timer_start(TIM1, 0, 15);
+@endcode
+
+Each word takes a few AHB cycles and competes with other DMA2 traffic, keep
+the period above that so no update event is missed.  A strobe line can come
+from a PWM channel of the same timer.
+
+LGPL License Terms @ref lgpl_license
+*/
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <libopencm3/stm32/dma.h>
+#include <libopencm3/stm32/gpio.h>
+#include <libopencm3/stm32/timer.h>
+
+/**@{*/
+
+/*---------------------------------------------------------------------------*/
+/** @brief Start Streaming to a Bus
+
+The stream waits for the update requests of the timer, start it with
+gpio_bus_timer_start() afterwards.
+
+@param[in] bus Bus from gpio_bus_init().
+@param[in] target GPIO_BUS_BSRR for words from gpio_bus_encode(),
+GPIO_BUS_ODR for whole port values.
+@param[in] data Words or port values, count entries.
+@param[in] count Number of entries, 1 to 65535.
+@param[in] circular Repeat the buffer until gpio_bus_dma_stop().
+@param[in] dma DMA controller, DMA2.
+@param[in] stream Stream of the timer update request.
+@param[in] channel Channel of the timer update request, DMA_SxCR_CHSEL_x.
+*/
+void gpio_bus_dma_start(const struct gpio_bus *bus, enum gpio_bus_target target,
+			const void *data, uint16_t count, bool circular,
+			uint32_t dma, uint8_t stream, uint32_t channel)
+{
+	dma_stream_reset(dma, stream);
+	dma_channel_select(dma, stream, channel);
+	dma_set_priority(dma, stream, DMA_SxCR_PL_VERY_HIGH);
+	dma_set_transfer_mode(dma, stream, DMA_SxCR_DIR_MEM_TO_PERIPHERAL);
+	dma_set_memory_address(dma, stream, (uint32_t)data);
+	dma_set_number_of_data(dma, stream, count);
+	dma_enable_memory_increment_mode(dma, stream);
+
+	if (target == GPIO_BUS_BSRR) {
+		dma_set_peripheral_address(dma, stream,
+					   (uint32_t)&GPIO_BSRR(bus->port));
+		dma_set_peripheral_size(dma, stream, DMA_SxCR_PSIZE_32BIT);
+		dma_set_memory_size(dma, stream, DMA_SxCR_MSIZE_32BIT);
+	} else {
+		dma_set_peripheral_address(dma, stream,
+					   (uint32_t)&GPIO_ODR(bus->port));
+		dma_set_peripheral_size(dma, stream, DMA_SxCR_PSIZE_16BIT);
+		dma_set_memory_size(dma, stream, DMA_SxCR_MSIZE_16BIT);
+	}
+
+	if (circular) {
+		dma_enable_circular_mode(dma, stream);
+	}
+	dma_enable_stream(dma, stream);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Stop Streaming to a Bus
+
+The bus keeps the last value written.
+
+@param[in] dma DMA controller.
+@param[in] stream Stream passed to gpio_bus_dma_start().
+*/
+void gpio_bus_dma_stop(uint32_t dma, uint8_t stream)
+{
+	dma_disable_stream(dma, stream);
+	while (DMA_SCR(dma, stream) & DMA_SxCR_EN);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Check if a Bus Stream is Running
+
+@param[in] dma DMA controller.
+@param[in] stream Stream passed to gpio_bus_dma_start().
+@return true until the last entry is written, always for circular streams.
+*/
+bool gpio_bus_dma_busy(uint32_t dma, uint8_t stream)
+{
+	return DMA_SCR(dma, stream) & DMA_SxCR_EN;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Start the Pacing Timer
+
+Runs the timer up counting with update DMA requests.  The timer clock must
+be enabled.
+
+@param[in] timer Timer register address base.
+@param[in] prescaler Timer clock divider minus one.
+@param[in] period Timer counts per bus word minus one.
+*/
+void gpio_bus_timer_start(uint32_t timer, uint32_t prescaler,
+			  uint32_t period)
+{
+	timer_disable_counter(timer);
+	timer_set_prescaler(timer, prescaler);
+	timer_set_period(timer, period);
+	timer_set_counter(timer, 0);
+	timer_enable_irq(timer, TIM_DIER_UDE);
+	timer_enable_counter(timer);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Stop the Pacing Timer
+
+@param[in] timer Timer register address base.
+*/
+void gpio_bus_timer_stop(uint32_t timer)
+{
+	timer_disable_counter(timer);
+	timer_disable_irq(timer, TIM_DIER_UDE);
+}
+
+/**@}*/
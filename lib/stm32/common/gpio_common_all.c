@@ -23,6 +23,9 @@
  * along with this library.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+/* gpio_set() and gpio_clear() are always exported */
+#undef CM3_INLINE_ACCESSORS
+
 #include <libopencm3/stm32/gpio.h>
 
 /**@{*/
@@ -116,6 +119,23 @@ void gpio_port_write(uint32_t gpioport, uint16_t data)
 	GPIO_ODR(gpioport) = data;
 }
 
+/*---------------------------------------------------------------------------*/
+/** @brief Write to a Group of Pins Atomic
+
+Set the given pins of the port to the matching bits of data in one write to
+the set/reset register, the other pins are not affected.
+
+@param[in] gpioport Unsigned int32. Port identifier @ref gpio_port_id
+@param[in] gpios Unsigned int16. Pin identifiers @ref gpio_pin_id
+	     If multiple pins are to be changed, use bitwise OR '|' to separate
+	     them.
+@param[in] data Unsigned int16. Pin values, bit positions as in gpios.
+*/
+void gpio_port_write_masked(uint32_t gpioport, uint16_t gpios, uint16_t data)
+{
+	GPIO_BSRR(gpioport) = GPIO_BSRR_MASKED((uint32_t)gpios, data);
+}
+
 /*---------------------------------------------------------------------------*/
 /** @brief Lock the Configuration of a Group of Pins
 
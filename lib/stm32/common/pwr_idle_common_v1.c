@@ -0,0 +1,375 @@
+/** @addtogroup pwr_file
+
+Idle manager: picks the deepest low power mode the running drivers allow.
+
+Drivers register a struct pwr_idle_constraint while they need something:
+the longest wake up latency they can take, bus clocks (a transfer is going
+on, only Sleep is possible) or the main regulator.  The idle loop calls
+pwr_idle() with the time until the next wake up event it expects, for
+example the next RTC alarm:
+
+@code
+	while (1) {
+		run_ready_tasks();
+		pwr_idle(next_alarm_us());
+	}
+@endcode
+
+pwr_idle() takes the deepest mode, not deeper than pwr_idle_set_deepest()
+(Stop with low power regulator by default, Standby loses RAM and has to be
+allowed explicitly), whose wake up latency fits every constraint and is
+shorter than the idle time.  The latencies are estimates set with
+pwr_idle_set_latency(), by default 2, 50, 150 and 500us for Sleep, Stop,
+Stop with low power regulator and Standby, datasheet values of F4 parts
+rounded up for the PLL to lock again.
+
+Leaving Stop, the clock falls back to HSI (MSI on L0 and L1, with HSI16
+off).  pwr_idle() saves RCC_CR and RCC_CFGR before and only switches the
+oscillators and PLL back on, waits for each to be ready and restores the
+clock selection after, the PLL configuration, prescalers and flash wait
+states are kept through Stop, so the full rcc_clock_setup_xxx() is not
+needed.  On F4 this is rcc_clock_save() and rcc_clock_restore(), which also
+bring back the I2S and SAI PLLs.  Interrupts are held off until the clocks
+are back, so handlers always run at full speed.
+
+Every mode counts its entries, its time spent if the manager has a clock
+running through Stop (pwr_idle_set_clock(), e.g. the RTC or LPTIM) and the
+core cycles from wake up to clocks restored, where the core has a cycle
+counter.
+
+LGPL License Terms @ref lgpl_license
+*/
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/cm3/dwt.h>
+#include <libopencm3/cm3/scb.h>
+#include <libopencm3/stm32/pwr.h>
+#include <libopencm3/stm32/rcc.h>
+
+/**@{*/
+
+static struct pwr_idle_constraint *pwr_idle_constraints;
+static uint32_t pwr_idle_latency[PWR_IDLE_MODES] = { 2, 50, 150, 500 };
+static enum pwr_idle_mode pwr_idle_deepest = PWR_IDLE_STOP_LP;
+static uint32_t (*pwr_idle_now)(void);
+static struct pwr_idle_stats pwr_idle_stats[PWR_IDLE_MODES];
+
+/*---------------------------------------------------------------------------*/
+/** @brief Register an Idle Constraint
+
+The constraint is read at every pwr_idle(), it can be changed in place
+while registered.
+
+@param[in] constraint Constraint, must stay valid until removed.
+*/
+void pwr_idle_add_constraint(struct pwr_idle_constraint *constraint)
+{
+	CM_ATOMIC_BLOCK() {
+		constraint->next = pwr_idle_constraints;
+		pwr_idle_constraints = constraint;
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Remove an Idle Constraint
+
+@param[in] constraint Constraint from pwr_idle_add_constraint().
+*/
+void pwr_idle_remove_constraint(struct pwr_idle_constraint *constraint)
+{
+	struct pwr_idle_constraint **p;
+
+	CM_ATOMIC_BLOCK() {
+		for (p = &pwr_idle_constraints; *p; p = &(*p)->next) {
+			if (*p == constraint) {
+				*p = constraint->next;
+				break;
+			}
+		}
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Set the Wake Up Latency of a Mode
+
+@param[in] mode Low power mode.
+@param[in] latency_us Wake up to clocks restored, in microseconds.
+*/
+void pwr_idle_set_latency(enum pwr_idle_mode mode, uint32_t latency_us)
+{
+	if (mode < PWR_IDLE_MODES) {
+		pwr_idle_latency[mode] = latency_us;
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Limit the Idle Modes
+
+Sleep keeps the debugger connected, Standby wakes up through a reset and
+only makes sense for applications that save their state.
+
+@param[in] mode Deepest mode pwr_idle() may use.
+*/
+void pwr_idle_set_deepest(enum pwr_idle_mode mode)
+{
+	if (mode < PWR_IDLE_MODES) {
+		pwr_idle_deepest = mode;
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Set the Clock for Residency Counting
+
+@param[in] now_us Microsecond time that keeps running in Stop, NULL to stop
+counting.
+*/
+void pwr_idle_set_clock(uint32_t (*now_us)(void))
+{
+	pwr_idle_now = now_us;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Pick the Idle Mode
+
+@param[in] idle_us Time until the next expected wake up, 0xffffffff if none.
+@returns Deepest mode allowed by the constraints.
+*/
+enum pwr_idle_mode pwr_idle_select(uint32_t idle_us)
+{
+	struct pwr_idle_constraint *c;
+	uint32_t max_latency = 0xffffffff, needs = 0;
+	int mode = pwr_idle_deepest;
+
+	for (c = pwr_idle_constraints; c; c = c->next) {
+		if (c->max_latency_us && c->max_latency_us < max_latency) {
+			max_latency = c->max_latency_us;
+		}
+		needs |= c->needs;
+	}
+
+	if (needs & PWR_IDLE_NEED_CLOCKS) {
+		return PWR_IDLE_SLEEP;
+	}
+	if ((needs & PWR_IDLE_NEED_REGULATOR) && mode > PWR_IDLE_STOP) {
+		mode = PWR_IDLE_STOP;
+	}
+	for (; mode > PWR_IDLE_SLEEP; mode--) {
+		if (pwr_idle_latency[mode] <= max_latency &&
+		    pwr_idle_latency[mode] < idle_us) {
+			break;
+		}
+	}
+	return mode;
+}
+
+static void pwr_idle_wfi(void)
+{
+	__asm__ volatile ("DSB\nWFI\nISB\n");
+}
+
+#if defined(STM32F4)
+
+struct pwr_idle_clocks {
+	struct rcc_clock_state state;
+};
+
+static void pwr_idle_save_clocks(struct pwr_idle_clocks *clocks)
+{
+	rcc_clock_save(&clocks->state);
+}
+
+static void pwr_idle_restore_clocks(const struct pwr_idle_clocks *clocks)
+{
+	rcc_clock_restore(&clocks->state);
+}
+
+#else
+
+#if defined(RCC_CR_HSI16ON)
+#define PWR_IDLE_HSION		RCC_CR_HSI16ON
+#define PWR_IDLE_HSIRDY		RCC_CR_HSI16RDY
+#else
+#define PWR_IDLE_HSION		RCC_CR_HSION
+#define PWR_IDLE_HSIRDY		RCC_CR_HSIRDY
+#endif
+
+#if defined(RCC_CR_MSION)
+#define PWR_IDLE_WAKEUP_CLOCKS	(PWR_IDLE_HSION | RCC_CR_MSION)
+#else
+#define PWR_IDLE_WAKEUP_CLOCKS	PWR_IDLE_HSION
+#endif
+
+struct pwr_idle_clocks {
+	uint32_t cr;
+	uint32_t cfgr;
+};
+
+static void pwr_idle_save_clocks(struct pwr_idle_clocks *clocks)
+{
+	clocks->cr = RCC_CR;
+	clocks->cfgr = RCC_CFGR;
+}
+
+static void pwr_idle_osc_on(uint32_t cr, uint32_t on, uint32_t rdy)
+{
+	if (cr & on) {
+		RCC_CR |= on;
+		while (!(RCC_CR & rdy));
+	}
+}
+
+static void pwr_idle_restore_clocks(const struct pwr_idle_clocks *clocks)
+{
+	uint32_t cr = clocks->cr, cfgr = clocks->cfgr;
+
+	/* PLL inputs first, HSI feeds the PLL in the L1 setups */
+	pwr_idle_osc_on(cr, PWR_IDLE_HSION, PWR_IDLE_HSIRDY);
+#if defined(RCC_CR_MSION)
+	pwr_idle_osc_on(cr, RCC_CR_MSION, RCC_CR_MSIRDY);
+#endif
+	pwr_idle_osc_on(cr, RCC_CR_HSEON, RCC_CR_HSERDY);
+	pwr_idle_osc_on(cr, RCC_CR_PLLON, RCC_CR_PLLRDY);
+
+	RCC_CFGR = cfgr;
+	while (((RCC_CFGR >> RCC_CFGR_SWS_SHIFT) & 3) != (cfgr & 3));
+
+	/* Wake up clock off again if it was not running before */
+	RCC_CR &= ~(~cr & PWR_IDLE_WAKEUP_CLOCKS);
+}
+
+#endif
+
+static uint32_t pwr_idle_stop(bool low_power_regulator)
+{
+	struct pwr_idle_clocks clocks;
+	uint32_t start;
+
+	pwr_idle_save_clocks(&clocks);
+	pwr_set_stop_mode();
+	if (low_power_regulator) {
+		pwr_voltage_regulator_low_power_in_stop();
+	} else {
+		pwr_voltage_regulator_on_in_stop();
+	}
+	pwr_clear_wakeup_flag();
+
+	SCB_SCR |= SCB_SCR_SLEEPDEEP;
+	pwr_idle_wfi();
+	SCB_SCR &= ~SCB_SCR_SLEEPDEEP;
+
+	start = dwt_read_cycle_counter();
+	pwr_idle_restore_clocks(&clocks);
+	return dwt_read_cycle_counter() - start;
+}
+
+static void pwr_idle_standby(void)
+{
+	pwr_clear_wakeup_flag();
+	pwr_set_standby_mode();
+	SCB_SCR |= SCB_SCR_SLEEPDEEP;
+	while (1) {
+		pwr_idle_wfi();
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Idle until the Next Interrupt
+
+Call from the idle loop with interrupts enabled.  The interrupt that wakes
+the core runs after the clocks are restored, before pwr_idle() returns.  A
+wake up source has to be set up for Stop, an EXTI line or RTC alarm, and
+for Standby the wakeup pin or RTC.
+
+@param[in] idle_us Time until the next expected wake up, 0xffffffff if none.
+@returns Mode used.  Never returns from Standby.
+*/
+enum pwr_idle_mode pwr_idle(uint32_t idle_us)
+{
+	enum pwr_idle_mode mode = PWR_IDLE_SLEEP;
+	struct pwr_idle_stats *st;
+	uint32_t start = 0, cycles = 0;
+
+	CM_ATOMIC_BLOCK() {
+		mode = pwr_idle_select(idle_us);
+		st = &pwr_idle_stats[mode];
+		st->entries++;
+		if (pwr_idle_now) {
+			start = pwr_idle_now();
+		}
+
+		switch (mode) {
+		case PWR_IDLE_SLEEP:
+			SCB_SCR &= ~SCB_SCR_SLEEPDEEP;
+			pwr_idle_wfi();
+			break;
+		case PWR_IDLE_STOP:
+			cycles = pwr_idle_stop(false);
+			break;
+		case PWR_IDLE_STOP_LP:
+			cycles = pwr_idle_stop(true);
+			break;
+		default:
+			pwr_idle_standby();
+			break;
+		}
+
+		if (pwr_idle_now) {
+			st->residency_us += pwr_idle_now() - start;
+		}
+		st->last_restore_cycles = cycles;
+		if (cycles > st->max_restore_cycles) {
+			st->max_restore_cycles = cycles;
+		}
+	}
+	return mode;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Read the Counters of a Mode
+
+@param[in] mode Low power mode.
+@param[out] stats Entries, time spent and clock restore cycles.
+*/
+void pwr_idle_get_stats(enum pwr_idle_mode mode, struct pwr_idle_stats *stats)
+{
+	if (mode >= PWR_IDLE_MODES) {
+		return;
+	}
+	CM_ATOMIC_BLOCK() {
+		*stats = pwr_idle_stats[mode];
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Clear the Counters of all Modes */
+void pwr_idle_reset_stats(void)
+{
+	uint8_t i;
+
+	CM_ATOMIC_BLOCK() {
+		for (i = 0; i < PWR_IDLE_MODES; i++) {
+			pwr_idle_stats[i].entries = 0;
+			pwr_idle_stats[i].residency_us = 0;
+			pwr_idle_stats[i].last_restore_cycles = 0;
+			pwr_idle_stats[i].max_restore_cycles = 0;
+		}
+	}
+}
+
+/**@}*/
@@ -0,0 +1,549 @@
+/** @addtogroup quadspi_file
+ *
+ * This library supports the Quad SPI flash interface (QUADSPI) in the
+ * STM32F4 and STM32F7 series of ARM Cortex Microcontrollers by ST
+ * Microelectronics.
+ *
+ * Every flash access is described by a @ref quadspi_command, which holds the
+ * instruction and the width and size of the address, alternate byte, dummy
+ * and data phases.  The same description is used for all four functional
+ * modes of the controller:
+ *
+ * @li indirect mode, polled: quadspi_command(), quadspi_read(),
+ * quadspi_write()
+ * @li indirect mode, DMA: quadspi_read_dma(), quadspi_write_dma(), completion
+ * is checked with quadspi_transfer_done() or waited for with quadspi_wait()
+ * @li automatic status polling: quadspi_autopoll() lets the controller read
+ * the flash status register until the masked value matches, so program and
+ * erase completion need no CPU loop.  With the interrupt enabled, call
+ * quadspi_autopoll_matched() from quadspi_isr().
+ * @li memory mapped mode: quadspi_memory_map() maps the flash at
+ * QUADSPI_BANK for reads and execute in place.  It is left with
+ * quadspi_abort().
+ *
+ * A typical quad read, 0xEB on most NOR parts, looks like
+ * @code
+ * static const struct quadspi_command fast_read = {
+ *	.instruction = 0xEB,
+ *	.instruction_mode = QUADSPI_CCR_MODE_1LINE,
+ *	.address_mode = QUADSPI_CCR_MODE_4LINE,
+ *	.address_size = 3,
+ *	.alternate_mode = QUADSPI_CCR_MODE_4LINE,
+ *	.alternate_size = 1,
+ *	.alternate = 0xff,
+ *	.dummy_cycles = 4,
+ *	.data_mode = QUADSPI_CCR_MODE_4LINE,
+ * };
+ *
+ * quadspi_read_dma(&fast_read, 0, buf, sizeof(buf), QUADSPI_DMA,
+ *		    QUADSPI_DMA_STREAM, QUADSPI_DMA_CHANNEL);
+ * quadspi_wait();
+ * @endcode
+ *
+ * On the F7 the data cache is not maintained by this driver: DMA buffers
+ * must be cleaned before a write and invalidated after a read, or live in
+ * non cacheable memory.  The MPU should also cover the part of QUADSPI_BANK
+ * beyond the flash size, speculative accesses there stall the bus.
+ *
+ * <b>Indirect DMA versus memory mapped reads</b>
+ *
+ * With the 0xEB command above, every transfer the controller starts costs
+ * 8 instruction, 6 address, 2 alternate and 4 dummy clocks before the first
+ * data byte, and each byte then takes 2 clocks.  An indirect DMA read pays
+ * the 20 clocks once per call, a 4 KiB read runs at 99% of the bus rate and
+ * the CPU is free while it runs.  In memory mapped mode the controller
+ * restarts the command whenever the CPU or cache asks for an address that
+ * does not follow the last one.  Sequential accesses are served from the
+ * prefetch and run at the bus rate like DMA, but a random 32 byte cache line
+ * fill is 64 data clocks plus 20 overhead clocks, 76% of the bus rate, and
+ * the requesting master stalls for all of it.  Setting instruction_once with
+ * a part in continuous read mode drops the 8 instruction clocks, 84%.  Bulk
+ * loads of assets are therefore best done with DMA into RAM, code and data
+ * that are walked through as they are used stay memory mapped.
+ *
+ * The numbers depend on the part, the clock and the bus load, so measure on
+ * the target with the cycle counter, for example:
+ * @code
+ * dwt_enable_cycle_counter();
+ * t0 = dwt_read_cycle_counter();
+ * quadspi_read_dma(&fast_read, 0, buf, len, QUADSPI_DMA,
+ *		    QUADSPI_DMA_STREAM, QUADSPI_DMA_CHANNEL);
+ * quadspi_wait();
+ * t_dma = dwt_read_cycle_counter() - t0;
+ *
+ * quadspi_memory_map(&fast_read, 0);
+ * t0 = dwt_read_cycle_counter();
+ * memcpy(buf, (void *)QUADSPI_BANK, len);
+ * t_mm = dwt_read_cycle_counter() - t0;
+ * quadspi_abort();
+ * @endcode
+ * Run each case with the caches invalidated first, and repeat the memory
+ * mapped case with random line sized reads to see the restart overhead.
+ *
+ * LGPL License Terms @ref lgpl_license
+ */
+
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <libopencm3/stm32/quadspi.h>
+#include <libopencm3/stm32/dma.h>
+
+/**@{*/
+
+#define QUADSPI_FCR_ALL		(QUADSPI_FCR_CTOF | QUADSPI_FCR_CSMF | \
+				 QUADSPI_FCR_CTCF | QUADSPI_FCR_CTEF)
+
+/* Stream used by the running DMA transfer, dma is 0 if there is none */
+static struct {
+	uint32_t dma;
+	uint8_t stream;
+} quadspi_dma;
+
+static uint32_t quadspi_ccr(const struct quadspi_command *cmd, uint32_t fmode)
+{
+	uint32_t ccr;
+
+	ccr = (fmode << QUADSPI_CCR_FMODE_SHIFT) |
+	      ((uint32_t)cmd->instruction << QUADSPI_CCR_INST_SHIFT) |
+	      ((cmd->instruction_mode & QUADSPI_CCR_IMODE_MASK) <<
+	       QUADSPI_CCR_IMODE_SHIFT) |
+	      ((cmd->address_mode & QUADSPI_CCR_ADMODE_MASK) <<
+	       QUADSPI_CCR_ADMODE_SHIFT) |
+	      ((cmd->alternate_mode & QUADSPI_CCR_ABMODE_MASK) <<
+	       QUADSPI_CCR_ABMODE_SHIFT) |
+	      ((cmd->dummy_cycles & QUADSPI_CCR_DCYC_MASK) <<
+	       QUADSPI_CCR_DCYC_SHIFT) |
+	      ((cmd->data_mode & QUADSPI_CCR_DMODE_MASK) <<
+	       QUADSPI_CCR_DMODE_SHIFT);
+
+	if (cmd->address_mode != QUADSPI_CCR_MODE_NONE) {
+		ccr |= ((cmd->address_size - 1) & QUADSPI_CCR_ADSIZE_MASK) <<
+		       QUADSPI_CCR_ADSIZE_SHIFT;
+	}
+	if (cmd->alternate_mode != QUADSPI_CCR_MODE_NONE) {
+		ccr |= ((cmd->alternate_size - 1) & QUADSPI_CCR_ABSIZE_MASK) <<
+		       QUADSPI_CCR_ABSIZE_SHIFT;
+	}
+	if (cmd->ddr) {
+		ccr |= QUADSPI_CCR_DDRM;
+	}
+	if (cmd->instruction_once) {
+		ccr |= QUADSPI_CCR_SIOO;
+	}
+	return ccr;
+}
+
+static void quadspi_set_fifo_threshold(uint8_t bytes)
+{
+	QUADSPI_CR = (QUADSPI_CR &
+		      ~(QUADSPI_CR_FTHRES_MASK << QUADSPI_CR_FTHRES_SHIFT)) |
+		     ((uint32_t)(bytes - 1) << QUADSPI_CR_FTHRES_SHIFT);
+}
+
+/* Program the command and start it.  Reads and commands without data start
+ * here, writes start once the first data is in the FIFO.
+ */
+static void quadspi_start(const struct quadspi_command *cmd, uint32_t fmode,
+			  uint32_t address, uint32_t len)
+{
+	while (QUADSPI_SR & QUADSPI_SR_BUSY);
+
+	QUADSPI_FCR = QUADSPI_FCR_ALL;
+	if (cmd->data_mode != QUADSPI_CCR_MODE_NONE) {
+		QUADSPI_DLR = len - 1;
+	}
+	if (cmd->alternate_mode != QUADSPI_CCR_MODE_NONE) {
+		QUADSPI_ABR = cmd->alternate;
+	}
+	QUADSPI_CCR = quadspi_ccr(cmd, fmode);
+	if (cmd->address_mode != QUADSPI_CCR_MODE_NONE) {
+		QUADSPI_AR = address;
+	}
+}
+
+static bool quadspi_finish(void)
+{
+	while (!(QUADSPI_SR & (QUADSPI_SR_TCF | QUADSPI_SR_TEF)));
+
+	if (QUADSPI_SR & QUADSPI_SR_TEF) {
+		quadspi_abort();
+		return false;
+	}
+	QUADSPI_FCR = QUADSPI_FCR_CTCF;
+	return true;
+}
+
+static bool quadspi_dma_words(const void *buf, uint32_t len)
+{
+	return !((uintptr_t)buf & 3) && !(len & 3);
+}
+
+static bool quadspi_dma_fits(const void *buf, uint32_t len)
+{
+	return len && (quadspi_dma_words(buf, len) ? len / 4 : len) <= 0xffff;
+}
+
+static void quadspi_dma_setup(void *buf, uint32_t len, uint32_t dma,
+			      uint8_t stream, uint32_t channel, bool to_flash)
+{
+	bool words = quadspi_dma_words(buf, len);
+	uint32_t count = words ? len / 4 : len;
+
+	dma_stream_reset(dma, stream);
+	dma_channel_select(dma, stream, channel);
+	dma_set_priority(dma, stream, DMA_SxCR_PL_VERY_HIGH);
+	dma_set_transfer_mode(dma, stream, to_flash ?
+			      DMA_SxCR_DIR_MEM_TO_PERIPHERAL :
+			      DMA_SxCR_DIR_PERIPHERAL_TO_MEM);
+	dma_set_peripheral_address(dma, stream, (uint32_t)&QUADSPI_DR);
+	dma_set_memory_address(dma, stream, (uint32_t)buf);
+	dma_set_number_of_data(dma, stream, count);
+	dma_enable_memory_increment_mode(dma, stream);
+	if (words) {
+		dma_set_peripheral_size(dma, stream, DMA_SxCR_PSIZE_32BIT);
+		dma_set_memory_size(dma, stream, DMA_SxCR_MSIZE_32BIT);
+	} else {
+		dma_set_peripheral_size(dma, stream, DMA_SxCR_PSIZE_8BIT);
+		dma_set_memory_size(dma, stream, DMA_SxCR_MSIZE_8BIT);
+	}
+
+	/* One DMA request per data item */
+	quadspi_set_fifo_threshold(words ? 4 : 1);
+
+	quadspi_dma.dma = dma;
+	quadspi_dma.stream = stream;
+	dma_enable_stream(dma, stream);
+	QUADSPI_CR |= QUADSPI_CR_DMAEN;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Initialise the QUADSPI controller
+
+The controller is disabled while it is set up, and enabled on return.  The
+QUADSPI clock must already be enabled in the RCC.
+
+@param[in] prescaler Kernel clock divider minus one, 0..255.
+@param[in] flash_size_log2 Flash size as a power of two, 24 for 16 MiB.
+@param[in] cs_high_cycles Minimum chip select high time between commands,
+1..8 clocks.
+@param[in] clock_mode_3 Clock idles high (mode 3) instead of low (mode 0).
+*/
+void quadspi_init(uint8_t prescaler, uint8_t flash_size_log2,
+		  uint8_t cs_high_cycles, bool clock_mode_3)
+{
+	QUADSPI_CR &= ~QUADSPI_CR_EN;
+	while (QUADSPI_SR & QUADSPI_SR_BUSY);
+
+	QUADSPI_CR = (uint32_t)prescaler << QUADSPI_CR_PRESCALE_SHIFT;
+	QUADSPI_DCR = (((uint32_t)(flash_size_log2 - 1) &
+			QUADSPI_DCR_FSIZE_MASK) << QUADSPI_DCR_FSIZE_SHIFT) |
+		      (((uint32_t)(cs_high_cycles - 1) &
+			QUADSPI_DCR_CSHT_MASK) << QUADSPI_DCR_CSHT_SHIFT) |
+		      (clock_mode_3 ? QUADSPI_DCR_CKMODE : 0);
+	QUADSPI_FCR = QUADSPI_FCR_ALL;
+	QUADSPI_CR |= QUADSPI_CR_EN;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Abort the current operation
+
+Stops any indirect, polling or memory mapped operation, and the DMA stream of
+a running DMA transfer.  This is the only way out of memory mapped mode.
+*/
+void quadspi_abort(void)
+{
+	QUADSPI_CR |= QUADSPI_CR_ABORT;
+	while (QUADSPI_CR & QUADSPI_CR_ABORT);
+
+	QUADSPI_CR &= ~(QUADSPI_CR_DMAEN | QUADSPI_CR_SMIE | QUADSPI_CR_TCEN);
+	if (quadspi_dma.dma) {
+		dma_disable_stream(quadspi_dma.dma, quadspi_dma.stream);
+		quadspi_dma.dma = 0;
+	}
+	QUADSPI_FCR = QUADSPI_FCR_ALL;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Check whether the controller is busy
+
+@returns true while an operation runs or data is left in the FIFO.
+*/
+bool quadspi_busy(void)
+{
+	return QUADSPI_SR & QUADSPI_SR_BUSY;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Check for completion of a DMA transfer
+
+Non blocking.  Once the transfer has finished on the bus and the FIFO has
+been drained, DMA requests are turned off again.
+
+@returns true if no DMA transfer is running any more.
+*/
+bool quadspi_transfer_done(void)
+{
+	if (QUADSPI_SR & QUADSPI_SR_BUSY) {
+		return false;
+	}
+	QUADSPI_CR &= ~QUADSPI_CR_DMAEN;
+	QUADSPI_FCR = QUADSPI_FCR_CTCF;
+	quadspi_dma.dma = 0;
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Wait for a DMA transfer to finish
+*/
+void quadspi_wait(void)
+{
+	while (!quadspi_transfer_done());
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Send a command without data phase
+
+For write enable, erase commands and the like.
+
+@param[in] cmd Command, data_mode must be QUADSPI_CCR_MODE_NONE.
+@param[in] address Used if the command has an address phase.
+@returns false on a transfer error.
+*/
+bool quadspi_command(const struct quadspi_command *cmd, uint32_t address)
+{
+	if (cmd->data_mode != QUADSPI_CCR_MODE_NONE) {
+		return false;
+	}
+	quadspi_start(cmd, QUADSPI_CCR_FMODE_IWRITE, address, 0);
+	return quadspi_finish();
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Read from the flash, polled
+
+@param[in] cmd Read command.
+@param[in] address Flash address, used if the command has an address phase.
+@param[out] buf Destination.
+@param[in] len Number of bytes, at least 1.
+@returns false on a transfer error.
+*/
+bool quadspi_read(const struct quadspi_command *cmd, uint32_t address,
+		  void *buf, uint32_t len)
+{
+	uint8_t *p = buf;
+
+	if (len == 0) {
+		return false;
+	}
+	quadspi_set_fifo_threshold(1);
+	quadspi_start(cmd, QUADSPI_CCR_FMODE_IREAD, address, len);
+	while (len--) {
+		while (!(QUADSPI_SR & (QUADSPI_SR_FTF | QUADSPI_SR_TEF)));
+		if (QUADSPI_SR & QUADSPI_SR_TEF) {
+			quadspi_abort();
+			return false;
+		}
+		*p++ = QUADSPI_BYTE_DR;
+	}
+	return quadspi_finish();
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Write to the flash, polled
+
+The write enable command and the wait for completion, see quadspi_autopoll(),
+are up to the caller.
+
+@param[in] cmd Program command.
+@param[in] address Flash address, used if the command has an address phase.
+@param[in] buf Source.
+@param[in] len Number of bytes, at least 1.
+@returns false on a transfer error.
+*/
+bool quadspi_write(const struct quadspi_command *cmd, uint32_t address,
+		   const void *buf, uint32_t len)
+{
+	const uint8_t *p = buf;
+
+	if (len == 0) {
+		return false;
+	}
+	quadspi_set_fifo_threshold(1);
+	quadspi_start(cmd, QUADSPI_CCR_FMODE_IWRITE, address, len);
+	while (len--) {
+		while (!(QUADSPI_SR & (QUADSPI_SR_FTF | QUADSPI_SR_TEF)));
+		if (QUADSPI_SR & QUADSPI_SR_TEF) {
+			quadspi_abort();
+			return false;
+		}
+		QUADSPI_BYTE_DR = *p++;
+	}
+	return quadspi_finish();
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Start a DMA read from the flash
+
+Returns once the transfer has been started.  Word aligned buffers with a
+length that is a multiple of 4 are moved a word at a time, anything else a
+byte at a time.  Completion is checked with quadspi_transfer_done(), or with
+the transfer complete interrupt of the DMA stream.
+
+@param[in] cmd Read command.
+@param[in] address Flash address, used if the command has an address phase.
+@param[out] buf Destination.
+@param[in] len Number of bytes, at most 65535 DMA items.
+@param[in] dma DMA controller, QUADSPI_DMA.
+@param[in] stream DMA stream, QUADSPI_DMA_STREAM.
+@param[in] channel DMA channel select, QUADSPI_DMA_CHANNEL.
+@returns false if the length can not be transferred in one go.
+*/
+bool quadspi_read_dma(const struct quadspi_command *cmd, uint32_t address,
+		      void *buf, uint32_t len, uint32_t dma, uint8_t stream,
+		      uint32_t channel)
+{
+	if (!quadspi_dma_fits(buf, len)) {
+		return false;
+	}
+
+	while (QUADSPI_SR & QUADSPI_SR_BUSY);
+
+	quadspi_dma_setup(buf, len, dma, stream, channel, false);
+	quadspi_start(cmd, QUADSPI_CCR_FMODE_IREAD, address, len);
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Start a DMA write to the flash
+
+As quadspi_read_dma(), the other way round.  The write enable command and the
+wait for the program operation are up to the caller.
+
+@param[in] cmd Program command.
+@param[in] address Flash address, used if the command has an address phase.
+@param[in] buf Source.
+@param[in] len Number of bytes, at most 65535 DMA items.
+@param[in] dma DMA controller, QUADSPI_DMA.
+@param[in] stream DMA stream, QUADSPI_DMA_STREAM.
+@param[in] channel DMA channel select, QUADSPI_DMA_CHANNEL.
+@returns false if the length can not be transferred in one go.
+*/
+bool quadspi_write_dma(const struct quadspi_command *cmd, uint32_t address,
+		       const void *buf, uint32_t len, uint32_t dma,
+		       uint8_t stream, uint32_t channel)
+{
+	if (!quadspi_dma_fits(buf, len)) {
+		return false;
+	}
+
+	quadspi_start(cmd, QUADSPI_CCR_FMODE_IWRITE, address, len);
+	quadspi_dma_setup((void *)buf, len, dma, stream, channel, true);
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Start automatic status polling
+
+The controller sends @p cmd every @p interval clocks and compares the
+@p size status bytes it reads under @p mask with @p match.  It stops on the
+first match, for example for a NOR status register read (0x05) with mask 0x01
+and match 0x00 to wait for the end of a program or erase.
+
+@param[in] cmd Status read command, with a data phase.
+@param[in] size Number of status bytes, 1..4.
+@param[in] mask Status bits to compare.
+@param[in] match Expected value of the masked bits.
+@param[in] interval Clocks between two polls.
+@param[in] irq Enable the status match interrupt, quadspi_isr() then calls
+quadspi_autopoll_matched().
+@returns false if the command has no data phase or the size is invalid.
+*/
+bool quadspi_autopoll(const struct quadspi_command *cmd, uint8_t size,
+		      uint32_t mask, uint32_t match, uint16_t interval,
+		      bool irq)
+{
+	if (cmd->data_mode == QUADSPI_CCR_MODE_NONE || size < 1 || size > 4) {
+		return false;
+	}
+
+	while (QUADSPI_SR & QUADSPI_SR_BUSY);
+
+	QUADSPI_PSMKR = mask;
+	QUADSPI_PSMAR = match;
+	QUADSPI_PIR = interval;
+	QUADSPI_CR = (QUADSPI_CR & ~QUADSPI_CR_PMM) | QUADSPI_CR_APMS |
+		     (irq ? QUADSPI_CR_SMIE : 0);
+	quadspi_start(cmd, QUADSPI_CCR_FMODE_APOLL, 0, size);
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Check for the end of automatic status polling
+
+Non blocking, clears the match flag and the match interrupt.
+
+@returns true once the status matched.
+*/
+bool quadspi_autopoll_matched(void)
+{
+	if (!(QUADSPI_SR & QUADSPI_SR_SMF)) {
+		return false;
+	}
+	QUADSPI_CR &= ~QUADSPI_CR_SMIE;
+	QUADSPI_FCR = QUADSPI_FCR_CSMF;
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Enter memory mapped mode
+
+From here on, reads from QUADSPI_BANK issue @p cmd.  The controller keeps
+prefetching after each access while the chip select is low, with a non zero
+@p timeout it releases the chip select after that many clocks without an
+access, which saves power on the flash at the cost of a full command for the
+next access.
+
+@param[in] cmd Read command, with an address and a data phase.
+@param[in] timeout Clocks until the chip select is released, 0 to never
+release it.
+@returns false if the command can not be memory mapped.
+*/
+bool quadspi_memory_map(const struct quadspi_command *cmd, uint16_t timeout)
+{
+	if (cmd->address_mode == QUADSPI_CCR_MODE_NONE ||
+	    cmd->data_mode == QUADSPI_CCR_MODE_NONE) {
+		return false;
+	}
+
+	while (QUADSPI_SR & QUADSPI_SR_BUSY);
+
+	if (timeout) {
+		QUADSPI_LPTR = timeout;
+		QUADSPI_CR |= QUADSPI_CR_TCEN;
+	} else {
+		QUADSPI_CR &= ~QUADSPI_CR_TCEN;
+	}
+	if (cmd->alternate_mode != QUADSPI_CCR_MODE_NONE) {
+		QUADSPI_ABR = cmd->alternate;
+	}
+	QUADSPI_FCR = QUADSPI_FCR_ALL;
+	QUADSPI_CCR = quadspi_ccr(cmd, QUADSPI_CCR_FMODE_MEMMAP);
+	return true;
+}
+
+/**@}*/
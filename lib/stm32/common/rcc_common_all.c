@@ -19,8 +19,11 @@
  */
 /**@{*/
 
+#include <libopencm3/cm3/cortex.h>
 #include <libopencm3/stm32/rcc.h>
 
+static struct rcc_dvfs_notifier *rcc_dvfs_notifiers;
+
 /*---------------------------------------------------------------------------*/
 /** @brief RCC Enable Peripheral Clocks.
  *
@@ -257,6 +260,56 @@ void rcc_osc_bypass_disable(enum rcc_osc osc)
 	}
 }
 
+/**
+ * Register a frequency change notifier.
+ * Drivers that derive dividers from rcc_ahb_frequency, rcc_apb1_frequency
+ * or rcc_apb2_frequency (USART baud rate, timer prescalers, SysTick reload)
+ * recompute them on RCC_DVFS_POST_CHANGE, and can pause transfers on
+ * RCC_DVFS_PRE_CHANGE, around every rcc_dvfs_set_level().
+ * @param notifier notifier, must stay valid until removed
+ */
+void rcc_dvfs_add_notifier(struct rcc_dvfs_notifier *notifier)
+{
+	CM_ATOMIC_BLOCK() {
+		notifier->next = rcc_dvfs_notifiers;
+		rcc_dvfs_notifiers = notifier;
+	}
+}
+
+/**
+ * Remove a frequency change notifier.
+ * @param notifier notifier from rcc_dvfs_add_notifier()
+ */
+void rcc_dvfs_remove_notifier(struct rcc_dvfs_notifier *notifier)
+{
+	struct rcc_dvfs_notifier **p;
+
+	CM_ATOMIC_BLOCK() {
+		for (p = &rcc_dvfs_notifiers; *p; p = &(*p)->next) {
+			if (*p == notifier) {
+				*p = notifier->next;
+				break;
+			}
+		}
+	}
+}
+
+/**
+ * Call the frequency change notifiers.
+ * Used by rcc_dvfs_set_level() before and after the change.
+ * @param event RCC_DVFS_PRE_CHANGE or RCC_DVFS_POST_CHANGE
+ * @param level level being switched to
+ */
+void rcc_dvfs_notify(enum rcc_dvfs_event event,
+		     const struct rcc_dvfs_level *level)
+{
+	struct rcc_dvfs_notifier *n;
+
+	for (n = rcc_dvfs_notifiers; n; n = n->next) {
+		n->callback(event, level, n->arg);
+	}
+}
+
 /**@}*/
 
 #undef _RCC_REG
@@ -0,0 +1,644 @@
+/** @addtogroup sdio_file
+ *
+ * SD memory card driver for the SDIO host of the STM32F2, STM32F4 and the
+ * SDMMC host of the STM32F7.
+ *
+ * sdio_card_init() powers the bus up, identifies the card, switches it to
+ * the 4 bit bus and, where the card supports it, to high speed mode.  Reads
+ * and writes use CMD18/CMD25 for more than one block, and move the data
+ * with a DMA stream in peripheral flow control mode, so the SDIO decides
+ * when the transfer ends.  With hardware flow control enabled, the card
+ * clock is stopped instead of over- or underrunning the FIFO when the DMA
+ * falls behind.
+ *
+ * The host clock, GPIOs and DMA controller clock must be set up by the
+ * caller, and the card must have been powered for at least 1ms.
+ *
+ * sdio_read_block() and sdio_write_block() work on the last initialised
+ * card and match the callbacks of usb_msc_init(), or the disk functions of
+ * a FAT layer:
+ * @code
+ * static struct sdio_card card = {
+ *	.dma = SDIO_DMA,
+ *	.dma_stream = SDIO_DMA_STREAM,
+ *	.dma_channel = SDIO_DMA_CHANNEL,
+ * };
+ *
+ * if (sdio_card_init(&card, 48000000, true) == SDIO_OK) {
+ *	usb_msc_init(usbd_dev, 0x82, 64, 0x01, 64, "VendorID", "ProductID",
+ *		     "0.00", card.block_count, sdio_read_block,
+ *		     sdio_write_block);
+ * }
+ * @endcode
+ *
+ * @note The STM32F40x/41x errata sheet lists clock glitches with hardware
+ * flow control enabled; pass false for hw_flow_control on those parts.
+ *
+ * LGPL License Terms @ref lgpl_license
+ */
+
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <libopencm3/stm32/sdio.h>
+#include <libopencm3/stm32/dma.h>
+
+/**@{*/
+
+#define SDIO_ICR_STATIC		(SDIO_ICR_CEATAENDC | SDIO_ICR_SDIOITC | \
+				 SDIO_ICR_DBCKENDC | SDIO_ICR_STBITERRC | \
+				 SDIO_ICR_DATAENDC | SDIO_ICR_CMDSENTC | \
+				 SDIO_ICR_CMDRENDC | SDIO_ICR_RXOVERRC | \
+				 SDIO_ICR_TXUNDERRC | SDIO_ICR_DTIMEOUTC | \
+				 SDIO_ICR_CTIMEOUTC | SDIO_ICR_DCRCFAILC | \
+				 SDIO_ICR_CCRCFAILC)
+
+#define SDIO_STA_DATA_ERRORS	(SDIO_STA_STBITERR | SDIO_STA_RXOVERR | \
+				 SDIO_STA_TXUNDERR | SDIO_STA_DTIMEOUT | \
+				 SDIO_STA_DCRCFAIL)
+
+/* Response types */
+#define SDIO_R1			(SDIO_CMD_WAITRESP_SHORT)
+#define SDIO_R2			(SDIO_CMD_WAITRESP_LONG)
+
+/* R1 card status */
+#define SD_R1_ERRORS		0xfdffe008
+#define SD_R1_READY_FOR_DATA	(1 << 8)
+#define SD_R1_STATE(r1)		(((r1) >> 9) & 0xf)
+#define SD_STATE_TRAN		4
+
+/* OCR */
+#define SD_OCR_BUSY		(1U << 31)
+#define SD_OCR_HCS		(1 << 30)
+#define SD_OCR_VOLTAGE_WINDOW	0x00ff8000
+
+#define SD_ACMD41_TRIES		4000
+#define SD_PROGRAM_TRIES	(1 << 20)
+
+#define SD_INIT_CLOCK		400000
+#define SD_DEFAULT_CLOCK	25000000
+#define SD_HIGH_SPEED_CLOCK	50000000
+
+static struct sdio_card *sdio_default_card;
+
+/* Bounce buffer for block transfers from and to unaligned buffers */
+static uint32_t sdio_bounce[SDIO_BLOCK_SIZE / 4];
+
+static uint32_t sdio_clkcr(uint32_t sdioclk_hz, uint32_t hz, uint32_t *actual)
+{
+	uint32_t div;
+
+	if (hz >= sdioclk_hz) {
+		*actual = sdioclk_hz;
+		return SDIO_CLKCR_BYPASS;
+	}
+
+	div = (sdioclk_hz + hz - 1) / hz;
+	if (div < 2) {
+		div = 2;
+	}
+	if (div > SDIO_CLKCR_CLKDIV_MASK + 2) {
+		div = SDIO_CLKCR_CLKDIV_MASK + 2;
+	}
+	*actual = sdioclk_hz / div;
+	return (div - 2) << SDIO_CLKCR_CLKDIV_SHIFT;
+}
+
+static void sdio_set_clock(uint32_t sdioclk_hz, uint32_t hz, uint32_t *actual)
+{
+	SDIO_CLKCR = (SDIO_CLKCR & ~(SDIO_CLKCR_BYPASS |
+				     (SDIO_CLKCR_CLKDIV_MASK <<
+				      SDIO_CLKCR_CLKDIV_SHIFT))) |
+		     sdio_clkcr(sdioclk_hz, hz, actual);
+}
+
+static enum sdio_status sdio_command(uint8_t index, uint32_t arg,
+				     uint32_t wait, bool check_crc)
+{
+	uint32_t sta;
+
+	SDIO_ICR = SDIO_ICR_STATIC;
+	SDIO_ARG = arg;
+	SDIO_CMD = index | wait | SDIO_CMD_CPSMEN;
+
+	if (wait == SDIO_CMD_WAITRESP_NO_0) {
+		while (!(SDIO_STA & (SDIO_STA_CMDSENT | SDIO_STA_CTIMEOUT)));
+		return SDIO_OK;
+	}
+
+	do {
+		sta = SDIO_STA;
+	} while (!(sta & (SDIO_STA_CMDREND | SDIO_STA_CCRCFAIL |
+			  SDIO_STA_CTIMEOUT)));
+
+	if (sta & SDIO_STA_CTIMEOUT) {
+		return SDIO_ETIMEOUT;
+	}
+	if ((sta & SDIO_STA_CCRCFAIL) && check_crc) {
+		return SDIO_ECRC;
+	}
+	return SDIO_OK;
+}
+
+/* Command with an R1 (or R1b, R6, R7) response */
+static enum sdio_status sdio_command_r1(uint8_t index, uint32_t arg)
+{
+	enum sdio_status st = sdio_command(index, arg, SDIO_R1, true);
+
+	if (st != SDIO_OK) {
+		return st;
+	}
+	if ((SDIO_RESPCMD & SDIO_RESPCMD_MASK) != index) {
+		return SDIO_ECRC;
+	}
+	return SDIO_OK;
+}
+
+static enum sdio_status sdio_check_r1(void)
+{
+	return (SDIO_RESP1 & SD_R1_ERRORS) ? SDIO_ECARD : SDIO_OK;
+}
+
+static enum sdio_status sdio_app_command(uint32_t rca, uint8_t index,
+					 uint32_t arg, uint32_t wait,
+					 bool check_crc)
+{
+	enum sdio_status st = sdio_command_r1(55, rca);
+
+	if (st != SDIO_OK) {
+		return st;
+	}
+	return sdio_command(index, arg, wait, check_crc);
+}
+
+/* Bits msb..lsb of a 128 bit register read with a long response */
+static uint32_t sdio_bits(const uint32_t *r, uint8_t msb, uint8_t lsb)
+{
+	uint32_t v = 0;
+	int i;
+
+	for (i = msb; i >= lsb; i--) {
+		v = (v << 1) | ((r[3 - i / 32] >> (i % 32)) & 1);
+	}
+	return v;
+}
+
+static uint32_t sdio_csd_block_count(const uint32_t *csd)
+{
+	uint32_t c_size, mult, read_bl_len;
+
+	if (sdio_bits(csd, 127, 126) == 1) {
+		/* CSD version 2.0, SDHC and SDXC */
+		c_size = sdio_bits(csd, 69, 48);
+		return (c_size + 1) * 1024;
+	}
+
+	c_size = sdio_bits(csd, 73, 62);
+	mult = sdio_bits(csd, 49, 47);
+	read_bl_len = sdio_bits(csd, 83, 80);
+	return ((c_size + 1) << (mult + 2)) << read_bl_len >> 9;
+}
+
+static enum sdio_status sdio_data_status(uint32_t sta)
+{
+	if (sta & SDIO_STA_DTIMEOUT) {
+		return SDIO_ETIMEOUT;
+	}
+	if (sta & SDIO_STA_DCRCFAIL) {
+		return SDIO_ECRC;
+	}
+	if (sta & SDIO_STA_DATA_ERRORS) {
+		return SDIO_EDATA;
+	}
+	return SDIO_OK;
+}
+
+/* CMD6 switch to high speed, the 64 byte status is read without DMA */
+static bool sdio_switch_high_speed(struct sdio_card *card)
+{
+	uint32_t status[16];
+	uint32_t sta, word;
+	uint32_t n = 0;
+
+	SDIO_DTIMER = card->clock_hz / 10;
+	SDIO_DLEN = sizeof(status);
+	SDIO_DCTRL = SDIO_DCTRL_DBLOCKSIZE_6 | SDIO_DCTRL_DTDIR |
+		     SDIO_DCTRL_DTEN;
+
+	if (sdio_command_r1(6, 0x80fffff1) != SDIO_OK ||
+	    sdio_check_r1() != SDIO_OK) {
+		SDIO_DCTRL = 0;
+		return false;
+	}
+
+	do {
+		sta = SDIO_STA;
+		if (sta & SDIO_STA_RXDAVL) {
+			word = SDIO_FIFO;
+			if (n < 16) {
+				status[n++] = word;
+			}
+		}
+	} while (!(sta & (SDIO_STA_DATAEND | SDIO_STA_DATA_ERRORS)) ||
+		 (sta & SDIO_STA_RXDAVL));
+	SDIO_DCTRL = 0;
+
+	if (sdio_data_status(sta) != SDIO_OK || n < 16) {
+		return false;
+	}
+
+	/* Bits 379:376, function group 1 result, in byte 16 */
+	return (((const uint8_t *)status)[16] & 0xf) == 1;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Initialise the host and the SD card
+
+@param[in] card Card, with the DMA fields filled in.
+@param[in] sdioclk_hz SDIO kernel clock, 48MHz from PLL48CLK usually.
+@param[in] hw_flow_control Stop the card clock when the FIFO runs full or
+empty, instead of failing the transfer.
+@returns SDIO_OK, or the reason the card could not be brought up.
+*/
+enum sdio_status sdio_card_init(struct sdio_card *card, uint32_t sdioclk_hz,
+				bool hw_flow_control)
+{
+	enum sdio_status st;
+	uint32_t arg = SD_OCR_VOLTAGE_WINDOW;
+	uint32_t i;
+
+	card->rca = 0;
+	card->high_speed = false;
+
+	SDIO_DCTRL = 0;
+	SDIO_MASK = 0;
+	SDIO_CLKCR = 0;
+	sdio_set_clock(sdioclk_hz, SD_INIT_CLOCK, &card->clock_hz);
+	SDIO_POWER = SDIO_POWER_PWRCTRL_PWRON;
+	SDIO_CLKCR |= SDIO_CLKCR_CLKEN;
+
+	/* At least 74 card clocks before the first command */
+	for (i = 0; i < 50000; i++) {
+		__asm__("nop");
+	}
+
+	sdio_command(0, 0, SDIO_CMD_WAITRESP_NO_0, false);
+
+	/* CMD8 is answered by version 2.0 and later cards only */
+	st = sdio_command_r1(8, 0x1aa);
+	if (st == SDIO_OK) {
+		if ((SDIO_RESP1 & 0xfff) != 0x1aa) {
+			return SDIO_EUNSUPPORTED;
+		}
+		arg |= SD_OCR_HCS;
+	} else if (st != SDIO_ETIMEOUT) {
+		return st;
+	}
+
+	/* ACMD41 until the card leaves the busy state, R3 has no CRC */
+	for (i = 0; i < SD_ACMD41_TRIES; i++) {
+		st = sdio_app_command(0, 41, arg, SDIO_R1, false);
+		if (st == SDIO_ETIMEOUT) {
+			/* MMC cards do not know CMD55 */
+			return SDIO_EUNSUPPORTED;
+		}
+		if (st != SDIO_OK) {
+			return st;
+		}
+		if (SDIO_RESP1 & SD_OCR_BUSY) {
+			break;
+		}
+	}
+	if (i == SD_ACMD41_TRIES) {
+		return SDIO_ETIMEOUT;
+	}
+	card->high_capacity = SDIO_RESP1 & SD_OCR_HCS;
+
+	st = sdio_command(2, 0, SDIO_R2, true);
+	if (st != SDIO_OK) {
+		return st;
+	}
+	card->cid[0] = SDIO_RESP1;
+	card->cid[1] = SDIO_RESP2;
+	card->cid[2] = SDIO_RESP3;
+	card->cid[3] = SDIO_RESP4;
+
+	st = sdio_command_r1(3, 0);
+	if (st != SDIO_OK) {
+		return st;
+	}
+	card->rca = SDIO_RESP1 & 0xffff0000;
+
+	st = sdio_command(9, card->rca, SDIO_R2, true);
+	if (st != SDIO_OK) {
+		return st;
+	}
+	card->csd[0] = SDIO_RESP1;
+	card->csd[1] = SDIO_RESP2;
+	card->csd[2] = SDIO_RESP3;
+	card->csd[3] = SDIO_RESP4;
+	card->block_count = sdio_csd_block_count(card->csd);
+
+	/* Select the card, it is in transfer state from here on */
+	st = sdio_command_r1(7, card->rca);
+	if (st != SDIO_OK) {
+		return st;
+	}
+
+	if (!card->high_capacity) {
+		st = sdio_command_r1(16, SDIO_BLOCK_SIZE);
+		if (st == SDIO_OK) {
+			st = sdio_check_r1();
+		}
+		if (st != SDIO_OK) {
+			return st;
+		}
+	}
+
+	/* ACMD6, 4 bit bus */
+	st = sdio_app_command(card->rca, 6, 2, SDIO_R1, true);
+	if (st == SDIO_OK) {
+		st = sdio_check_r1();
+	}
+	if (st != SDIO_OK) {
+		return st;
+	}
+	SDIO_CLKCR = (SDIO_CLKCR & ~(SDIO_CLKCR_WIDBUS_MASK <<
+				     SDIO_CLKCR_WIDBUS_SHIFT)) |
+		     SDIO_CLKCR_WIDBUS_4;
+
+	/* Command class 10 (switch) is needed for high speed */
+	sdio_set_clock(sdioclk_hz, SD_DEFAULT_CLOCK, &card->clock_hz);
+	if (sdio_bits(card->csd, 95, 84) & (1 << 10)) {
+		card->high_speed = sdio_switch_high_speed(card);
+	}
+	if (card->high_speed) {
+		sdio_set_clock(sdioclk_hz, SD_HIGH_SPEED_CLOCK,
+			       &card->clock_hz);
+	}
+
+	if (hw_flow_control) {
+		SDIO_CLKCR |= SDIO_CLKCR_HWFC_EN;
+	} else {
+		SDIO_CLKCR &= ~SDIO_CLKCR_HWFC_EN;
+	}
+
+	sdio_default_card = card;
+	return SDIO_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Read the card status register (CMD13)
+
+@param[in] card Initialised card.
+@param[out] status R1 card status.
+@returns SDIO_OK if the card answered.
+*/
+enum sdio_status sdio_card_status(struct sdio_card *card, uint32_t *status)
+{
+	enum sdio_status st = sdio_command_r1(13, card->rca);
+
+	*status = SDIO_RESP1;
+	return st;
+}
+
+static void sdio_dma_setup(struct sdio_card *card, void *buf, bool write)
+{
+	uint32_t dma = card->dma;
+	uint8_t stream = card->dma_stream;
+
+	dma_stream_reset(dma, stream);
+	dma_channel_select(dma, stream, card->dma_channel);
+	dma_set_priority(dma, stream, DMA_SxCR_PL_VERY_HIGH);
+	dma_set_transfer_mode(dma, stream, write ?
+			      DMA_SxCR_DIR_MEM_TO_PERIPHERAL :
+			      DMA_SxCR_DIR_PERIPHERAL_TO_MEM);
+	dma_set_peripheral_address(dma, stream, (uint32_t)&SDIO_FIFO);
+	dma_set_memory_address(dma, stream, (uint32_t)buf);
+	dma_enable_memory_increment_mode(dma, stream);
+	dma_set_peripheral_size(dma, stream, DMA_SxCR_PSIZE_32BIT);
+	dma_set_memory_size(dma, stream, DMA_SxCR_MSIZE_32BIT);
+	dma_set_peripheral_burst(dma, stream, DMA_SxCR_PBURST_INCR4);
+	dma_set_memory_burst(dma, stream, DMA_SxCR_MBURST_INCR4);
+	dma_enable_fifo_mode(dma, stream);
+	dma_set_fifo_threshold(dma, stream, DMA_SxFCR_FTH_4_4_FULL);
+	/* The SDIO ends the transfer, the count is ignored */
+	dma_set_peripheral_flow_control(dma, stream);
+	dma_enable_stream(dma, stream);
+}
+
+/* Wait for the card to finish programming */
+static enum sdio_status sdio_wait_ready(struct sdio_card *card)
+{
+	enum sdio_status st;
+	uint32_t status;
+	uint32_t i;
+
+	for (i = 0; i < SD_PROGRAM_TRIES; i++) {
+		st = sdio_card_status(card, &status);
+		if (st != SDIO_OK) {
+			return st;
+		}
+		if (status & SD_R1_ERRORS) {
+			return SDIO_ECARD;
+		}
+		if ((status & SD_R1_READY_FOR_DATA) &&
+		    SD_R1_STATE(status) == SD_STATE_TRAN) {
+			return SDIO_OK;
+		}
+	}
+	return SDIO_ETIMEOUT;
+}
+
+/* One DMA transfer of count blocks from or to a word aligned buffer */
+static enum sdio_status sdio_transfer(struct sdio_card *card, uint32_t lba,
+				      void *buf, uint32_t count, bool write)
+{
+	uint32_t addr = card->high_capacity ? lba : lba * SDIO_BLOCK_SIZE;
+	uint32_t dctrl = SDIO_DCTRL_DBLOCKSIZE_9 | SDIO_DCTRL_DMAEN |
+			 SDIO_DCTRL_DTEN;
+	enum sdio_status st;
+	uint32_t sta;
+	uint8_t cmd;
+
+	if (write) {
+		cmd = count > 1 ? 25 : 24;
+	} else {
+		cmd = count > 1 ? 18 : 17;
+		dctrl |= SDIO_DCTRL_DTDIR;
+	}
+
+	SDIO_DCTRL = 0;
+	sdio_dma_setup(card, buf, write);
+	/* 100ms read and 250ms write timeouts */
+	SDIO_DTIMER = write ? card->clock_hz / 4 : card->clock_hz / 10;
+	SDIO_DLEN = count * SDIO_BLOCK_SIZE;
+
+	/* The data path waits for the card on reads, but would start
+	 * sending right away on writes, so it follows the command there.
+	 */
+	if (!write) {
+		SDIO_DCTRL = dctrl;
+	}
+	st = sdio_command_r1(cmd, addr);
+	if (st == SDIO_OK) {
+		st = sdio_check_r1();
+	}
+	if (st != SDIO_OK) {
+		SDIO_DCTRL = 0;
+		dma_disable_stream(card->dma, card->dma_stream);
+		return st;
+	}
+	if (write) {
+		SDIO_DCTRL = dctrl;
+	}
+
+	do {
+		sta = SDIO_STA;
+	} while (!(sta & (SDIO_STA_DATAEND | SDIO_STA_DATA_ERRORS)));
+	st = sdio_data_status(sta);
+
+	if (cmd == 18 || cmd == 25) {
+		/* CMD12, stop transmission */
+		sdio_command_r1(12, 0);
+	}
+	SDIO_DCTRL = 0;
+
+	if (st != SDIO_OK) {
+		dma_disable_stream(card->dma, card->dma_stream);
+	}
+	while (DMA_SCR(card->dma, card->dma_stream) & DMA_SxCR_EN);
+	if (st == SDIO_OK &&
+	    dma_get_interrupt_flag(card->dma, card->dma_stream, DMA_TEIF)) {
+		st = SDIO_EDATA;
+	}
+
+	if (write && st == SDIO_OK) {
+		st = sdio_wait_ready(card);
+	}
+	return st;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Read blocks from the card
+
+Word aligned buffers are read with one multi block transfer, other buffers
+one block at a time through a bounce buffer.
+
+@param[in] card Initialised card.
+@param[in] lba First block.
+@param[out] buf Destination, count * SDIO_BLOCK_SIZE bytes.
+@param[in] count Number of blocks.
+@returns SDIO_OK on success.
+*/
+enum sdio_status sdio_read_blocks(struct sdio_card *card, uint32_t lba,
+				  void *buf, uint32_t count)
+{
+	uint8_t *p = buf;
+	enum sdio_status st;
+
+	if (count == 0) {
+		return SDIO_OK;
+	}
+	if (!((uintptr_t)buf & 3)) {
+		return sdio_transfer(card, lba, buf, count, false);
+	}
+
+	while (count--) {
+		st = sdio_transfer(card, lba++, sdio_bounce, 1, false);
+		if (st != SDIO_OK) {
+			return st;
+		}
+		memcpy(p, sdio_bounce, SDIO_BLOCK_SIZE);
+		p += SDIO_BLOCK_SIZE;
+	}
+	return SDIO_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Write blocks to the card
+
+Returns once the card has finished programming.  Word aligned buffers are
+written with one multi block transfer, other buffers one block at a time
+through a bounce buffer.
+
+@param[in] card Initialised card.
+@param[in] lba First block.
+@param[in] buf Source, count * SDIO_BLOCK_SIZE bytes.
+@param[in] count Number of blocks.
+@returns SDIO_OK on success.
+*/
+enum sdio_status sdio_write_blocks(struct sdio_card *card, uint32_t lba,
+				   const void *buf, uint32_t count)
+{
+	const uint8_t *p = buf;
+	enum sdio_status st;
+
+	if (count == 0) {
+		return SDIO_OK;
+	}
+	if (!((uintptr_t)buf & 3)) {
+		return sdio_transfer(card, lba, (void *)buf, count, true);
+	}
+
+	while (count--) {
+		memcpy(sdio_bounce, p, SDIO_BLOCK_SIZE);
+		st = sdio_transfer(card, lba++, sdio_bounce, 1, true);
+		if (st != SDIO_OK) {
+			return st;
+		}
+		p += SDIO_BLOCK_SIZE;
+	}
+	return SDIO_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Read one block from the last initialised card
+
+Block callback for usb_msc_init() and FAT layers.
+
+@returns 0 on success, -1 on failure.
+*/
+int sdio_read_block(uint32_t lba, uint8_t *copy_to)
+{
+	if (sdio_default_card == NULL ||
+	    sdio_read_blocks(sdio_default_card, lba, copy_to, 1) != SDIO_OK) {
+		return -1;
+	}
+	return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Write one block to the last initialised card
+
+Block callback for usb_msc_init() and FAT layers.
+
+@returns 0 on success, -1 on failure.
+*/
+int sdio_write_block(uint32_t lba, const uint8_t *copy_from)
+{
+	if (sdio_default_card == NULL ||
+	    sdio_write_blocks(sdio_default_card, lba, copy_from, 1)
+	    != SDIO_OK) {
+		return -1;
+	}
+	return 0;
+}
+
+/**@}*/
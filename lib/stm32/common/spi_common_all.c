@@ -51,6 +51,9 @@ LSB first.
  * along with this library.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+/* The data register accessors are always exported */
+#undef CM3_INLINE_ACCESSORS
+
 #include <libopencm3/stm32/spi.h>
 #include <libopencm3/stm32/rcc.h>
 
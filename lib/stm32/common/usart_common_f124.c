@@ -31,6 +31,9 @@ Devices can have up to 3 USARTs and 2 UARTs.
 
 /**@{*/
 
+/* usart_send() and usart_recv() are always exported */
+#undef CM3_INLINE_ACCESSORS
+
 #include <libopencm3/stm32/usart.h>
 #include <libopencm3/stm32/rcc.h>
 
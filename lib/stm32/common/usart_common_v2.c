@@ -26,6 +26,9 @@
 
 /**@{*/
 
+/* usart_send() and usart_recv() are always exported */
+#undef CM3_INLINE_ACCESSORS
+
 #include <libopencm3/stm32/usart.h>
 
 /*---------------------------------------------------------------------------*/
@@ -0,0 +1,256 @@
+/** @addtogroup wwdg_file WWDG peripheral API
+@ingroup peripheral_apis
+
+Window watchdog and a watchdog supervisor for several tasks.
+
+Feeding a watchdog from one main loop only shows that the loop runs, not
+that the USB stack, the network or the control loop still make progress.
+With the supervisor every task registers with a deadline and checks in
+with wwdg_task_checkin() from its own code path.  The supervisor runs in
+the early wakeup interrupt of the WWDG, once per period: it reloads the
+WWDG, and the IWDG as a backup on its own clock if asked to, only if every
+task has checked in within its deadline.
+
+@code
+	static struct wwdg_task usb_task = { .name = "usb", .deadline = 2 };
+	static struct wwdg_dump dump __attribute__((section(".noinit")));
+
+	if ((RCC_CSR & RCC_CSR_WWDGRSTF) && dump.magic == WWDG_DUMP_MAGIC) {
+		report_stall(dump.task);
+	}
+	wwdg_supervisor_add_task(&usb_task);
+	period_us = wwdg_supervisor_start(3, &dump, false);
+	nvic_enable_irq(NVIC_WWDG_IRQ);
+
+	void wwdg_isr(void)
+	{
+		wwdg_supervisor_handle_interrupt();
+	}
+@endcode
+
+When a task misses its deadline the supervisor fills the dump with the
+first stalled task and lets the WWDG run out, the reset follows one counter
+tick later.  Keep the dump in RAM that is not cleared at start up, like the
+.noinit section of the generic linker script, or copy it to backup
+registers from wherever it is read.  The WWDG interrupt needs
+a priority above everything that can block for a counter tick.
+
+The period is 63 counter ticks of 4096 * 2^timebase APB1 clocks, e.g.
+about 49ms with a timebase of 3 at 42MHz, deadlines count periods.
+
+LGPL License Terms @ref lgpl_license
+*/
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**@{*/
+
+#include <stddef.h>
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/stm32/iwdg.h>
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/wwdg.h>
+
+static struct wwdg_task *wwdg_tasks;
+static struct wwdg_dump *wwdg_dump;
+static bool wwdg_feed_iwdg;
+static uint32_t wwdg_periods;
+
+/*---------------------------------------------------------------------------*/
+/** @brief Start the Window Watchdog
+
+The WWDG can not be stopped again until reset.
+
+@param[in] timebase Counter clock APB1 / 4096 / 2^timebase, 0 to 3.
+@param[in] window Earliest reload, the counter has to be below, up to 0x7f.
+@param[in] counter Start value, 0x40 to 0x7f.
+*/
+void wwdg_start(uint8_t timebase, uint8_t window, uint8_t counter)
+{
+	rcc_periph_clock_enable(RCC_WWDG);
+	WWDG_CFR = (WWDG_CFR & WWDG_CFR_EWI) |
+		   ((timebase & 3) << WWDG_CFR_WDGTB_LSB) |
+		   (window & WWDG_CR_T_MAX);
+	WWDG_CR = WWDG_CR_WDGA | (counter & WWDG_CR_T_MAX);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Reload the Window Watchdog
+
+Resets the device if the counter is still above the window.
+
+@param[in] counter Reload value, 0x40 to 0x7f.
+*/
+void wwdg_reset(uint8_t counter)
+{
+	WWDG_CR = WWDG_CR_WDGA | (counter & WWDG_CR_T_MAX);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Read the Window Watchdog Counter
+
+@returns Counter, the reset comes when it drops below 0x40.
+*/
+uint8_t wwdg_get_counter(void)
+{
+	return WWDG_CR & WWDG_CR_T_MAX;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Enable the Early Wakeup Interrupt
+
+Raised when the counter reaches 0x40, one tick before the reset.  Only a
+reset clears it again.
+*/
+void wwdg_enable_early_wakeup(void)
+{
+	WWDG_CFR |= WWDG_CFR_EWI;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Clear the Early Wakeup Interrupt Flag */
+void wwdg_clear_early_wakeup_flag(void)
+{
+	WWDG_SR = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Register a Supervised Task
+
+@param[in] task Task with name and deadline, must stay valid until removed.
+@returns false for a deadline of 0, which would stall at the first check.
+*/
+bool wwdg_supervisor_add_task(struct wwdg_task *task)
+{
+	if (task->deadline == 0) {
+		return false;
+	}
+	task->missed = 0;
+	task->max_missed = 0;
+	CM_ATOMIC_BLOCK() {
+		task->next = wwdg_tasks;
+		wwdg_tasks = task;
+	}
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Remove a Supervised Task
+
+@param[in] task Task from wwdg_supervisor_add_task().
+*/
+void wwdg_supervisor_remove_task(struct wwdg_task *task)
+{
+	struct wwdg_task **p;
+
+	CM_ATOMIC_BLOCK() {
+		for (p = &wwdg_tasks; *p; p = &(*p)->next) {
+			if (*p == task) {
+				*p = task->next;
+				break;
+			}
+		}
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Check in a Supervised Task
+
+@param[in] task Task from wwdg_supervisor_add_task().
+*/
+void wwdg_task_checkin(struct wwdg_task *task)
+{
+	task->missed = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Start Supervising
+
+Starts the WWDG with early wakeup interrupt and no window, the interrupt has
+to be enabled in the NVIC.  With feed_iwdg, the IWDG has to be started with
+a period longer than the supervisor period.
+
+@param[in] timebase Counter clock APB1 / 4096 / 2^timebase, 0 to 3.
+@param[out] dump Filled before a reset for a stalled task, NULL for none.
+@param[in] feed_iwdg Reload the IWDG along with the WWDG.
+@returns Supervisor period in microseconds.
+*/
+uint32_t wwdg_supervisor_start(uint8_t timebase, struct wwdg_dump *dump,
+			       bool feed_iwdg)
+{
+	wwdg_dump = dump;
+	if (dump) {
+		dump->magic = 0;
+	}
+	wwdg_feed_iwdg = feed_iwdg;
+	wwdg_periods = 0;
+
+	wwdg_start(timebase, WWDG_CR_T_MAX, WWDG_CR_T_MAX);
+	wwdg_clear_early_wakeup_flag();
+	wwdg_enable_early_wakeup();
+
+	return ((uint64_t)(WWDG_CR_T_MAX - WWDG_CR_T_EWI) * 4096 *
+		(1 << (timebase & 3)) * 1000000) / rcc_apb1_frequency;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Run the Supervisor
+
+Call from wwdg_isr().  Keeps the watchdogs running if every task checked in
+within its deadline, otherwise fills the dump and lets the reset happen.
+*/
+void wwdg_supervisor_handle_interrupt(void)
+{
+	struct wwdg_task *task, *first = NULL;
+	uint8_t stalled = 0;
+
+	wwdg_clear_early_wakeup_flag();
+
+	for (task = wwdg_tasks; task; task = task->next) {
+		if (task->missed < 0xff) {
+			task->missed++;
+		}
+		if (task->missed > task->max_missed) {
+			task->max_missed = task->missed;
+		}
+		if (task->missed > task->deadline) {
+			if (!first) {
+				first = task;
+			}
+			stalled++;
+		}
+	}
+
+	if (!stalled) {
+		wwdg_reset(WWDG_CR_T_MAX);
+		if (wwdg_feed_iwdg) {
+			iwdg_reset();
+		}
+		wwdg_periods++;
+		return;
+	}
+
+	if (wwdg_dump) {
+		wwdg_dump->task = first->name;
+		wwdg_dump->missed = first->missed;
+		wwdg_dump->stalled = stalled;
+		wwdg_dump->periods = wwdg_periods;
+		wwdg_dump->magic = WWDG_DUMP_MAGIC;
+	}
+}
+
+/**@}*/
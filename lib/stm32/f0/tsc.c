@@ -0,0 +1,274 @@
+/** @defgroup tsc_file TSC
+ *
+ * @ingroup STM32F0xx
+ *
+ * @brief <b>libopencm3 STM32F0xx Touch Sensing Controller</b>
+ *
+ * The TSC measures one channel of every enabled group at the same time.
+ * tsc_keypad_init() spreads the keys over acquisition steps so that each
+ * step takes at most one key per group: a keypad of eight keys in four
+ * groups is scanned in two acquisitions instead of eight.  Every end of
+ * acquisition interrupt reads the counts of the step, starts the next step
+ * and runs the keys of the finished one through a short pipeline:
+ *
+ *  - baseline: the untouched count, following slow drift of temperature
+ *    and supply through a 1 / 2^baseline_shift filter while the key is
+ *    released, and jumping up at once when the count rises above it (the
+ *    key was touched at power up).
+ *  - detection: a touch lowers the count, the key is touched when the
+ *    count is threshold below the baseline and released when it comes back
+ *    within threshold - hysteresis.
+ *  - debouncing: a change has to hold for debounce acquisitions in a row
+ *    before the callback reports it.
+ *
+ * @code
+ *	static struct tsc_key keys[] = {
+ *		{ .group = 1, .io = 2, .threshold = 40, .hysteresis = 10 },
+ *		{ .group = 1, .io = 3, .threshold = 40, .hysteresis = 10 },
+ *		{ .group = 2, .io = 2, .threshold = 40, .hysteresis = 10 },
+ *	};
+ *	static struct tsc_keypad pad = {
+ *		.keys = keys, .nkeys = 3,
+ *		.config = (1 << TSC_CR_CTPH_SHIFT) | (1 << TSC_CR_CTPL_SHIFT) |
+ *			  (5 << TSC_CR_PGPSC_SHIFT) | (6 << TSC_CR_MCV_SHIFT),
+ *		.sampling = TSC_IOSCR_G1(1) | TSC_IOSCR_G2(1),
+ *		.debounce = 2, .baseline_shift = 6, .continuous = true,
+ *		.callback = key_changed,
+ *	};
+ *
+ *	void tsc_isr(void)
+ *	{
+ *		tsc_handle_interrupt(&pad);
+ *	}
+ * @endcode
+ *
+ * The TSC clock, the pins in their alternate function (sampling IOs open
+ * drain) and the TSC interrupt in the NVIC are set up by the application.
+ * Between two steps the IOs are driven low to discharge the capacitors for
+ * as long as the interrupt takes, add a delay with tsc_keypad_scan() paced
+ * by a timer instead of continuous scanning for large sampling capacitors
+ * or to save power.
+ *
+ * LGPL License Terms @ref lgpl_license
+ */
+
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/**@{*/
+
+#include <libopencm3/stm32/tsc.h>
+
+/**
+ * Plan the acquisition steps of a keypad.
+ * Resets the baselines, the first scan after starts them over.
+ * @param pad keypad with keys and settings filled in
+ * @returns false if a group has more keys than TSC_MAX_STEPS
+ */
+bool tsc_keypad_init(struct tsc_keypad *pad)
+{
+	uint8_t per_group[8] = { 0 };
+	struct tsc_key *key;
+	uint8_t i;
+
+	pad->steps = 0;
+	pad->step = 0;
+	pad->busy = false;
+	pad->scans = 0;
+	pad->errors = 0;
+	for (i = 0; i < TSC_MAX_STEPS; i++) {
+		pad->step_channels[i] = 0;
+		pad->step_groups[i] = 0;
+	}
+
+	for (i = 0; i < pad->nkeys; i++) {
+		key = &pad->keys[i];
+		if (key->group < 1 || key->group > 8 ||
+		    per_group[key->group - 1] >= TSC_MAX_STEPS) {
+			return false;
+		}
+		key->step = per_group[key->group - 1]++;
+		key->baseline = 0;
+		key->baseline_acc = 0;
+		key->debounce = 0;
+		key->touched = false;
+
+		pad->step_channels[key->step] |=
+			TSC_IOBIT_VAL(key->group, key->io);
+		pad->step_groups[key->step] |= TSC_IOGCSR_GxE(key->group);
+		if (key->step >= pad->steps) {
+			pad->steps = key->step + 1;
+		}
+	}
+	return true;
+}
+
+static void tsc_start_step(struct tsc_keypad *pad)
+{
+	TSC_IOCCR = pad->step_channels[pad->step];
+	TSC_IOGCSR = pad->step_groups[pad->step];
+	TSC_ICR = TSC_ICR_EOAIC | TSC_ICR_MCEIC;
+	TSC_CR |= TSC_CR_START;
+}
+
+/**
+ * Set up the TSC for a keypad and start scanning.
+ * @param pad keypad from tsc_keypad_init()
+ */
+void tsc_keypad_start(struct tsc_keypad *pad)
+{
+	uint8_t i;
+	uint32_t channels = 0;
+
+	for (i = 0; i < pad->steps; i++) {
+		channels |= pad->step_channels[i];
+	}
+
+	TSC_CR = 0;
+	TSC_CR = (pad->config & ~(TSC_CR_START | TSC_CR_AM | TSC_CR_IODEF)) |
+		 TSC_CR_TSCE;
+	/* Schmitt triggers off on analog IOs */
+	TSC_IOHCR &= ~(channels | pad->sampling);
+	TSC_IOSCR = pad->sampling;
+	TSC_IER = TSC_IER_EOAIE | TSC_IER_MCEIE;
+
+	tsc_keypad_scan(pad);
+}
+
+/**
+ * Stop scanning after the running scan.
+ * @param pad keypad from tsc_keypad_start()
+ */
+void tsc_keypad_stop(struct tsc_keypad *pad)
+{
+	pad->continuous = false;
+	while (pad->busy);
+	TSC_IER = 0;
+	TSC_CR &= ~TSC_CR_TSCE;
+}
+
+/**
+ * Start a single scan of all keys.
+ * For scans paced by a timer, with continuous off.
+ * @param pad keypad from tsc_keypad_start()
+ * @returns false if the last scan still runs
+ */
+bool tsc_keypad_scan(struct tsc_keypad *pad)
+{
+	if (pad->busy || !pad->steps) {
+		return false;
+	}
+	pad->busy = true;
+	pad->step = 0;
+	tsc_start_step(pad);
+	return true;
+}
+
+static void tsc_key_process(struct tsc_keypad *pad, struct tsc_key *key,
+			    uint16_t count)
+{
+	int32_t delta;
+	bool touch;
+
+	key->count = count;
+	if (!key->baseline || count > key->baseline) {
+		key->baseline_acc = (uint32_t)count << pad->baseline_shift;
+		key->baseline = count;
+		key->debounce = 0;
+		if (!key->touched) {
+			return;
+		}
+	}
+
+	delta = (int32_t)key->baseline - count;
+	if (key->touched) {
+		touch = delta >= (int32_t)key->threshold - key->hysteresis;
+	} else {
+		touch = delta >= key->threshold;
+	}
+
+	if (touch == key->touched) {
+		key->debounce = 0;
+		if (!touch) {
+			key->baseline_acc += count - key->baseline;
+			key->baseline = key->baseline_acc >>
+					pad->baseline_shift;
+		}
+		return;
+	}
+	if (++key->debounce < pad->debounce) {
+		return;
+	}
+	key->debounce = 0;
+	key->touched = touch;
+	if (pad->callback) {
+		pad->callback(key, touch, pad->arg);
+	}
+}
+
+/**
+ * Handle the end of an acquisition.
+ * Call from tsc_isr().  Starts the next step before processing the
+ * counts of the finished one.
+ * @param pad keypad from tsc_keypad_start()
+ */
+void tsc_handle_interrupt(struct tsc_keypad *pad)
+{
+	uint16_t counts[8];
+	uint32_t isr = TSC_ISR;
+	uint8_t step = pad->step, i;
+	bool valid = !(isr & TSC_ISR_MCEF);
+
+	if (!(isr & (TSC_ISR_EOAF | TSC_ISR_MCEF))) {
+		return;
+	}
+	TSC_ICR = TSC_ICR_EOAIC | TSC_ICR_MCEIC;
+
+	if (valid) {
+		for (i = 0; i < 8; i++) {
+			if (pad->step_groups[step] & TSC_IOGCSR_GxE(i + 1)) {
+				counts[i] = TSC_IOGxCR(i + 1) &
+					    TSC_IOGxCR_CNT_MASK;
+			}
+		}
+	} else {
+		pad->errors++;
+	}
+
+	if (++pad->step < pad->steps) {
+		tsc_start_step(pad);
+	} else {
+		pad->scans++;
+		pad->step = 0;
+		if (pad->continuous) {
+			tsc_start_step(pad);
+		} else {
+			pad->busy = false;
+		}
+	}
+
+	if (!valid) {
+		return;
+	}
+	for (i = 0; i < pad->nkeys; i++) {
+		if (pad->keys[i].step == step) {
+			tsc_key_process(pad, &pad->keys[i],
+					counts[pad->keys[i].group - 1]);
+		}
+	}
+}
+
+/**@}*/
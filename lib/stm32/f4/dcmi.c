@@ -0,0 +1,511 @@
+/** @defgroup dcmi_file DCMI
+ *
+ * @ingroup STM32F4xx
+ *
+ * @brief <b>libopencm3 STM32F4xx DCMI</b>
+ *
+ * This library supports the digital camera interface (DCMI) in the STM32F4
+ * series of ARM Cortex Microcontrollers by ST Microelectronics.
+ *
+ * dcmi_init() sets the synchronisation, polarities, data width, frame rate
+ * and JPEG mode from DCMI_CR_* flags, dcmi_set_crop() the capture window.
+ * dcmi_capture_start() then streams frames into one to DCMI_FRAMES_MAX
+ * buffers, or takes a single snapshot.  The data goes straight from the
+ * DCMI into the frame buffers, usually in SDRAM, with no CPU copy.
+ *
+ * A DMA stream can move at most 65535 words per transfer, so larger frames
+ * are split into equal chunks.  The stream runs in double buffer mode and
+ * the chunk that just finished is reprogrammed with the address of the
+ * chunk after next, so the stream never stops within a frame, nor between
+ * frames in continuous mode.  In JPEG mode the frame length is not known
+ * up front; the stream is restarted at the next buffer at every frame end,
+ * during the vertical blanking.  It stops when a buffer is used up, and a
+ * frame that turns out longer is dropped and counted as oversize.
+ *
+ * dcmi_irq() must be called from dcmi_isr() and dcmi_dma_irq() from the
+ * stream interrupt, dma2_stream1_isr() for DCMI_DMA_STREAM, with both
+ * interrupts enabled in the NVIC.  Completed frames are handed to the frame
+ * callback in interrupt context, and can be picked up with dcmi_get_frame().
+ * Buffers are reused in turn, so a frame must be consumed before the
+ * capture comes round to its buffer again.
+ *
+ * LGPL License Terms @ref lgpl_license
+ */
+
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <libopencm3/stm32/dcmi.h>
+#include <libopencm3/stm32/dma.h>
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/cm3/dwt.h>
+
+#define DCMI_DMA_MAX_WORDS	0xffff
+
+static struct {
+	uint32_t dma;
+	uint8_t stream;
+	void *frames[DCMI_FRAMES_MAX];
+	uint8_t count;
+	uint32_t frame_bytes;
+	uint32_t chunk_words;
+	uint32_t chunks;	/* per frame */
+	uint32_t next_chunk;	/* next one to program, counted in the frame */
+	uint8_t next_frame;	/* buffer of next_chunk */
+	uint32_t done_chunks;	/* finished in the current frame */
+	uint8_t frame;		/* buffer being captured */
+	uint32_t sequence;
+	uint32_t start;
+	uint16_t lines;
+	bool snapshot;
+	bool running;
+	bool full;		/* JPEG buffer used up, stream stopped */
+	bool valid;		/* last holds a frame */
+	struct dcmi_frame last;
+} dcmi_cap;
+
+static void (*dcmi_frame_callback)(const struct dcmi_frame *);
+static void (*dcmi_line_callback)(uint16_t line);
+static struct dcmi_stats dcmi_stats;
+
+/*---------------------------------------------------------------------------*/
+/** @brief Configure and enable the DCMI
+
+@param[in] flags DCMI_CR_VSPOL, DCMI_CR_HSPOL, DCMI_CR_PCKPOL, DCMI_CR_ESS,
+DCMI_CR_JPEG, one of DCMI_CR_EDM_* and one of DCMI_CR_FCRC_*.  Capture mode
+and crop are set by the other functions.
+*/
+void dcmi_init(uint32_t flags)
+{
+	DCMI_CR = 0;
+	DCMI_IER = 0;
+	DCMI_ICR = DCMI_ICR_LINE | DCMI_ICR_VSYNC | DCMI_ICR_ERR |
+		   DCMI_ICR_OVR | DCMI_ICR_FRAME;
+	DCMI_CR = (flags & ~(DCMI_CR_EN | DCMI_CR_CAPTURE | DCMI_CR_CM |
+			     DCMI_CR_CROP)) | DCMI_CR_EN;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Set the codes for embedded synchronisation (DCMI_CR_ESS)
+
+All code bits are compared.
+*/
+void dcmi_set_embedded_sync(uint8_t frame_start, uint8_t line_start,
+			    uint8_t line_end, uint8_t frame_end)
+{
+	DCMI_ESCR = ((uint32_t)frame_end << DCMI_ESCR_FEC_SHIFT) |
+		    ((uint32_t)line_end << DCMI_ESCR_LEC_SHIFT) |
+		    ((uint32_t)line_start << DCMI_ESCR_LSC_SHIFT) |
+		    ((uint32_t)frame_start << DCMI_ESCR_FSC_SHIFT);
+	DCMI_ESUR = 0xffffffff;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Capture a window of the frame only
+
+@param[in] x Start of the window in pixel clocks, 2 per pixel for 8 bit
+RGB565 or YCbCr data.
+@param[in] y First line.
+@param[in] width Window width in pixel clocks.
+@param[in] height Window height in lines.
+*/
+void dcmi_set_crop(uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+	DCMI_CWSTRT = (((uint32_t)y & DCMI_CWSTRT_VST_MASK) <<
+		       DCMI_CWSTRT_VST_SHIFT) |
+		      ((x & DCMI_CWSTRT_HOFFCNT_MASK) <<
+		       DCMI_CWSTRT_HOFFCNT_SHIFT);
+	DCMI_CWSIZE = (((uint32_t)(height - 1) & DCMI_CWSIZE_VLINE_MASK) <<
+		       DCMI_CWSIZE_VLINE_SHIFT) |
+		      (((width - 1) & DCMI_CWSIZE_CAPCNT_MASK) <<
+		       DCMI_CWSIZE_CAPCNT_SHIFT);
+	DCMI_CR |= DCMI_CR_CROP;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Capture whole frames again
+*/
+void dcmi_disable_crop(void)
+{
+	DCMI_CR &= ~DCMI_CR_CROP;
+}
+
+static void *dcmi_chunk_address(uint8_t frame, uint32_t chunk)
+{
+	return (uint8_t *)dcmi_cap.frames[frame] +
+	       chunk * dcmi_cap.chunk_words * 4;
+}
+
+/*
+ * Address of the next chunk to hand to the stream.  A JPEG frame never runs
+ * on into the next buffer: past its end the spare target gets the last
+ * chunk again, only written by a frame too long to keep.
+ */
+static uint32_t dcmi_next_chunk(void)
+{
+	void *addr;
+
+	if (dcmi_cap.next_chunk == dcmi_cap.chunks) {
+		return (uint32_t)dcmi_chunk_address(dcmi_cap.next_frame,
+						    dcmi_cap.chunks - 1);
+	}
+	addr = dcmi_chunk_address(dcmi_cap.next_frame, dcmi_cap.next_chunk);
+	if (++dcmi_cap.next_chunk == dcmi_cap.chunks &&
+	    !(DCMI_CR & DCMI_CR_JPEG)) {
+		dcmi_cap.next_chunk = 0;
+		dcmi_cap.next_frame = (dcmi_cap.next_frame + 1) %
+				      dcmi_cap.count;
+	}
+	return (uint32_t)addr;
+}
+
+static void dcmi_stream_stop(void)
+{
+	dma_disable_stream(dcmi_cap.dma, dcmi_cap.stream);
+	while (DMA_SCR(dcmi_cap.dma, dcmi_cap.stream) & DMA_SxCR_EN);
+	dma_clear_interrupt_flags(dcmi_cap.dma, dcmi_cap.stream,
+				  DMA_TCIF | DMA_HTIF | DMA_TEIF | DMA_DMEIF |
+				  DMA_FEIF);
+}
+
+/* (Re)start the stream at the first chunk of buffer frame */
+static void dcmi_stream_start(uint8_t frame)
+{
+	uint32_t dma = dcmi_cap.dma;
+	uint8_t stream = dcmi_cap.stream;
+
+	dcmi_cap.frame = frame;
+	dcmi_cap.next_frame = frame;
+	dcmi_cap.next_chunk = 0;
+	dcmi_cap.done_chunks = 0;
+	dcmi_cap.full = false;
+
+	dma_set_memory_address(dma, stream, dcmi_next_chunk());
+	dma_set_memory_address_1(dma, stream, dcmi_next_chunk());
+	dma_set_number_of_data(dma, stream, dcmi_cap.chunk_words);
+	/* Start on memory 0 */
+	DMA_SCR(dma, stream) &= ~DMA_SxCR_CT;
+	dma_enable_stream(dma, stream);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Start capturing
+
+The buffers must be word aligned and frame_bytes long.  In JPEG mode
+frame_bytes is the largest frame expected, longer frames are dropped.
+
+@param[in] frames Frame buffers, captured into in turn.
+@param[in] count Number of buffers, 1 to DCMI_FRAMES_MAX.
+@param[in] frame_bytes Size of one frame, a multiple of 4.
+@param[in] snapshot Capture a single frame into frames[0].
+@param[in] dma DMA controller, DCMI_DMA.
+@param[in] stream DMA stream, DCMI_DMA_STREAM.
+@param[in] channel DMA channel select, DCMI_DMA_CHANNEL.
+@returns false if the frame can not be split into equal DMA transfers.
+*/
+bool dcmi_capture_start(void *const *frames, uint8_t count,
+			uint32_t frame_bytes, bool snapshot, uint32_t dma,
+			uint8_t stream, uint32_t channel)
+{
+	uint32_t words = frame_bytes / 4;
+	uint32_t chunks;
+	uint8_t i;
+
+	if (count == 0 || count > DCMI_FRAMES_MAX || words == 0 ||
+	    (frame_bytes & 3)) {
+		return false;
+	}
+
+	/* Fewest equal chunks that fit the transfer counter */
+	for (chunks = (words + DCMI_DMA_MAX_WORDS - 1) / DCMI_DMA_MAX_WORDS;
+	     chunks <= words; chunks++) {
+		if (words % chunks == 0) {
+			break;
+		}
+	}
+	if (words / chunks > DCMI_DMA_MAX_WORDS) {
+		return false;
+	}
+
+	dcmi_capture_stop();
+
+	for (i = 0; i < count; i++) {
+		dcmi_cap.frames[i] = frames[i];
+	}
+	dcmi_cap.dma = dma;
+	dcmi_cap.stream = stream;
+	dcmi_cap.count = snapshot ? 1 : count;
+	dcmi_cap.frame_bytes = frame_bytes;
+	dcmi_cap.chunk_words = words / chunks;
+	dcmi_cap.chunks = chunks;
+	dcmi_cap.snapshot = snapshot;
+	dcmi_cap.sequence = 0;
+	dcmi_cap.lines = 0;
+	dcmi_cap.valid = false;
+
+	dma_stream_reset(dma, stream);
+	dma_channel_select(dma, stream, channel);
+	dma_set_priority(dma, stream, DMA_SxCR_PL_VERY_HIGH);
+	dma_set_transfer_mode(dma, stream, DMA_SxCR_DIR_PERIPHERAL_TO_MEM);
+	dma_set_peripheral_address(dma, stream, (uint32_t)&DCMI_DR);
+	dma_set_peripheral_size(dma, stream, DMA_SxCR_PSIZE_32BIT);
+	dma_set_memory_size(dma, stream, DMA_SxCR_MSIZE_32BIT);
+	dma_enable_memory_increment_mode(dma, stream);
+	dma_enable_fifo_mode(dma, stream);
+	dma_set_fifo_threshold(dma, stream, DMA_SxFCR_FTH_4_4_FULL);
+	if (dcmi_cap.chunk_words % 4 == 0) {
+		/* Bursts make the most of SDRAM */
+		dma_set_memory_burst(dma, stream, DMA_SxCR_MBURST_INCR4);
+	}
+	dma_enable_double_buffer_mode(dma, stream);
+	dma_enable_transfer_complete_interrupt(dma, stream);
+	dma_enable_transfer_error_interrupt(dma, stream);
+	dcmi_stream_start(0);
+
+	dwt_enable_cycle_counter();
+	dcmi_cap.start = dwt_read_cycle_counter();
+	dcmi_cap.running = true;
+
+	DCMI_ICR = DCMI_ICR_LINE | DCMI_ICR_VSYNC | DCMI_ICR_ERR |
+		   DCMI_ICR_OVR | DCMI_ICR_FRAME;
+	DCMI_IER = DCMI_IER_FRAME | DCMI_IER_VSYNC | DCMI_IER_OVR |
+		   DCMI_IER_ERR | (dcmi_line_callback ? DCMI_IER_LINE : 0);
+	if (snapshot) {
+		DCMI_CR |= DCMI_CR_CM;
+	} else {
+		DCMI_CR &= ~DCMI_CR_CM;
+	}
+	DCMI_CR |= DCMI_CR_EN | DCMI_CR_CAPTURE;
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Stop capturing at once
+
+The frame being captured is dropped.
+*/
+void dcmi_capture_stop(void)
+{
+	DCMI_CR &= ~DCMI_CR_CAPTURE;
+	DCMI_IER = 0;
+	if (dcmi_cap.running) {
+		dcmi_stream_stop();
+		dcmi_cap.running = false;
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Check whether a capture runs
+
+@returns false once a snapshot has been taken or the capture was stopped.
+*/
+bool dcmi_capture_running(void)
+{
+	return dcmi_cap.running;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Set the function called with every completed frame
+
+Called from dcmi_irq(), the frame buffer stays valid until the capture
+comes round to it again.
+*/
+void dcmi_set_frame_callback(void (*callback)(const struct dcmi_frame *))
+{
+	dcmi_frame_callback = callback;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Set the function called at the end of every line
+
+The line interrupt is only enabled with a callback set, at the next
+dcmi_capture_start().  At full frame rate that is one interrupt per line,
+so keep the callback short.
+*/
+void dcmi_set_line_callback(void (*callback)(uint16_t line))
+{
+	dcmi_line_callback = callback;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Get the last completed frame
+
+@param[out] frame Last frame.
+@returns false if no frame has been captured yet.
+*/
+bool dcmi_get_frame(struct dcmi_frame *frame)
+{
+	bool valid;
+
+	CM_ATOMIC_BLOCK() {
+		valid = dcmi_cap.valid;
+		*frame = dcmi_cap.last;
+	}
+	return valid;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Get the capture statistics
+*/
+void dcmi_get_stats(struct dcmi_stats *stats)
+{
+	CM_ATOMIC_BLOCK() {
+		*stats = dcmi_stats;
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA stream interrupt handling, call from the stream's isr
+*/
+void dcmi_dma_irq(void)
+{
+	uint32_t dma = dcmi_cap.dma;
+	uint8_t stream = dcmi_cap.stream;
+
+	if (dma_get_interrupt_flag(dma, stream, DMA_TEIF)) {
+		dma_clear_interrupt_flags(dma, stream, DMA_TEIF);
+		dcmi_stats.dma_errors++;
+	}
+	if (!dma_get_interrupt_flag(dma, stream, DMA_TCIF)) {
+		return;
+	}
+	dma_clear_interrupt_flags(dma, stream, DMA_TCIF);
+	dcmi_cap.done_chunks++;
+
+	if ((DCMI_CR & DCMI_CR_JPEG) &&
+	    dcmi_cap.done_chunks == dcmi_cap.chunks) {
+		/* Nothing more fits, hold the rest in the DCMI until the
+		 * frame end or an overrun tells whether there was any.
+		 */
+		dcmi_stream_stop();
+		dcmi_cap.full = true;
+		return;
+	}
+
+	/* The stream has moved on, the target it left gets the chunk after
+	 * the one it is working on now.
+	 */
+	if (DMA_SCR(dma, stream) & DMA_SxCR_CT) {
+		dma_set_memory_address(dma, stream, dcmi_next_chunk());
+	} else {
+		dma_set_memory_address_1(dma, stream, dcmi_next_chunk());
+	}
+}
+
+/* Data was lost, drop the frame and resynchronise on the next one */
+static void dcmi_resync(void)
+{
+	DCMI_CR &= ~DCMI_CR_EN;
+	dcmi_stream_stop();
+	dcmi_stream_start(dcmi_cap.frame);
+	DCMI_CR |= DCMI_CR_EN | DCMI_CR_CAPTURE;
+}
+
+/* Frame captured, the stream is past its last word */
+static void dcmi_frame_end(void)
+{
+	struct dcmi_frame *f = &dcmi_cap.last;
+	uint32_t length = dcmi_cap.frame_bytes;
+	uint8_t next = (dcmi_cap.frame + 1) % dcmi_cap.count;
+	uint32_t left;
+
+	/* Any chunk completion raced with the frame end */
+	dcmi_dma_irq();
+
+	if (dcmi_cap.full && (DCMI_SR & DCMI_SR_FNE)) {
+		/* Data left over, the frame is longer than the buffer */
+		dcmi_stats.oversize++;
+		dcmi_resync();
+		return;
+	}
+
+	if (DCMI_CR & DCMI_CR_JPEG) {
+		left = DMA_SNDTR(dcmi_cap.dma, dcmi_cap.stream);
+		length = dcmi_cap.done_chunks * dcmi_cap.chunk_words * 4 +
+			 (dcmi_cap.chunk_words - left) * 4;
+		if (dcmi_cap.done_chunks >= dcmi_cap.chunks) {
+			length = dcmi_cap.frame_bytes;
+		}
+	}
+
+	f->index = dcmi_cap.frame;
+	f->buf = dcmi_cap.frames[dcmi_cap.frame];
+	f->length = length;
+	f->sequence = dcmi_cap.sequence++;
+	f->start = dcmi_cap.start;
+	f->end = dwt_read_cycle_counter();
+	f->lines = dcmi_cap.lines;
+	dcmi_cap.valid = true;
+	dcmi_stats.frames++;
+
+	if (dcmi_cap.snapshot) {
+		dcmi_stream_stop();
+		dcmi_cap.running = false;
+	} else if (DCMI_CR & DCMI_CR_JPEG) {
+		/* Realign the stream with the next buffer */
+		dcmi_stream_stop();
+		dcmi_stream_start(next);
+	} else {
+		dcmi_cap.frame = next;
+		dcmi_cap.done_chunks = 0;
+	}
+
+	if (dcmi_frame_callback) {
+		dcmi_frame_callback(f);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DCMI interrupt handling, call from dcmi_isr()
+*/
+void dcmi_irq(void)
+{
+	uint32_t mis = DCMI_MIS;
+
+	DCMI_ICR = mis;
+
+	if (mis & DCMI_MIS_OVR) {
+		/* With the JPEG buffer used up, the data had nowhere to go */
+		if (dcmi_cap.full) {
+			dcmi_stats.oversize++;
+		} else {
+			dcmi_stats.overruns++;
+		}
+		if (dcmi_cap.running) {
+			dcmi_resync();
+		}
+		return;
+	}
+	if (mis & DCMI_MIS_ERR) {
+		dcmi_stats.sync_errors++;
+	}
+	if (mis & DCMI_MIS_LINE) {
+		if (dcmi_line_callback) {
+			dcmi_line_callback(dcmi_cap.lines);
+		}
+		dcmi_cap.lines++;
+	}
+	if ((mis & DCMI_MIS_FRAME) && dcmi_cap.running) {
+		dcmi_frame_end();
+	}
+	if (mis & DCMI_MIS_VSYNC) {
+		/* Blanking before the next frame */
+		dcmi_cap.start = dwt_read_cycle_counter();
+		dcmi_cap.lines = 0;
+	}
+}
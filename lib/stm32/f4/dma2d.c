@@ -0,0 +1,396 @@
+/** @defgroup dma2d_file DMA2D
+ *
+ * @ingroup STM32F4xx
+ *
+ * @brief <b>libopencm3 STM32F4xx DMA2D (Chrom-ART)</b>
+ *
+ * This library supports the DMA2D graphics accelerator of the STM32F42x and
+ * STM32F43x.
+ *
+ * Fills, copies with or without pixel format conversion, alpha blends and
+ * CLUT loads are put in a queue and return at once. The transfer complete
+ * interrupt starts the next operation, so the DMA2D runs them back to back
+ * while the CPU prepares the next frame. The DMA2D clock has to be enabled
+ * and @ref dma2d_irq() called from dma2d_isr():
+ *
+ * @code{.c}
+ *	rcc_periph_clock_enable(RCC_DMA2D);
+ *	dma2d_init();
+ *	nvic_enable_irq(NVIC_DMA2D_IRQ);
+ *	...
+ *	void dma2d_isr(void)
+ *	{
+ *		dma2d_irq();
+ *	}
+ * @endcode
+ *
+ * Operations are described in pixels on a @ref dma2d_surface, a buffer with
+ * its line pitch and format. Surfaces in L8 or L4 need the matching CLUT to
+ * be loaded with @ref dma2d_load_clut() first, the queue keeps the order.
+ * A source buffer must not be changed before its operation has run, wait
+ * with @ref dma2d_wait() when in doubt.
+ *
+ * LGPL License Terms @ref lgpl_license
+ */
+
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**@{*/
+
+#include <libopencm3/stm32/f4/dma2d.h>
+#include <libopencm3/cm3/cortex.h>
+#include <stddef.h>
+#include <string.h>
+
+#define DMA2D_CR_IRQS	(DMA2D_CR_TCIE | DMA2D_CR_TEIE | DMA2D_CR_CTCIE | \
+			 DMA2D_CR_CAEIE | DMA2D_CR_CEIE)
+#define DMA2D_ISR_DONE	(DMA2D_ISR_TCIF | DMA2D_ISR_CTCIF)
+#define DMA2D_ISR_ERR	(DMA2D_ISR_TEIF | DMA2D_ISR_CAEIF | DMA2D_ISR_CEIF)
+#define DMA2D_IFCR_ALL	0x3f
+
+#define DMA2D_BUSY()	((DMA2D_CR & DMA2D_CR_START) || \
+			 (DMA2D_FGPFCCR & DMA2D_xPFCCR_START) || \
+			 (DMA2D_BGPFCCR & DMA2D_xPFCCR_START))
+
+/* Register values of one queued operation */
+struct dma2d_op {
+	uint32_t cr;		/* 0 for a CLUT load, see dma2d_load_clut() */
+	uint32_t fgmar;
+	uint32_t fgor;
+	uint32_t fgpfccr;
+	uint32_t fgcolr;
+	uint32_t bgmar;
+	uint32_t bgor;
+	uint32_t bgpfccr;
+	uint32_t opfccr;
+	uint32_t ocolr;
+	uint32_t omar;
+	uint32_t oor;
+	uint32_t nlr;
+};
+
+static struct dma2d_op dma2d_queue[DMA2D_QUEUE_LEN];
+static volatile uint8_t dma2d_head;	/* written by the submitter */
+static volatile uint8_t dma2d_tail;	/* written by the interrupt */
+static volatile bool dma2d_running;
+static volatile uint32_t dma2d_errors;
+
+static const uint8_t dma2d_bits[] = {
+	[DMA2D_ARGB8888] = 32,
+	[DMA2D_RGB888] = 24,
+	[DMA2D_RGB565] = 16,
+	[DMA2D_ARGB1555] = 16,
+	[DMA2D_ARGB4444] = 16,
+	[DMA2D_L8] = 8,
+	[DMA2D_AL44] = 8,
+	[DMA2D_AL88] = 16,
+	[DMA2D_L4] = 4,
+	[DMA2D_A8] = 8,
+	[DMA2D_A4] = 4,
+};
+
+/* Address of pixel (x, y), x must be even for the 4 bit formats */
+static uint32_t dma2d_pixel(const struct dma2d_surface *s,
+			    uint16_t x, uint16_t y)
+{
+	return s->addr +
+	       (((uint32_t)y * s->pitch + x) * dma2d_bits[s->format]) / 8;
+}
+
+static uint32_t dma2d_pfccr(const struct dma2d_surface *s)
+{
+	return (uint32_t)s->format << DMA2D_xPFCCR_CM_SHIFT;
+}
+
+static void dma2d_start(const struct dma2d_op *op)
+{
+	if (op->cr == 0) {
+		/* CLUT load, fgpfccr is 0 when it goes to the background */
+		if (op->fgpfccr) {
+			DMA2D_FGCMAR = op->fgmar;
+			DMA2D_FGPFCCR = op->fgpfccr;
+		} else {
+			DMA2D_BGCMAR = op->bgmar;
+			DMA2D_BGPFCCR = op->bgpfccr;
+		}
+		return;
+	}
+
+	DMA2D_FGMAR = op->fgmar;
+	DMA2D_FGOR = op->fgor;
+	/* START in a PFCCR would run a CLUT load alongside the transfer */
+	DMA2D_FGPFCCR = op->fgpfccr & ~DMA2D_xPFCCR_START;
+	DMA2D_FGCOLR = op->fgcolr;
+	DMA2D_BGMAR = op->bgmar;
+	DMA2D_BGOR = op->bgor;
+	DMA2D_BGPFCCR = op->bgpfccr & ~DMA2D_xPFCCR_START;
+	DMA2D_OPFCCR = op->opfccr;
+	DMA2D_OCOLR = op->ocolr;
+	DMA2D_OMAR = op->omar;
+	DMA2D_OOR = op->oor;
+	DMA2D_NLR = op->nlr;
+	DMA2D_CR = op->cr;
+}
+
+/* Start the next queued operation, if any. Interrupts must be masked. */
+static void dma2d_next(void)
+{
+	if (dma2d_tail == dma2d_head) {
+		dma2d_running = false;
+		return;
+	}
+	dma2d_running = true;
+	dma2d_start(&dma2d_queue[dma2d_tail]);
+	dma2d_tail = (dma2d_tail + 1) % DMA2D_QUEUE_LEN;
+}
+
+/* Cleared slot the next operation is built in, NULL if the queue is full */
+static struct dma2d_op *dma2d_alloc(void)
+{
+	struct dma2d_op *op;
+
+	if ((dma2d_head + 1) % DMA2D_QUEUE_LEN == dma2d_tail) {
+		return NULL;
+	}
+	op = &dma2d_queue[dma2d_head];
+	memset(op, 0, sizeof(*op));
+	return op;
+}
+
+static bool dma2d_submit(void)
+{
+	CM_ATOMIC_BLOCK() {
+		dma2d_head = (dma2d_head + 1) % DMA2D_QUEUE_LEN;
+		if (!dma2d_running) {
+			dma2d_next();
+		}
+	}
+	return true;
+}
+
+/* The output side and size, common to every transfer */
+static void dma2d_output(struct dma2d_op *op, uint32_t mode,
+			 const struct dma2d_surface *dst, uint16_t x,
+			 uint16_t y, uint16_t w, uint16_t h)
+{
+	op->cr = (mode << DMA2D_CR_MODE_SHIFT) | DMA2D_CR_IRQS |
+		 DMA2D_CR_START;
+	op->opfccr = (uint32_t)dst->format << DMA2D_OPFCCR_CM_SHIFT;
+	op->omar = dma2d_pixel(dst, x, y);
+	op->oor = dst->pitch - w;
+	op->nlr = ((uint32_t)w << DMA2D_NLR_PL_SHIFT) |
+		  ((uint32_t)h << DMA2D_NLR_NL_SHIFT);
+}
+
+/**
+ * @brief Reset the queue and enable the DMA2D interrupts
+ */
+void dma2d_init(void)
+{
+	dma2d_abort();
+	/* Kept while CLUT loads run, transfers write them with START */
+	DMA2D_CR = DMA2D_CR_IRQS;
+	dma2d_errors = 0;
+}
+
+/**
+ * @brief Queue a fill of a rectangle with one color
+ *
+ * @param[in] dst Surface to fill, its format must be writable
+ * @param[in] x,y Top left corner of the rectangle
+ * @param[in] w,h Size of the rectangle in pixels
+ * @param[in] color Color in the format of @a dst, right aligned
+ * @returns false if the queue is full
+ */
+bool dma2d_fill(const struct dma2d_surface *dst, uint16_t x, uint16_t y,
+		uint16_t w, uint16_t h, uint32_t color)
+{
+	struct dma2d_op *op = dma2d_alloc();
+
+	if (!op) {
+		return false;
+	}
+	dma2d_output(op, DMA2D_CR_MODE_R2M, dst, x, y, w, h);
+	op->ocolr = color;
+	return dma2d_submit();
+}
+
+/**
+ * @brief Queue a copy of a rectangle between surfaces
+ *
+ * If the formats differ the pixels are converted, which also expands L8 and
+ * L4 sources through the foreground CLUT.
+ *
+ * @param[in] dst Destination surface, its format must be writable
+ * @param[in] dx,dy Top left corner in the destination
+ * @param[in] src Source surface
+ * @param[in] sx,sy Top left corner in the source
+ * @param[in] w,h Size of the rectangle in pixels
+ * @returns false if the queue is full
+ */
+bool dma2d_copy(const struct dma2d_surface *dst, uint16_t dx, uint16_t dy,
+		const struct dma2d_surface *src, uint16_t sx, uint16_t sy,
+		uint16_t w, uint16_t h)
+{
+	struct dma2d_op *op = dma2d_alloc();
+
+	if (!op) {
+		return false;
+	}
+	dma2d_output(op, src->format == dst->format ? DMA2D_CR_MODE_M2M :
+		     DMA2D_CR_MODE_M2MWPFC, dst, dx, dy, w, h);
+	op->fgmar = dma2d_pixel(src, sx, sy);
+	op->fgor = src->pitch - w;
+	op->fgpfccr = dma2d_pfccr(src);
+	op->fgcolr = src->color;
+	return dma2d_submit();
+}
+
+/**
+ * @brief Queue blending a rectangle over a surface
+ *
+ * The foreground is drawn over what is in @a dst, which is also the
+ * background. Pixel alpha of the foreground is multiplied with @a alpha.
+ * A8 and A4 foregrounds, glyphs for example, are drawn in their surface
+ * color.
+ *
+ * @param[in] dst Surface drawn on, its format must be writable
+ * @param[in] dx,dy Top left corner in the destination
+ * @param[in] fg Foreground surface
+ * @param[in] fx,fy Top left corner in the foreground
+ * @param[in] w,h Size of the rectangle in pixels
+ * @param[in] alpha Constant alpha, 255 for the pixel alpha only
+ * @returns false if the queue is full
+ */
+bool dma2d_blend(const struct dma2d_surface *dst, uint16_t dx, uint16_t dy,
+		 const struct dma2d_surface *fg, uint16_t fx, uint16_t fy,
+		 uint16_t w, uint16_t h, uint8_t alpha)
+{
+	struct dma2d_op *op = dma2d_alloc();
+
+	if (!op) {
+		return false;
+	}
+	dma2d_output(op, DMA2D_CR_MODE_M2MWB, dst, dx, dy, w, h);
+	op->fgmar = dma2d_pixel(fg, fx, fy);
+	op->fgor = fg->pitch - w;
+	op->fgpfccr = dma2d_pfccr(fg) |
+		      ((uint32_t)alpha << DMA2D_xPFCCR_ALPHA_SHIFT) |
+		      (DMA2D_xPFCCR_AM_PRODUCT << DMA2D_xPFCCR_AM_SHIFT);
+	op->fgcolr = fg->color;
+	op->bgmar = op->omar;
+	op->bgor = op->oor;
+	op->bgpfccr = dma2d_pfccr(dst);
+	return dma2d_submit();
+}
+
+/**
+ * @brief Queue loading a color lookup table
+ *
+ * The foreground CLUT is used by copies and blends from L8, L4, AL44 and
+ * AL88 surfaces, the background CLUT is used when blending onto them.
+ *
+ * @param[in] background Load the background instead of the foreground CLUT
+ * @param[in] clut Table, 32 bit ARGB8888 or packed 24 bit RGB888 entries
+ * @param[in] entries Number of entries, 1 to 256
+ * @param[in] rgb888 The table is in RGB888
+ * @returns false if the queue is full
+ */
+bool dma2d_load_clut(bool background, const uint32_t *clut,
+		     uint16_t entries, bool rgb888)
+{
+	struct dma2d_op *op = dma2d_alloc();
+	uint32_t pfccr;
+
+	if (!op) {
+		return false;
+	}
+	pfccr = ((uint32_t)(entries - 1) << DMA2D_xPFCCR_CS_SHIFT) |
+		(rgb888 ? DMA2D_xPFCCR_CCM_RGB888 : DMA2D_xPFCCR_CCM_ARGB8888) |
+		DMA2D_xPFCCR_START;
+	if (background) {
+		op->bgmar = (uint32_t)clut;
+		op->bgpfccr = pfccr;
+	} else {
+		op->fgmar = (uint32_t)clut;
+		op->fgpfccr = pfccr;
+	}
+	return dma2d_submit();
+}
+
+/**
+ * @brief Check whether all queued operations have completed
+ */
+bool dma2d_idle(void)
+{
+	return !dma2d_running;
+}
+
+/**
+ * @brief Wait until all queued operations have completed
+ */
+void dma2d_wait(void)
+{
+	while (dma2d_running);
+}
+
+/**
+ * @brief Abort the running operation and drop the queue
+ */
+void dma2d_abort(void)
+{
+	CM_ATOMIC_BLOCK() {
+		/* Also stops a CLUT load */
+		if (DMA2D_BUSY()) {
+			DMA2D_CR |= DMA2D_CR_ABORT;
+			while (DMA2D_BUSY());
+		}
+		DMA2D_IFCR = DMA2D_IFCR_ALL;
+		dma2d_tail = dma2d_head;
+		dma2d_running = false;
+	}
+}
+
+/**
+ * @brief Number of operations that ended with a transfer, CLUT access or
+ * configuration error since @ref dma2d_init()
+ */
+uint32_t dma2d_get_errors(void)
+{
+	return dma2d_errors;
+}
+
+/**
+ * @brief Start the next operation, call from dma2d_isr()
+ *
+ * A failed operation is counted and the queue goes on with the next one.
+ */
+void dma2d_irq(void)
+{
+	uint32_t isr = DMA2D_ISR;
+
+	DMA2D_IFCR = isr & DMA2D_IFCR_ALL;
+	if (isr & DMA2D_ISR_ERR) {
+		dma2d_errors++;
+	}
+	if (isr & (DMA2D_ISR_DONE | DMA2D_ISR_ERR)) {
+		dma2d_next();
+	}
+}
+
+/**@}*/
@@ -19,8 +19,13 @@
 /* Utility functions for the SDRAM component of the FMC */
 
 #include <stdint.h>
+#include <stddef.h>
 #include <libopencm3/stm32/fsmc.h>
 
+/* Start and end of the .xdram section, when the linker script has one */
+extern uint32_t _xdram __attribute__((weak));
+extern uint32_t _exdram __attribute__((weak));
+
 /*
  * Install various timing values into the correct place in the
  * SDRAM Timing Control Register format.
@@ -97,3 +102,204 @@ sdram_command(enum fmc_sdram_bank bank,
 	/* Send the next command */
 	FMC_SDCMR = tmp_reg;
 }
+
+/* Round a data sheet time up to SDRAM clocks, within the 1..16 of SDTR */
+static int sdram_clocks(uint16_t ns, uint32_t sdclk_hz)
+{
+	uint32_t clk;
+
+	/* Anything longer is more than 16 clocks anyway, and can't overflow */
+	if (ns > 4000) {
+		ns = 4000;
+	}
+	clk = (ns * (sdclk_hz / 1000) + 999999) / 1000000;
+	if (clk < 1) {
+		return 1;
+	}
+	return clk > 16 ? 16 : clk;
+}
+
+/*
+ * Fill a timing set for sdram_timing() from the nanosecond values of the
+ * part at the given SDRAM clock, HCLK divided by 2 or 3.
+ */
+void
+sdram_timing_from_ns(struct sdram_timing *t, const struct sdram_device *dev,
+		     uint32_t sdclk_hz) {
+	t->trcd = sdram_clocks(dev->trcd_ns, sdclk_hz);
+	t->trp = sdram_clocks(dev->trp_ns, sdclk_hz);
+	t->twr = sdram_clocks(dev->twr_ns, sdclk_hz);
+	t->trc = sdram_clocks(dev->trc_ns, sdclk_hz);
+	t->tras = sdram_clocks(dev->tras_ns, sdclk_hz);
+	t->txsr = sdram_clocks(dev->txsr_ns, sdclk_hz);
+	t->tmrd = dev->tmrd ? dev->tmrd : 2;
+
+	/* The controller also needs TWR >= TRAS - TRCD and TRC - TRCD - TRP */
+	if (t->twr < t->tras - t->trcd) {
+		t->twr = t->tras - t->trcd;
+	}
+	if (t->twr < t->trc - t->trcd - t->trp) {
+		t->twr = t->trc - t->trcd - t->trp;
+	}
+}
+
+/*
+ * Refresh timer count for FMC_SDRTR: one row every refresh_ms / rows, less
+ * the 20 clocks of margin the reference manual asks for.
+ */
+uint32_t
+sdram_refresh_count(const struct sdram_device *dev, uint32_t sdclk_hz) {
+	uint32_t count;
+
+	count = (sdclk_hz / 1000) * dev->refresh_ms / (1 << dev->rows);
+	count = count > 20 ? count - 20 : 0;
+	if (count < 41) {
+		count = 41;
+	}
+	return count > 0x1fff ? 0x1fff : count;
+}
+
+/* Where the bank shows up in the memory map */
+uint32_t
+sdram_bank_address(enum fmc_sdram_bank bank) {
+	return bank == SDRAM_BANK2 ? FMC_BANK8_BASE : FMC_BANK7_BASE;
+}
+
+/* Size of the part in bytes */
+uint32_t
+sdram_size(const struct sdram_device *dev) {
+	return (1U << (dev->rows + dev->columns)) * dev->banks *
+	       (dev->width / 8);
+}
+
+/*
+ * Bring up one SDRAM bank: controller setup from the part description,
+ * then the JEDEC power up sequence of clock enable, 100us wait, precharge
+ * all, eight auto refreshes and mode register load (burst length 1, the
+ * CAS latency, single writes), and finally the refresh rate.
+ *
+ * hclk_hz is the AHB clock, sdclk_div 2 or 3 selects the SDRAM clock.
+ * The FMC clock and the pins must already be enabled. Returns false if
+ * the description can't be programmed or the refresh failed.
+ */
+bool
+sdram_init(enum fmc_sdram_bank bank, const struct sdram_device *dev,
+	   uint32_t hclk_hz, uint32_t sdclk_div) {
+	const uint32_t sdclk_hz = hclk_hz / sdclk_div;
+	struct sdram_timing t;
+	uint32_t cr, tr;
+	uint16_t mode;
+	volatile uint32_t i;
+	int n = bank == SDRAM_BANK2 ? 1 : 0;
+
+	if (bank == SDRAM_BOTH_BANKS ||
+	    dev->columns < 8 || dev->columns > 11 ||
+	    dev->rows < 11 || dev->rows > 13 ||
+	    dev->cas < 1 || dev->cas > 3 ||
+	    (sdclk_div != 2 && sdclk_div != 3)) {
+		return false;
+	}
+
+	cr = ((dev->columns - 8) << FMC_SDCR_NC_SHIFT) |
+	     ((dev->rows - 11) << FMC_SDCR_NR_SHIFT) |
+	     (dev->width == 32 ? FMC_SDCR_MWID_32b :
+	      dev->width == 16 ? FMC_SDCR_MWID_16b : FMC_SDCR_MWID_8b) |
+	     (dev->banks == 4 ? FMC_SDCR_NB4 : FMC_SDCR_NB2) |
+	     (dev->cas << FMC_SDCR_CAS_SHIFT) |
+	     (sdclk_div << FMC_SDCR_SDCLK_SHIFT) |
+	     FMC_SDCR_RBURST | FMC_SDCR_RPIPE_1CLK;
+
+	sdram_timing_from_ns(&t, dev, sdclk_hz);
+	tr = sdram_timing(&t);
+
+	/* The shared bits only count in the bank 1 registers */
+	if (n) {
+		FMC_SDCR1 = (FMC_SDCR1 & ~FMC_SDCR_DNC_MASK) |
+			    (cr & FMC_SDCR_DNC_MASK);
+		FMC_SDTR1 = (FMC_SDTR1 & ~FMC_SDTR_DNC_MASK) |
+			    (tr & FMC_SDTR_DNC_MASK);
+	}
+	FMC_SDCR(n) = cr;
+	FMC_SDTR(n) = tr;
+
+	sdram_command(bank, SDRAM_CLK_CONF, 0, 0);
+	/* At least 100us, a loop pass takes more than one clock */
+	for (i = 0; i < hclk_hz / 10000; i++);
+	sdram_command(bank, SDRAM_PALL, 0, 0);
+	/* NRFS holds the count less one */
+	sdram_command(bank, SDRAM_AUTO_REFRESH, 7, 0);
+	mode = SDRAM_MODE_BURST_LENGTH_1 | SDRAM_MODE_BURST_TYPE_SEQUENTIAL |
+	       (dev->cas << 4) | SDRAM_MODE_OPERATING_MODE_STANDARD |
+	       SDRAM_MODE_WRITEBURST_MODE_SINGLE;
+	sdram_command(bank, SDRAM_LOAD_MODE, 0, mode);
+
+	FMC_SDRTR = sdram_refresh_count(dev, sdclk_hz) << FMC_SDRTR_COUNT_SHIFT;
+	while (FMC_SDSR & FMC_SDSR_BUSY);
+
+	return !(FMC_SDSR & FMC_SDSR_RE);
+}
+
+/*
+ * Zero the .xdram section of the generated linker script, which the
+ * startup code can't do as the SDRAM is not running yet. Call it after
+ * sdram_init(), it does nothing without such a section.
+ */
+void
+sdram_clear_section(void) {
+	uint32_t *p;
+
+	for (p = &_xdram; p < &_exdram; p++) {
+		*p = 0;
+	}
+}
+
+/*
+ * Arena allocator for large buffers in SDRAM, frame or sample buffers that
+ * live for the whole program or a phase of it. There is no free, memory
+ * comes back with sdram_arena_release() to a mark, or all at once. With
+ * the generated linker script, the space after the static data is
+ *	sdram_arena_init(&arena, &_exdram, &_xdram_end - &_exdram);
+ * for uint8_t declarations of both symbols.
+ */
+void
+sdram_arena_init(struct sdram_arena *arena, void *start, uint32_t size) {
+	arena->start = (uint32_t)start;
+	arena->top = arena->start;
+	arena->end = arena->start + size;
+}
+
+/* NULL if the arena is full, align is a power of two */
+void *
+sdram_arena_alloc(struct sdram_arena *arena, uint32_t size, uint32_t align) {
+	uint32_t p;
+
+	if (align < 4) {
+		align = 4;
+	}
+	p = (arena->top + align - 1) & ~(align - 1);
+	if (p < arena->top || size > arena->end - p) {
+		return NULL;
+	}
+	arena->top = p + size;
+	return (void *)p;
+}
+
+uint32_t
+sdram_arena_available(const struct sdram_arena *arena) {
+	return arena->end - arena->top;
+}
+
+/* The current fill level, to go back to with sdram_arena_release() */
+uint32_t
+sdram_arena_mark(const struct sdram_arena *arena) {
+	return arena->top;
+}
+
+/* Free everything allocated since the mark, 0 frees everything */
+void
+sdram_arena_release(struct sdram_arena *arena, uint32_t mark) {
+	if (mark < arena->start || mark > arena->top) {
+		mark = arena->start;
+	}
+	arena->top = mark;
+}
@@ -17,6 +17,15 @@
  * For the STM32F4xx, LTDC is described in LCD-TFT Controller (LTDC)
  * section 16 of the STM32F4xx Reference Manual (RM0090,Rev8).
  *
+ * Framebuffer flipping: register two or three buffers for a layer with
+ * ltdc_fb_init(), draw into ltdc_fb_get_back() and hand it over with
+ * ltdc_fb_flip(). The new address is written at the line event and taken
+ * over by the shadow reload at the following vertical blanking, so a flip
+ * never tears. With two buffers ltdc_fb_get_back() returns 0 until the old
+ * front buffer is off screen, with three the next buffer is free at once.
+ * ltdc_fb_irq() must be called from lcd_tft_isr() with NVIC_LCD_TFT_IRQ
+ * enabled.
+ *
  *
  * LGPL License Terms @ref lgpl_license
  */
@@ -41,6 +50,29 @@
  */
 
 #include <libopencm3/stm32/f4/ltdc.h>
+#include <libopencm3/cm3/cortex.h>
+
+#define LTDC_FB_NONE 0xff
+
+static struct ltdc_fb {
+	uint32_t buf[LTDC_FB_MAX];
+	uint8_t count;
+	uint8_t front;		/* on screen */
+	uint8_t draw;		/* handed out by ltdc_fb_get_back() */
+	uint8_t pending;	/* flipped, waiting for the line event */
+	bool issued;		/* pending written, waiting for the reload */
+} ltdc_fb[2] = {
+	/* Layers not given to ltdc_fb_init() are left alone */
+	{ .front = LTDC_FB_NONE, .draw = LTDC_FB_NONE,
+	  .pending = LTDC_FB_NONE },
+	{ .front = LTDC_FB_NONE, .draw = LTDC_FB_NONE,
+	  .pending = LTDC_FB_NONE },
+};
+
+static void (*ltdc_line_callback)(void);
+static struct ltdc_fb_stats ltdc_stats;
+static uint32_t ltdc_last_flip_frame;
+static uint8_t ltdc_interval = 1;
 
 void ltdc_set_tft_sync_timings(uint16_t sync_width,    uint16_t sync_height,
 			       uint16_t h_back_porch,  uint16_t v_back_porch,
@@ -87,3 +119,226 @@ void ltdc_setup_windowing(uint8_t  layer_number,
 				     (v_back_porch << 0);
 }
 
+
+static uint8_t ltdc_fb_free(const struct ltdc_fb *fb)
+{
+	uint8_t i;
+
+	for (i = 0; i < fb->count; i++) {
+		if (i != fb->front && i != fb->pending && i != fb->draw) {
+			return i;
+		}
+	}
+	return LTDC_FB_NONE;
+}
+
+/**
+ * Register the framebuffers of a layer, the first one is shown at once.
+ *
+ * Also enables the line event, at the end of the active area unless
+ * ltdc_fb_set_line_callback() moved it, and the reload interrupt.
+ * ltdc_set_tft_sync_timings() must have been called.
+ */
+void ltdc_fb_init(uint8_t layer, const uint32_t *buffers, uint8_t count)
+{
+	struct ltdc_fb *fb = &ltdc_fb[layer - 1];
+	uint8_t i;
+
+	if (count > LTDC_FB_MAX) {
+		count = LTDC_FB_MAX;
+	}
+
+	CM_ATOMIC_BLOCK() {
+		for (i = 0; i < count; i++) {
+			fb->buf[i] = buffers[i];
+		}
+		fb->count = count;
+		fb->front = 0;
+		fb->pending = LTDC_FB_NONE;
+		fb->draw = LTDC_FB_NONE;
+		fb->issued = false;
+		fb->draw = ltdc_fb_free(fb);
+	}
+
+	ltdc_set_fbuffer_address(layer, buffers[0]);
+	ltdc_reload(LTDC_SRCR_VBR);
+
+	if (!ltdc_line_callback) {
+		LTDC_LIPCR = LTDC_AWCR & LTDC_AWCR_AAH_MASK;
+	}
+	LTDC_ICR = LTDC_ICR_CRRIF | LTDC_ICR_CLIF;
+	LTDC_IER |= LTDC_IER_RRIE | LTDC_IER_LIE;
+}
+
+/**
+ * Buffer to draw the next frame into, 0 while none is free.
+ */
+uint32_t ltdc_fb_get_back(uint8_t layer)
+{
+	const struct ltdc_fb *fb = &ltdc_fb[layer - 1];
+	uint8_t draw = fb->draw;
+
+	return draw == LTDC_FB_NONE ? 0 : fb->buf[draw];
+}
+
+/**
+ * Buffer on screen, 0 for a layer not set up with ltdc_fb_init().
+ */
+uint32_t ltdc_fb_get_front(uint8_t layer)
+{
+	const struct ltdc_fb *fb = &ltdc_fb[layer - 1];
+
+	return fb->front == LTDC_FB_NONE ? 0 : fb->buf[fb->front];
+}
+
+/**
+ * Show the back buffer from the next vertical blanking on.
+ *
+ * Returns false if there is no back buffer, or a flip of this layer is
+ * still waiting, at most one flip per refresh is possible.
+ */
+bool ltdc_fb_flip(uint8_t layer)
+{
+	struct ltdc_fb *fb = &ltdc_fb[layer - 1];
+	bool ok = false;
+
+	CM_ATOMIC_BLOCK() {
+		if (fb->draw != LTDC_FB_NONE && fb->pending == LTDC_FB_NONE) {
+			fb->pending = fb->draw;
+			fb->draw = ltdc_fb_free(fb);
+			ok = true;
+		}
+	}
+	return ok;
+}
+
+/**
+ * Whether a flip of the layer has not reached the screen yet.
+ */
+bool ltdc_fb_flip_pending(uint8_t layer)
+{
+	return ltdc_fb[layer - 1].pending != LTDC_FB_NONE;
+}
+
+/**
+ * Move the line event and call a function on it once per refresh.
+ *
+ * Lines count from the start of vertical sync, as the sync and back porch
+ * timings are accumulated. Flips are written at this line, so it should be
+ * in the active area; rendering can chase the scan out from here on without
+ * tearing. Pass a NULL callback to only move the line.
+ */
+void ltdc_fb_set_line_callback(uint16_t line, void (*callback)(void))
+{
+	ltdc_line_callback = callback;
+	LTDC_LIPCR = line & LTDC_LIPCR_LIPOS_MASK;
+}
+
+/**
+ * Clear the frame statistics.
+ *
+ * @param[in] interval Refreshes per frame the application aims at, each
+ * flip that comes later counts the refreshes it missed as dropped.
+ */
+void ltdc_fb_stats_reset(uint8_t interval)
+{
+	CM_ATOMIC_BLOCK() {
+		ltdc_stats.frames = 0;
+		ltdc_stats.flips = 0;
+		ltdc_stats.dropped = 0;
+		ltdc_stats.last_interval = 0;
+		ltdc_stats.max_interval = 0;
+		ltdc_last_flip_frame = 0;
+		ltdc_interval = interval ? interval : 1;
+	}
+}
+
+void ltdc_fb_get_stats(struct ltdc_fb_stats *stats)
+{
+	CM_ATOMIC_BLOCK() {
+		*stats = ltdc_stats;
+	}
+}
+
+/* Shadow registers reloaded, issued flips are on screen now */
+static void ltdc_fb_reloaded(void)
+{
+	struct ltdc_fb *fb;
+	uint32_t interval;
+	bool flipped = false;
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		fb = &ltdc_fb[i];
+		if (!fb->issued) {
+			continue;
+		}
+		fb->issued = false;
+		fb->front = fb->pending;
+		fb->pending = LTDC_FB_NONE;
+		if (fb->draw == LTDC_FB_NONE) {
+			fb->draw = ltdc_fb_free(fb);
+		}
+		ltdc_stats.flips++;
+		flipped = true;
+	}
+	if (!flipped) {
+		return;
+	}
+
+	interval = ltdc_stats.frames - ltdc_last_flip_frame;
+	ltdc_last_flip_frame = ltdc_stats.frames;
+	if (interval > 0xffff) {
+		interval = 0xffff;
+	}
+	ltdc_stats.last_interval = interval;
+	if (interval > ltdc_stats.max_interval) {
+		ltdc_stats.max_interval = interval;
+	}
+	if (interval > ltdc_interval) {
+		ltdc_stats.dropped += interval - ltdc_interval;
+	}
+}
+
+/* Line event, write waiting flips for the reload at the next blanking */
+static void ltdc_fb_line(void)
+{
+	struct ltdc_fb *fb;
+	bool reload = false;
+	int i;
+
+	ltdc_stats.frames++;
+	for (i = 0; i < 2; i++) {
+		fb = &ltdc_fb[i];
+		if (fb->pending == LTDC_FB_NONE || fb->issued) {
+			continue;
+		}
+		ltdc_set_fbuffer_address(LTDC_LAYER_1 + i,
+					 fb->buf[fb->pending]);
+		fb->issued = true;
+		reload = true;
+	}
+	if (reload) {
+		ltdc_reload(LTDC_SRCR_VBR);
+	}
+
+	if (ltdc_line_callback) {
+		ltdc_line_callback();
+	}
+}
+
+/**
+ * Framebuffer interrupt handling, call from lcd_tft_isr().
+ */
+void ltdc_fb_irq(void)
+{
+	uint32_t isr = LTDC_ISR;
+
+	LTDC_ICR = isr & (LTDC_ICR_CRRIF | LTDC_ICR_CLIF);
+	if (isr & LTDC_ISR_RRIF) {
+		ltdc_fb_reloaded();
+	}
+	if (isr & LTDC_ISR_LIF) {
+		ltdc_fb_line();
+	}
+}
@@ -38,9 +38,37 @@
 
 void pwr_set_vos_scale(enum pwr_vos_scale scale)
 {
-	if (scale == PWR_SCALE1) {
-		PWR_CR |= PWR_CR_VOS;
-	} else if (scale == PWR_SCALE2) {
-		PWR_CR &= PWR_CR_VOS;
+	uint32_t reg32 = PWR_CR & ~(PWR_CR_VOS_MASK << PWR_CR_VOS_SHIFT);
+
+	/* Bit 15 is reserved and ignored on F40x, bit 14 alone picks 1 or 2 */
+	switch (scale) {
+	case PWR_SCALE1:
+		reg32 |= PWR_CR_VOS_SCALE_1 << PWR_CR_VOS_SHIFT;
+		break;
+	case PWR_SCALE2:
+		reg32 |= PWR_CR_VOS_SCALE_2 << PWR_CR_VOS_SHIFT;
+		break;
+	case PWR_SCALE3:
+		reg32 |= PWR_CR_VOS_SCALE_3 << PWR_CR_VOS_SHIFT;
+		break;
 	}
+	PWR_CR = reg32;
+}
+
+/*
+ * Over-drive raises the core voltage for 168 to 180MHz.  Switch it with
+ * the system clock on HSI or HSE, after the PLL is enabled.
+ */
+void pwr_enable_overdrive(void)
+{
+	PWR_CR |= PWR_CR_ODEN;
+	while (!(PWR_CSR & PWR_CSR_ODRDY));
+	PWR_CR |= PWR_CR_ODSWEN;
+	while (!(PWR_CSR & PWR_CSR_ODSWRDY));
+}
+
+void pwr_disable_overdrive(void)
+{
+	PWR_CR &= ~(PWR_CR_ODEN | PWR_CR_ODSWEN);
+	while (PWR_CSR & PWR_CSR_ODSWRDY);
 }
@@ -729,4 +729,297 @@ void rcc_clock_setup_hse_3v3(const struct rcc_clock_scale *clock)
 	rcc_osc_off(RCC_HSI);
 }
 
+/*---------------------------------------------------------------------------*/
+/** @brief Save the Running Clock Configuration
+
+Stop mode switches the oscillators and PLLs off and the system clock to HSI
+but keeps their configuration, prescalers and flash wait states.  Save the
+clock tree before Stop and bring it back after with rcc_clock_restore(),
+which only does the steps that are missing instead of the full
+rcc_clock_setup_hse_3v3().
+
+@param[out] state Clock configuration.
+*/
+void rcc_clock_save(struct rcc_clock_state *state)
+{
+	state->cr = RCC_CR;
+	state->cfgr = RCC_CFGR;
+	state->pllcfgr = RCC_PLLCFGR;
+	state->plli2scfgr = RCC_PLLI2SCFGR;
+	state->pllsaicfgr = RCC_PLLSAICFGR;
+	state->flash_ws = FLASH_ACR & FLASH_ACR_LATENCY_MASK;
+	state->ahb_frequency = rcc_ahb_frequency;
+	state->apb1_frequency = rcc_apb1_frequency;
+	state->apb2_frequency = rcc_apb2_frequency;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Start Restoring a Saved Clock Configuration
+
+Switches on the saved oscillators and returns without waiting.  The HSE
+crystal takes the longest to start, so call this first thing after waking
+up and let the code keep running on HSI.  Finish with
+rcc_clock_restore_poll() or rcc_clock_restore() before anything that needs
+the saved clocks, e.g. in the drivers that need them, so wake ups that only
+handle an interrupt never wait for the PLL at all.
+
+@param[in] state Clock configuration from rcc_clock_save().
+*/
+void rcc_clock_restore_start(const struct rcc_clock_state *state)
+{
+	if ((state->cr & RCC_CR_HSEON) && !(RCC_CR & RCC_CR_HSEON)) {
+		RCC_CR |= state->cr & RCC_CR_HSEBYP;
+		RCC_CR |= RCC_CR_HSEON;
+	}
+	if (state->cr & RCC_CR_HSION) {
+		RCC_CR |= RCC_CR_HSION;
+	}
+}
+
+static bool rcc_clock_restore_pll(const struct rcc_clock_state *state,
+				  uint32_t on, uint32_t rdy,
+				  volatile uint32_t *cfgr, uint32_t value)
+{
+	if (!(state->cr & on)) {
+		return true;
+	}
+	if (!(RCC_CR & on)) {
+		*cfgr = value;
+		RCC_CR |= on;
+	}
+	return RCC_CR & rdy;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Advance Restoring a Saved Clock Configuration
+
+Does every step that is ready without waiting: PLL on once HSE runs, flash
+wait states and system clock switch once the PLL locked, then the I2S and
+SAI PLLs.  The bus frequencies are updated at the end.
+
+@param[in] state Clock configuration from rcc_clock_save().
+@returns true when the saved configuration runs again.
+*/
+bool rcc_clock_restore_poll(const struct rcc_clock_state *state)
+{
+	bool done = true;
+
+	rcc_clock_restore_start(state);
+	if ((state->cr & RCC_CR_HSEON) && !(RCC_CR & RCC_CR_HSERDY)) {
+		return false;
+	}
+	if (!rcc_clock_restore_pll(state, RCC_CR_PLLON, RCC_CR_PLLRDY,
+				   &RCC_PLLCFGR, state->pllcfgr)) {
+		return false;
+	}
+
+	if (rcc_system_clock_source() != (state->cfgr & 3)) {
+		/* More wait states before speeding up */
+		if ((FLASH_ACR & FLASH_ACR_LATENCY_MASK) < state->flash_ws) {
+			flash_set_ws(state->flash_ws);
+		}
+		RCC_CFGR = state->cfgr;
+		if (rcc_system_clock_source() != (state->cfgr & 3)) {
+			return false;
+		}
+	}
+	if ((FLASH_ACR & FLASH_ACR_LATENCY_MASK) != state->flash_ws) {
+		flash_set_ws(state->flash_ws);
+	}
+	if (!(state->cr & RCC_CR_HSION)) {
+		RCC_CR &= ~RCC_CR_HSION;
+	}
+	rcc_ahb_frequency = state->ahb_frequency;
+	rcc_apb1_frequency = state->apb1_frequency;
+	rcc_apb2_frequency = state->apb2_frequency;
+
+	done &= rcc_clock_restore_pll(state, RCC_CR_PLLI2SON, RCC_CR_PLLI2SRDY,
+				      &RCC_PLLI2SCFGR, state->plli2scfgr);
+	done &= rcc_clock_restore_pll(state, RCC_CR_PLLSAION, RCC_CR_PLLSAIRDY,
+				      &RCC_PLLSAICFGR, state->pllsaicfgr);
+	return done;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Restore a Saved Clock Configuration
+
+Returns at once when the configuration already runs.
+
+@param[in] state Clock configuration from rcc_clock_save().
+*/
+void rcc_clock_restore(const struct rcc_clock_state *state)
+{
+	while (!rcc_clock_restore_poll(state));
+}
+
+/*---------------------------------------------------------------------------*/
+/* Dynamic voltage and frequency scaling
+ *
+ * rcc_dvfs_set_level() moves between performance levels at runtime, e.g.
+ * 16MHz from HSI while idle and 180MHz from the PLL for signal processing.
+ * When only the bus prescalers differ it just changes those, with the
+ * flash wait states raised before and lowered after.  Otherwise it parks
+ * the system clock on HSI, which runs at any voltage scale and wait states,
+ * turns over-drive and the PLL off, sets the voltage scale, brings up the
+ * new PLL, with over-drive if asked for, and switches over.  HSI and HSE
+ * are switched off again when no longer used, but only if they were started
+ * here and do not feed PLLI2S or PLLSAI.  Those take the input and PLLM of
+ * the main PLL, so while they run all levels must keep pll_hse and pllm.
+ * The PWR clock must be enabled.
+ */
+
+static const struct rcc_dvfs_level *rcc_dvfs_current;
+static uint32_t rcc_dvfs_started;	/* RCC_CR_xxxON started here */
+
+/* Start an oscillator, remembering it if it was off */
+static void rcc_dvfs_osc_on(enum rcc_osc osc, uint32_t on)
+{
+	if (!(RCC_CR & on)) {
+		rcc_dvfs_started |= on;
+		rcc_osc_on(osc);
+	}
+}
+
+/* Stop an oscillator started here, unless PLLI2S or PLLSAI run from it */
+static void rcc_dvfs_osc_off(enum rcc_osc osc, uint32_t on)
+{
+	uint32_t in_use = 0;
+
+	if (RCC_CR & (RCC_CR_PLLI2SON | RCC_CR_PLLSAION)) {
+		in_use = (RCC_PLLCFGR & RCC_PLLCFGR_PLLSRC) ? RCC_CR_HSEON :
+							       RCC_CR_HSION;
+	}
+	if ((rcc_dvfs_started & on) && !(in_use & on)) {
+		rcc_dvfs_started &= ~on;
+		rcc_osc_off(osc);
+	}
+}
+
+static bool rcc_dvfs_same_pll(const struct rcc_dvfs_level *a,
+			      const struct rcc_dvfs_level *b)
+{
+	return a && a->sysclk == RCC_CFGR_SW_PLL &&
+	       b->sysclk == RCC_CFGR_SW_PLL && a->pll_hse == b->pll_hse &&
+	       a->pllm == b->pllm && a->plln == b->plln &&
+	       a->pllp == b->pllp && a->pllq == b->pllq &&
+	       a->pllr == b->pllr && a->vos == b->vos &&
+	       a->overdrive == b->overdrive;
+}
+
+static void rcc_dvfs_switch(const struct rcc_dvfs_level *level)
+{
+	uint32_t ws = level->flash_config & FLASH_ACR_LATENCY_MASK;
+
+	if ((FLASH_ACR & FLASH_ACR_LATENCY_MASK) < ws) {
+		flash_set_ws(level->flash_config);
+	}
+
+	/* Keep the APB clocks in range in between */
+	if (level->ahb_frequency > rcc_ahb_frequency) {
+		rcc_set_ppre1(level->ppre1);
+		rcc_set_ppre2(level->ppre2);
+		rcc_set_hpre(level->hpre);
+	} else {
+		rcc_set_hpre(level->hpre);
+		rcc_set_ppre1(level->ppre1);
+		rcc_set_ppre2(level->ppre2);
+	}
+
+	rcc_set_sysclk_source(level->sysclk);
+	while (rcc_system_clock_source() != level->sysclk);
+
+	flash_set_ws(level->flash_config);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Switch to a Performance Level
+
+Blocks until the new clocks run, as long as HSE and PLL take to start when
+they have to.  Notifiers are called before and after the change from the
+calling context.
+
+@param[in] level New level, must stay valid while it is in use.
+*/
+void rcc_dvfs_set_level(const struct rcc_dvfs_level *level)
+{
+	bool hse = level->sysclk == RCC_CFGR_SW_HSE ||
+		   (level->sysclk == RCC_CFGR_SW_PLL && level->pll_hse);
+	bool hsi = level->sysclk == RCC_CFGR_SW_HSI ||
+		   (level->sysclk == RCC_CFGR_SW_PLL && !level->pll_hse);
+
+	if (level == rcc_dvfs_current) {
+		return;
+	}
+	rcc_dvfs_notify(RCC_DVFS_PRE_CHANGE, level);
+
+	if (rcc_dvfs_same_pll(rcc_dvfs_current, level)) {
+		rcc_dvfs_switch(level);
+	} else {
+		/* HSE starts while the rest is done */
+		if (hse) {
+			rcc_dvfs_osc_on(RCC_HSE, RCC_CR_HSEON);
+		}
+
+		rcc_dvfs_osc_on(RCC_HSI, RCC_CR_HSION);
+		rcc_wait_for_osc_ready(RCC_HSI);
+		rcc_set_sysclk_source(RCC_CFGR_SW_HSI);
+		rcc_wait_for_sysclk_status(RCC_HSI);
+		rcc_ahb_frequency = 16000000;
+
+		if (PWR_CR & PWR_CR_ODEN) {
+			pwr_disable_overdrive();
+		}
+		rcc_osc_off(RCC_PLL);
+		while (RCC_CR & RCC_CR_PLLRDY);
+		pwr_set_vos_scale(level->vos);
+
+		if (level->sysclk == RCC_CFGR_SW_PLL) {
+			if (level->pll_hse) {
+				rcc_wait_for_osc_ready(RCC_HSE);
+				rcc_set_main_pll_hse(level->pllm, level->plln,
+						     level->pllp, level->pllq,
+						     level->pllr);
+			} else {
+				rcc_set_main_pll_hsi(level->pllm, level->plln,
+						     level->pllp, level->pllq,
+						     level->pllr);
+			}
+			rcc_osc_on(RCC_PLL);
+			if (level->overdrive) {
+				pwr_enable_overdrive();
+			}
+			rcc_wait_for_osc_ready(RCC_PLL);
+			while (!(PWR_CSR & PWR_CSR_VOSRDY));
+		} else if (hse) {
+			rcc_wait_for_osc_ready(RCC_HSE);
+		}
+
+		rcc_dvfs_switch(level);
+
+		if (!hse) {
+			rcc_dvfs_osc_off(RCC_HSE, RCC_CR_HSEON);
+		}
+		if (!hsi) {
+			rcc_dvfs_osc_off(RCC_HSI, RCC_CR_HSION);
+		}
+	}
+
+	rcc_ahb_frequency = level->ahb_frequency;
+	rcc_apb1_frequency = level->apb1_frequency;
+	rcc_apb2_frequency = level->apb2_frequency;
+	rcc_dvfs_current = level;
+
+	rcc_dvfs_notify(RCC_DVFS_POST_CHANGE, level);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Get the Running Performance Level
+
+@returns Level set last, NULL before the first rcc_dvfs_set_level().
+*/
+const struct rcc_dvfs_level *rcc_dvfs_get_level(void)
+{
+	return rcc_dvfs_current;
+}
+
 /**@}*/
@@ -37,6 +37,8 @@
 
 /**@{*/
 #include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/flash.h>
+#include <libopencm3/stm32/pwr.h>
 
 /* Set the default clock frequencies after reset. */
 uint32_t rcc_ahb_frequency = 4000000;
@@ -369,4 +371,348 @@ void rcc_set_msi_range_standby(uint32_t msi_range)
 	RCC_CSR = reg;
 }
 
+/**
+ * Select the clock running after Stop.
+ * MSI wakes up fastest and keeps its range, HSI16 gives a fixed frequency
+ * for peripherals that have to run right away.
+ * @param stopwuck RCC_CFGR_STOPWUCK_MSI or RCC_CFGR_STOPWUCK_HSI16
+ */
+void rcc_set_stop_wakeup_clock(uint32_t stopwuck)
+{
+	RCC_CFGR = (RCC_CFGR & ~RCC_CFGR_STOPWUCK_HSI16) | stopwuck;
+}
+
+/**
+ * Save the running clock configuration.
+ * Stop mode switches the oscillators and PLLs off and the system clock to
+ * MSI or HSI16 but keeps their configuration, prescalers and flash wait
+ * states.  Save the clock tree before Stop and bring it back after with
+ * rcc_clock_restore(), which only does the steps that are missing.
+ * @param state clock configuration
+ */
+void rcc_clock_save(struct rcc_clock_state *state)
+{
+	state->cr = RCC_CR;
+	state->cfgr = RCC_CFGR;
+	state->pllcfgr = RCC_PLLCFGR;
+	state->pllsai1cfgr = RCC_PLLSAI1_CFGR;
+	state->pllsai2cfgr = RCC_PLLSAI2_CFGR;
+	state->flash_ws = FLASH_ACR & FLASH_ACR_LATENCY_MASK;
+	state->ahb_frequency = rcc_ahb_frequency;
+	state->apb1_frequency = rcc_apb1_frequency;
+	state->apb2_frequency = rcc_apb2_frequency;
+}
+
+/**
+ * Start restoring a saved clock configuration.
+ * Switches on the saved oscillators and returns without waiting, so HSE
+ * starts while the code keeps running on the wake up clock.  Finish with
+ * rcc_clock_restore_poll() or rcc_clock_restore() before anything needs the
+ * saved clocks, e.g. in the drivers that need them, so wake ups that only
+ * handle an interrupt never wait for the PLL at all.
+ * @param state clock configuration from rcc_clock_save()
+ */
+void rcc_clock_restore_start(const struct rcc_clock_state *state)
+{
+	if ((state->cr & RCC_CR_HSEON) && !(RCC_CR & RCC_CR_HSEON)) {
+		RCC_CR |= state->cr & RCC_CR_HSEBYP;
+		RCC_CR |= RCC_CR_HSEON;
+	}
+	RCC_CR |= state->cr & (RCC_CR_MSION | RCC_CR_HSION);
+}
+
+static bool rcc_clock_restore_pll(const struct rcc_clock_state *state,
+				  uint32_t on, uint32_t rdy,
+				  volatile uint32_t *cfgr, uint32_t value)
+{
+	if (!(state->cr & on)) {
+		return true;
+	}
+	if (!(RCC_CR & on)) {
+		*cfgr = value;
+		RCC_CR |= on;
+	}
+	return RCC_CR & rdy;
+}
+
+/**
+ * Advance restoring a saved clock configuration.
+ * Does every step that is ready without waiting: PLLs on once their
+ * oscillators run, flash wait states and system clock switch once the PLL
+ * locked.  The bus frequencies are updated with the switch.
+ * @param state clock configuration from rcc_clock_save()
+ * @returns true when the saved configuration runs again
+ */
+bool rcc_clock_restore_poll(const struct rcc_clock_state *state)
+{
+	bool done = true;
+	uint32_t ready = 0;
+
+	rcc_clock_restore_start(state);
+	if (state->cr & RCC_CR_HSEON) {
+		ready |= RCC_CR_HSERDY;
+	}
+	if (state->cr & RCC_CR_HSION) {
+		ready |= RCC_CR_HSIRDY;
+	}
+	if (state->cr & RCC_CR_MSION) {
+		ready |= RCC_CR_MSIRDY;
+	}
+	if ((RCC_CR & ready) != ready) {
+		return false;
+	}
+	if (!rcc_clock_restore_pll(state, RCC_CR_PLLON, RCC_CR_PLLRDY,
+				   &RCC_PLLCFGR, state->pllcfgr)) {
+		return false;
+	}
+
+	if (rcc_system_clock_source() != (state->cfgr & RCC_CFGR_SW_MASK)) {
+		/* More wait states before speeding up */
+		if ((FLASH_ACR & FLASH_ACR_LATENCY_MASK) < state->flash_ws) {
+			flash_set_ws(state->flash_ws);
+		}
+		RCC_CFGR = state->cfgr;
+		if (rcc_system_clock_source() !=
+		    (state->cfgr & RCC_CFGR_SW_MASK)) {
+			return false;
+		}
+	}
+	if ((FLASH_ACR & FLASH_ACR_LATENCY_MASK) != state->flash_ws) {
+		flash_set_ws(state->flash_ws);
+	}
+	/* Wake up clock off again if it was not running before */
+	RCC_CR &= ~(~state->cr & (RCC_CR_MSION | RCC_CR_HSION));
+	rcc_ahb_frequency = state->ahb_frequency;
+	rcc_apb1_frequency = state->apb1_frequency;
+	rcc_apb2_frequency = state->apb2_frequency;
+
+	done &= rcc_clock_restore_pll(state, RCC_CR_PLLSAI1ON,
+				      RCC_CR_PLLSAI1RDY, &RCC_PLLSAI1_CFGR,
+				      state->pllsai1cfgr);
+	done &= rcc_clock_restore_pll(state, RCC_CR_PLLSAI2ON,
+				      RCC_CR_PLLSAI2RDY, &RCC_PLLSAI2_CFGR,
+				      state->pllsai2cfgr);
+	return done;
+}
+
+/**
+ * Restore a saved clock configuration.
+ * Returns at once when the configuration already runs.
+ * @param state clock configuration from rcc_clock_save()
+ */
+void rcc_clock_restore(const struct rcc_clock_state *state)
+{
+	while (!rcc_clock_restore_poll(state));
+}
+
+/*
+ * Dynamic voltage and frequency scaling
+ *
+ * rcc_dvfs_set_level() moves between performance levels at runtime, e.g.
+ * a few MHz from MSI in voltage range 2 while waiting for data and 80MHz
+ * from the PLL in range 1 to process it.  When the oscillators, PLL and
+ * voltage range stay the same it only changes the bus prescalers, with the
+ * flash wait states raised before and lowered after.  Otherwise it raises
+ * the voltage range first when going up, parks the system clock on HSI16
+ * with the wait states at their maximum, sets up MSI and the PLL for the
+ * new level, switches over and lowers the voltage range last when going
+ * down.  Oscillators the new level does not use are switched off if they
+ * were started here and no kernel clock in RCC_CCIPR, nor PLLSAI1 or
+ * PLLSAI2, runs from them.  The PLLSAIs take the PLL source of the main
+ * PLL, so while they run all levels must keep pllsrc.  The PWR clock must
+ * be enabled.
+ */
+
+static const struct rcc_dvfs_level *rcc_dvfs_current;
+static uint32_t rcc_dvfs_started;	/* RCC_CR_xxxON started here */
+
+static void rcc_dvfs_osc_on(enum rcc_osc osc, uint32_t on)
+{
+	if (!(RCC_CR & on)) {
+		rcc_dvfs_started |= on;
+		rcc_osc_on(osc);
+	}
+}
+
+/* RCC_CR_xxxON of the oscillators kernel clocks and PLLSAIs run from */
+static uint32_t rcc_dvfs_osc_in_use(void)
+{
+	static const uint32_t pllsrc_on[] = {
+		[RCC_PLLCFGR_PLLSRC_MSI] = RCC_CR_MSION,
+		[RCC_PLLCFGR_PLLSRC_HSI16] = RCC_CR_HSION,
+		[RCC_PLLCFGR_PLLSRC_HSE] = RCC_CR_HSEON,
+	};
+	uint32_t ccipr = RCC_CCIPR;
+	uint32_t in_use = 0;
+	int shift;
+
+	/* USARTs, LPUART1, I2Cs and LPTIMs all select HSI16 with 2 */
+	for (shift = 0; shift <= RCC_CCIPR_LPTIM2SEL_SHIFT; shift += 2) {
+		if (((ccipr >> shift) & 3) == RCC_CCIPR_USARTxSEL_HSI16) {
+			in_use |= RCC_CR_HSION;
+		}
+	}
+	if (ccipr & RCC_CCIPR_SWPMI1SEL) {
+		in_use |= RCC_CR_HSION;
+	}
+	if (((ccipr >> RCC_CCIPR_CLK48SEL_SHIFT) & RCC_CCIPR_CLK48SEL_MASK) ==
+	    RCC_CCIPR_CLK48SEL_MSI) {
+		in_use |= RCC_CR_MSION;
+	}
+	if (RCC_CR & (RCC_CR_PLLSAI1ON | RCC_CR_PLLSAI2ON)) {
+		in_use |= pllsrc_on[(RCC_PLLCFGR >> RCC_PLLCFGR_PLLSRC_SHIFT) &
+				    RCC_PLLCFGR_PLLSRC_MASK];
+	}
+	return in_use;
+}
+
+static void rcc_dvfs_osc_off(enum rcc_osc osc, uint32_t on)
+{
+	if ((rcc_dvfs_started & on) && !(rcc_dvfs_osc_in_use() & on)) {
+		rcc_dvfs_started &= ~on;
+		rcc_osc_off(osc);
+	}
+}
+
+static bool rcc_dvfs_uses(const struct rcc_dvfs_level *level,
+			  uint32_t sw, uint32_t pllsrc)
+{
+	return level->sysclk == sw ||
+	       (level->sysclk == RCC_CFGR_SW_PLL && level->pllsrc == pllsrc);
+}
+
+static bool rcc_dvfs_same_clocks(const struct rcc_dvfs_level *a,
+				 const struct rcc_dvfs_level *b)
+{
+	if (!a || a->sysclk != b->sysclk || a->vos != b->vos) {
+		return false;
+	}
+	if (rcc_dvfs_uses(b, RCC_CFGR_SW_MSI, RCC_PLLCFGR_PLLSRC_MSI) &&
+	    a->msi_range != b->msi_range) {
+		return false;
+	}
+	return b->sysclk != RCC_CFGR_SW_PLL ||
+	       (a->pllsrc == b->pllsrc && a->pllm == b->pllm &&
+		a->plln == b->plln && a->pllp == b->pllp &&
+		a->pllq == b->pllq && a->pllr == b->pllr);
+}
+
+static void rcc_dvfs_switch(const struct rcc_dvfs_level *level)
+{
+	if ((FLASH_ACR & FLASH_ACR_LATENCY_MASK) < level->flash_waitstates) {
+		flash_set_ws(level->flash_waitstates);
+	}
+
+	/* Keep the APB clocks in range in between */
+	if (level->ahb_frequency > rcc_ahb_frequency) {
+		rcc_set_ppre1(level->ppre1);
+		rcc_set_ppre2(level->ppre2);
+		rcc_set_hpre(level->hpre);
+	} else {
+		rcc_set_hpre(level->hpre);
+		rcc_set_ppre1(level->ppre1);
+		rcc_set_ppre2(level->ppre2);
+	}
+
+	rcc_set_sysclk_source(level->sysclk);
+	while (rcc_system_clock_source() != level->sysclk);
+
+	flash_set_ws(level->flash_waitstates);
+}
+
+/**
+ * Switch to a performance level.
+ * Blocks until the new clocks run, as long as HSE and PLL take to start
+ * when they have to.  Notifiers are called before and after the change from
+ * the calling context.
+ * @param level new level, must stay valid while it is in use
+ */
+void rcc_dvfs_set_level(const struct rcc_dvfs_level *level)
+{
+	bool msi = rcc_dvfs_uses(level, RCC_CFGR_SW_MSI,
+				 RCC_PLLCFGR_PLLSRC_MSI);
+	bool hsi = rcc_dvfs_uses(level, RCC_CFGR_SW_HSI16,
+				 RCC_PLLCFGR_PLLSRC_HSI16);
+	bool hse = rcc_dvfs_uses(level, RCC_CFGR_SW_HSE,
+				 RCC_PLLCFGR_PLLSRC_HSE);
+
+	if (level == rcc_dvfs_current) {
+		return;
+	}
+	rcc_dvfs_notify(RCC_DVFS_PRE_CHANGE, level);
+
+	if (rcc_dvfs_same_clocks(rcc_dvfs_current, level)) {
+		rcc_dvfs_switch(level);
+	} else {
+		/* HSE starts while the rest is done */
+		if (hse) {
+			rcc_dvfs_osc_on(RCC_HSE, RCC_CR_HSEON);
+		}
+
+		/* HSI16 runs in either range with the most wait states */
+		flash_set_ws(FLASH_ACR_LATENCY_4WS);
+		if (level->vos == PWR_SCALE1) {
+			pwr_set_vos_scale(PWR_SCALE1);
+			while (PWR_SR2 & PWR_SR2_VOSF);
+		}
+
+		rcc_dvfs_osc_on(RCC_HSI16, RCC_CR_HSION);
+		rcc_wait_for_osc_ready(RCC_HSI16);
+		rcc_set_sysclk_source(RCC_CFGR_SW_HSI16);
+		rcc_wait_for_sysclk_status(RCC_HSI16);
+		rcc_ahb_frequency = 16000000;
+
+		rcc_osc_off(RCC_PLL);
+		while (RCC_CR & RCC_CR_PLLRDY);
+
+		if (msi) {
+			rcc_dvfs_osc_on(RCC_MSI, RCC_CR_MSION);
+			rcc_wait_for_osc_ready(RCC_MSI);
+			rcc_set_msi_range(level->msi_range);
+			rcc_wait_for_osc_ready(RCC_MSI);
+		}
+		if (hse) {
+			rcc_wait_for_osc_ready(RCC_HSE);
+		}
+		if (level->sysclk == RCC_CFGR_SW_PLL) {
+			rcc_set_main_pll(level->pllsrc, level->pllm,
+					 level->plln, level->pllp,
+					 level->pllq, level->pllr);
+			rcc_osc_on(RCC_PLL);
+			rcc_wait_for_osc_ready(RCC_PLL);
+		}
+
+		rcc_dvfs_switch(level);
+
+		if (level->vos == PWR_SCALE2) {
+			pwr_set_vos_scale(PWR_SCALE2);
+		}
+		if (!msi) {
+			rcc_dvfs_osc_off(RCC_MSI, RCC_CR_MSION);
+		}
+		if (!hsi) {
+			rcc_dvfs_osc_off(RCC_HSI16, RCC_CR_HSION);
+		}
+		if (!hse) {
+			rcc_dvfs_osc_off(RCC_HSE, RCC_CR_HSEON);
+		}
+	}
+
+	rcc_ahb_frequency = level->ahb_frequency;
+	rcc_apb1_frequency = level->apb1_frequency;
+	rcc_apb2_frequency = level->apb2_frequency;
+	rcc_dvfs_current = level;
+
+	rcc_dvfs_notify(RCC_DVFS_POST_CHANGE, level);
+}
+
+/**
+ * Get the running performance level.
+ * @returns level set last, NULL before the first rcc_dvfs_set_level()
+ */
+const struct rcc_dvfs_level *rcc_dvfs_get_level(void)
+{
+	return rcc_dvfs_current;
+}
+
 /**@}*/
@@ -82,14 +82,47 @@
  *		usbd_poll(usb_dev);
  *	}
  * @endcode
+ *
+ * <b>uDMA endpoint transfers</b>
+ *
+ * Up to three IN and three OUT endpoints can have their FIFO serviced by the
+ * uDMA instead of the core, see @ref usb_ep_dma_enable(). Call it after the
+ * endpoint is set up, usually from the set configuration callback. Such an
+ * endpoint works in multi-packet mode, and keeps the usual usbd API:
+ *
+ * @ref usbd_ep_write_packet() takes a buffer of any length. It is cut into
+ * packets by the hardware, in uDMA runs of up to 1024 transfers, and the IN
+ * callback runs once the last packet has left the FIFO.
+ * The buffer must stay untouched until then. Writes shorter than a packet
+ * are done by the core as before.
+ *
+ * @ref usbd_ep_read_packet() on an empty endpoint arms a transfer into the
+ * buffer, as many whole packets as fit, and returns 0. The OUT callback runs
+ * when the buffer is full or a short packet ended the transfer, and the next
+ * read returns the length received. A packet that arrives while the data is
+ * not collected yet waits in the FIFO, so the OUT callback should read until
+ * it gets 0, which arms the next transfer:
+ * @code{.c}
+ *	static void data_rx_cb(usbd_device *usbd_dev, uint8_t ep)
+ *	{
+ *		uint16_t len;
+ *
+ *		while ((len = usbd_ep_read_packet(usbd_dev, ep, buf, 1024))) {
+ *			consume(buf, len);
+ *		}
+ *	}
+ * @endcode
+ *
+ * Completion of a uDMA transfer is signalled on the USB interrupt, no
+ * additional interrupt has to be enabled.
  * @{
  */
 
 /*
  * TODO list:
  *
- * 1) Driver works by reading and writing to the FIFOs one byte at a time. It
- * has no knowledge of DMA.
+ * 1) Only endpoints switched to uDMA with usb_ep_dma_enable() are serviced
+ * without the core, the others still go through the FIFO register.
  * 2) Double-buffering is supported. How can we take advantage of it to speed
  * up endpoint transfers.
  * 3) No benchmarks as to the endpoint's performance has been done.
@@ -102,16 +135,39 @@
 #include <libopencm3/cm3/common.h>
 #include <libopencm3/lm4f/usb.h>
 #include <libopencm3/lm4f/rcc.h>
+#include <libopencm3/lm4f/udma.h>
 #include <libopencm3/usb/usbd.h>
 #include "../../lib/usb/usb_private.h"
 
 #include <stdbool.h>
+#include <stddef.h>
 
 
 #define MAX_FIFO_RAM	(4 * 1024)
 
 const struct _usbd_driver lm4f_usb_driver;
 
+/*
+ * uDMA state of the endpoints. The index is the uDMA channel, which is also
+ * the USB_DMASEL field, even channels receive and odd channels transmit.
+ */
+enum lm4f_dma_state {
+	LM4F_DMA_IDLE,
+	LM4F_DMA_BUSY,		/* uDMA transfer running */
+	LM4F_DMA_TAIL,		/* IN: tail bytes wait for a free FIFO */
+	LM4F_DMA_DRAIN,		/* IN: last packet still in the FIFO */
+	LM4F_DMA_FULL,		/* OUT: data received, not collected yet */
+};
+
+static struct lm4f_ep_dma {
+	uint8_t ep;		/* 0 if the channel is free */
+	uint8_t state;
+	uint16_t len;		/* bytes in the transfer */
+	uint16_t count;		/* bytes moved by the uDMA, or being moved */
+	uint8_t size;		/* enum udma_size of the transfer */
+	uint8_t *buf;
+} lm4f_dma[USB_DMASEL_CHANNELS];
+
 /**
  * \brief Enable Specific USB Interrupts
  *
@@ -164,6 +220,97 @@ void usb_disable_interrupts(enum usb_interrupt ints,
 	USB_TXIE &= ~tx_ints;
 }
 
+/** @cond private */
+static struct lm4f_ep_dma *lm4f_dma_find(uint8_t ep, bool dir_tx)
+{
+	uint8_t ch;
+
+	for (ch = dir_tx; ch < USB_DMASEL_CHANNELS; ch += 2) {
+		if (lm4f_dma[ch].ep == ep) {
+			return &lm4f_dma[ch];
+		}
+	}
+	return NULL;
+}
+
+static void lm4f_dma_stop(struct lm4f_ep_dma *dma)
+{
+	const uint8_t ch = dma - lm4f_dma;
+
+	udma_channel_disable(ch);
+	udma_channel_clear_done(ch);
+	if (ch & 1) {
+		USB_TXCSRH(dma->ep) &= ~(USB_TXCSRH_AUTOSET | USB_TXCSRH_DMAEN |
+					 USB_TXCSRH_DMAMOD);
+	} else {
+		USB_RXCSRH(dma->ep) &= ~(USB_RXCSRH_AUTOCL | USB_RXCSRH_DMAEN |
+					 USB_RXCSRH_DMAMOD);
+	}
+	dma->state = LM4F_DMA_IDLE;
+}
+/** @endcond */
+
+/**
+ * \brief Service an endpoint with the uDMA
+ *
+ * Takes one of the three uDMA channels of the endpoint direction and switches
+ * the endpoint to multi-packet transfers, see the driver description. The
+ * uDMA controller is initialized if that has not been done yet.
+ *
+ * The setting is lost when the endpoints are reset, on bus reset and when a
+ * configuration is set.
+ *
+ * @param[in] addr Full endpoint address, 1 to 7, with direction bit
+ * @return false if the endpoint is invalid or no channel is left
+ */
+bool usb_ep_dma_enable(uint8_t addr)
+{
+	const uint8_t ep = addr & 0x0f;
+	const bool dir_tx = addr & 0x80;
+	struct lm4f_ep_dma *dma;
+	uint8_t ch;
+
+	if (ep == 0 || ep > 7) {
+		return false;
+	}
+	if (lm4f_dma_find(ep, dir_tx)) {
+		return true;
+	}
+	dma = lm4f_dma_find(0, dir_tx);
+	if (!dma) {
+		return false;
+	}
+
+	if (!(UDMA_STAT & UDMA_STAT_MASTEN)) {
+		udma_init();
+	}
+
+	ch = dma - lm4f_dma;
+	dma->ep = ep;
+	dma->state = LM4F_DMA_IDLE;
+	udma_channel_assign(ch, 0);
+	USB_DMASEL = (USB_DMASEL & ~USB_DMASEL_MASK(ch)) |
+		     (ep << USB_DMASEL_SHIFT(ch));
+	return true;
+}
+
+/**
+ * \brief Go back to servicing an endpoint with the core
+ *
+ * A transfer in progress is abandoned.
+ *
+ * @param[in] addr Full endpoint address, with direction bit
+ */
+void usb_ep_dma_disable(uint8_t addr)
+{
+	struct lm4f_ep_dma *dma = lm4f_dma_find(addr & 0x0f, addr & 0x80);
+
+	if ((addr & 0x0f) && dma) {
+		lm4f_dma_stop(dma);
+		dma->ep = 0;
+	}
+}
+
 /**
  * @cond private
  */
@@ -291,6 +438,15 @@ static void lm4f_ep_setup(usbd_device *usbd_dev, uint8_t addr, uint8_t type,
 
 static void lm4f_endpoints_reset(usbd_device *usbd_dev)
 {
+	int i;
+
+	for (i = 0; i < USB_DMASEL_CHANNELS; i++) {
+		if (lm4f_dma[i].ep) {
+			lm4f_dma_stop(&lm4f_dma[i]);
+			lm4f_dma[i].ep = 0;
+		}
+	}
+
 	/*
 	 * The core resets the endpoints automatically on reset.
 	 * The first 64 bytes are always reserved for EP0
@@ -357,14 +513,77 @@ static void lm4f_ep_nak_set(usbd_device *usbd_dev, uint8_t addr, uint8_t nak)
 	/* NAK's are handled automatically by hardware. Move along. */
 }
 
+/*
+ * Largest burst, as a power of two, that fits a packet of maxp bytes. The
+ * hardware only requests a transfer when a whole packet can be moved.
+ */
+static uint8_t lm4f_dma_arb(uint16_t maxp, enum udma_size size)
+{
+	uint8_t arb = 0;
+
+	while (arb < 10 && (2U << arb) <= (uint32_t)(maxp >> size)) {
+		arb++;
+	}
+	return arb;
+}
+
+/* Word transfers need a word aligned buffer and word sized packets */
+static enum udma_size lm4f_dma_size(const void *buf, uint16_t maxp)
+{
+	if (((uint32_t)buf & 3) || (maxp & 3)) {
+		return UDMA_SIZE_8;
+	}
+	return UDMA_SIZE_32;
+}
+
+/*
+ * Start the next uDMA run of an IN transfer. A run that is cut short by
+ * the transfer limit ends on a packet boundary, so AUTOSET has sent all of
+ * it when the next one starts.
+ */
+static void lm4f_dma_tx_run(struct lm4f_ep_dma *dma)
+{
+	const uint8_t ep = dma->ep;
+	const uint16_t maxp = USB_TXMAXP(ep);
+	const uint16_t run = ((UDMA_MAX_TRANSFER << dma->size) / maxp) * maxp;
+	const uint16_t items = MIN(dma->len - dma->count, run) >> dma->size;
+
+	udma_transfer_start(dma - lm4f_dma, (uint32_t)(dma->buf + dma->count),
+			    dma->size, (uint32_t)&USB_FIFO32(ep), UDMA_INC_NONE,
+			    dma->size, items, lm4f_dma_arb(maxp, dma->size));
+	dma->count += items << dma->size;
+}
+
+static uint16_t lm4f_dma_write(struct lm4f_ep_dma *dma, const void *buf,
+			       uint16_t len)
+{
+	const uint8_t ep = dma->ep;
+
+	dma->buf = (uint8_t *)buf;
+	dma->len = len;
+	dma->count = 0;
+	dma->size = lm4f_dma_size(buf, USB_TXMAXP(ep));
+	dma->state = LM4F_DMA_BUSY;
+
+	lm4f_dma_tx_run(dma);
+	USB_TXCSRH(ep) |= USB_TXCSRH_AUTOSET | USB_TXCSRH_DMAEN |
+			  USB_TXCSRH_DMAMOD;
+	return len;
+}
+
 static uint16_t lm4f_ep_write_packet(usbd_device *usbd_dev, uint8_t addr,
 			      const void *buf, uint16_t len)
 {
 	const uint8_t ep = addr & 0xf;
+	struct lm4f_ep_dma *dma = ep ? lm4f_dma_find(ep, true) : NULL;
 	uint16_t i;
 
 	(void)usbd_dev;
 
+	if (dma && dma->state != LM4F_DMA_IDLE) {
+		return 0;
+	}
+
 	/* Don't touch the FIFO if there is still a packet being transmitted */
 	if (ep == 0 && (USB_CSRL0 & USB_CSRL0_TXRDY)) {
 		return 0;
@@ -372,6 +591,11 @@ static uint16_t lm4f_ep_write_packet(usbd_device *usbd_dev, uint8_t addr,
 		return 0;
 	}
 
+	/* Anything shorter than a packet is quicker done by hand */
+	if (dma && len >= USB_TXMAXP(ep)) {
+		return lm4f_dma_write(dma, buf, len);
+	}
+
 	/*
 	 * We don't need to worry about buf not being aligned. If it's not,
 	 * the reads are downgraded to 8-bit in hardware. We lose a bit of
@@ -408,6 +632,33 @@ static uint16_t lm4f_ep_write_packet(usbd_device *usbd_dev, uint8_t addr,
 	return i;
 }
 
+static void lm4f_dma_read(struct lm4f_ep_dma *dma, void *buf, uint16_t len)
+{
+	const uint8_t ep = dma->ep;
+	const uint16_t maxp = USB_RXMAXP(ep);
+	const enum udma_size size = lm4f_dma_size(buf, maxp);
+	uint16_t items;
+
+	/* Whole packets only, a short one ends the transfer */
+	len -= len % maxp;
+	items = len >> size;
+	if (items > UDMA_MAX_TRANSFER) {
+		items = (UDMA_MAX_TRANSFER << size) / maxp * maxp >> size;
+	}
+
+	dma->buf = buf;
+	dma->len = items << size;
+	dma->count = 0;
+	dma->size = size;
+	dma->state = LM4F_DMA_BUSY;
+
+	udma_transfer_start(dma - lm4f_dma, (uint32_t)&USB_FIFO32(ep),
+			    UDMA_INC_NONE, (uint32_t)buf, size, size, items,
+			    lm4f_dma_arb(maxp, size));
+	USB_RXCSRH(ep) |= USB_RXCSRH_AUTOCL | USB_RXCSRH_DMAEN |
+			  USB_RXCSRH_DMAMOD;
+}
+
 static uint16_t lm4f_ep_read_packet(usbd_device *usbd_dev, uint8_t addr,
 				    void *buf, uint16_t len)
 {
@@ -415,6 +666,33 @@ static uint16_t lm4f_ep_read_packet(usbd_device *usbd_dev, uint8_t addr,
 
 	uint16_t rlen;
 	uint8_t ep = addr & 0xf;
+	struct lm4f_ep_dma *dma = ep ? lm4f_dma_find(ep, false) : NULL;
+
+	if (dma) {
+		switch (dma->state) {
+		case LM4F_DMA_BUSY:
+			return 0;
+		case LM4F_DMA_FULL:
+			/* Normally the buffer the transfer was armed with */
+			rlen = MIN(len, dma->count);
+			if (buf != dma->buf) {
+				for (len = 0; len < rlen; len++) {
+					((uint8_t *)buf)[len] = dma->buf[len];
+				}
+			}
+			dma->state = LM4F_DMA_IDLE;
+			return rlen;
+		default:
+			if (!(USB_RXCSRL(ep) & USB_RXCSRL_RXRDY)) {
+				if (len >= USB_RXMAXP(ep)) {
+					lm4f_dma_read(dma, buf, len);
+				}
+				return 0;
+			}
+			/* A packet is waiting already, fetch it by hand */
+			break;
+		}
+	}
 
 	uint16_t fifoin = USB_RXCOUNT(ep);
 
@@ -455,6 +733,106 @@ static uint16_t lm4f_ep_read_packet(usbd_device *usbd_dev, uint8_t addr,
 	return rlen;
 }
 
+/*
+ * IN transfer moved to the FIFO and the packets AUTOSET sent have left it,
+ * send the rest. A tail the word transfers could not move would otherwise
+ * land in a full packet that is still waiting with TXRDY set.
+ */
+static void lm4f_dma_tx_end(struct lm4f_ep_dma *dma)
+{
+	const uint8_t ep = dma->ep;
+	uint16_t i;
+
+	for (i = dma->count; i < dma->len; i++) {
+		USB_FIFO8(ep) = dma->buf[i];
+	}
+	if (dma->len % USB_TXMAXP(ep)) {
+		USB_TXCSRL(ep) |= USB_TXCSRL_TXRDY;
+	}
+	dma->state = LM4F_DMA_DRAIN;
+}
+
+/*
+ * OUT transfer ended by a short packet, which the uDMA does not touch in
+ * multi-packet mode. Collect it behind the whole packets.
+ */
+static void lm4f_dma_rx_short(struct lm4f_ep_dma *dma)
+{
+	const uint8_t ch = dma - lm4f_dma;
+	const uint8_t ep = dma->ep;
+	uint16_t rlen;
+
+	udma_channel_disable(ch);
+	dma->count = dma->len - (udma_transfer_remaining(ch) << dma->size);
+	lm4f_dma_stop(dma);
+
+	rlen = MIN(USB_RXCOUNT(ep), dma->len - dma->count);
+	while (rlen--) {
+		dma->buf[dma->count++] = USB_FIFO8(ep);
+	}
+	USB_RXCSRL(ep) &= ~USB_RXCSRL_RXRDY;
+}
+
+/*
+ * Advance the uDMA transfers. Returns the endpoints whose callbacks are due
+ * in done[] and the ones whose hardware interrupts belong to a transfer, and
+ * must not reach the callbacks, in busy[]. Index 0 is IN, 1 is OUT.
+ */
+static void lm4f_dma_poll(uint8_t done[2], uint8_t busy[2])
+{
+	struct lm4f_ep_dma *dma;
+	uint8_t ch;
+
+	done[0] = done[1] = busy[0] = busy[1] = 0;
+
+	for (ch = 0; ch < USB_DMASEL_CHANNELS; ch++) {
+		dma = &lm4f_dma[ch];
+		if (!dma->ep || dma->state == LM4F_DMA_IDLE) {
+			continue;
+		}
+
+		if (ch & 1) {
+			busy[0] |= 1 << dma->ep;
+			if (dma->state == LM4F_DMA_BUSY &&
+			    udma_channel_done(ch)) {
+				if ((dma->len - dma->count) >> dma->size) {
+					udma_channel_clear_done(ch);
+					lm4f_dma_tx_run(dma);
+				} else {
+					lm4f_dma_stop(dma);
+					dma->state = LM4F_DMA_TAIL;
+				}
+			}
+			if (dma->state == LM4F_DMA_TAIL &&
+			    !(USB_TXCSRL(dma->ep) & USB_TXCSRL_TXRDY)) {
+				lm4f_dma_tx_end(dma);
+			}
+			if (dma->state == LM4F_DMA_DRAIN &&
+			    !(USB_TXCSRL(dma->ep) & USB_TXCSRL_TXRDY)) {
+				dma->state = LM4F_DMA_IDLE;
+				done[0] |= 1 << dma->ep;
+			}
+			continue;
+		}
+
+		if (dma->state != LM4F_DMA_BUSY) {
+			continue;
+		}
+		busy[1] |= 1 << dma->ep;
+		if (udma_channel_done(ch)) {
+			lm4f_dma_stop(dma);
+			dma->count = dma->len;
+		} else if ((USB_RXCSRL(dma->ep) & USB_RXCSRL_RXRDY) &&
+			   USB_RXCOUNT(dma->ep) < USB_RXMAXP(dma->ep)) {
+			lm4f_dma_rx_short(dma);
+		} else {
+			continue;
+		}
+		dma->state = LM4F_DMA_FULL;
+		done[1] |= 1 << dma->ep;
+	}
+}
+
 static void lm4f_poll(usbd_device *usbd_dev)
 {
 	void (*tx_cb)(usbd_device *usbd_dev, uint8_t ea);
@@ -467,9 +845,21 @@ static void lm4f_poll(usbd_device *usbd_dev)
 	 * handle events.
 	 */
 	const uint8_t usb_is = USB_IS;
-	const uint8_t usb_rxis = USB_RXIS;
-	const uint8_t usb_txis = USB_TXIS;
+	uint8_t usb_rxis = USB_RXIS;
+	uint8_t usb_txis = USB_TXIS;
 	const uint8_t usb_csrl0 = USB_CSRL0;
+	uint8_t dma_done[2], dma_busy[2];
+
+	lm4f_dma_poll(dma_done, dma_busy);
+	if (dma_done[0]) {
+		/*
+		 * The last packet of a finished IN transfer may have raised
+		 * its interrupt since USB_TXIS was read. That one is ours.
+		 */
+		usb_txis |= USB_TXIS;
+	}
+	usb_txis = (usb_txis & ~dma_busy[0]) | dma_done[0];
+	usb_rxis = (usb_rxis & ~dma_busy[1]) | dma_done[1];
 
 	if ((usb_is & USB_IM_SUSPEND) && (usbd_dev->user_callback_suspend)) {
 		usbd_dev->user_callback_suspend();
@@ -527,14 +917,13 @@ static void lm4f_poll(usbd_device *usbd_dev)
 			 * hardware does not tell us what sort of transaction
 			 * this is. We need to work with the state machine to
 			 * figure it all out. See [1] for details.
+			 * The other endpoints must still be looked at, their
+			 * interrupt flags are already cleared.
 			 */
-			if ((usbd_dev->control_state.state != DATA_IN) &&
-			    (usbd_dev->control_state.state != LAST_DATA_IN) &&
-			    (usbd_dev->control_state.state != STATUS_IN)) {
-				return;
-			}
-
-			if (tx_cb) {
+			if (tx_cb &&
+			    (usbd_dev->control_state.state == DATA_IN ||
+			     usbd_dev->control_state.state == LAST_DATA_IN ||
+			     usbd_dev->control_state.state == STATUS_IN)) {
 				tx_cb(usbd_dev, 0);
 			}
 		}
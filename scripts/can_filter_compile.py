@@ -0,0 +1,268 @@
+#!/usr/bin/env python3
+# This python program packs a set of CAN IDs into STM32 bxCAN filter banks
+# at build time, the same way can_filter_compile() does at runtime.
+
+# This file is part of the libopencm3 project.
+#
+# This library is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library. If not, see <http://www.gnu.org/licenses/>.
+"""
+Usage: can_filter_compile.py [--banks N] [--name NAME] <rules> [<output.h>]
+
+The rules file has one rule per line, '#' starts a comment:
+    std|ext <id>[-<last>] [fifo0|fifo1] [can1|can2]
+IDs are C style numbers.  The default is fifo0 on can1.
+
+The output is a header with a 'const struct can_filter_bank NAME[]' table,
+NAME_COUNT and NAME_CAN2_START, ready for can_filter_apply(), and the false
+accept report in a comment.  --banks defaults to 28, use 14 on parts with a
+single CAN.  The exit status is 1 if the rules do not fit.
+"""
+
+import sys
+
+STD_MASK = 0x7ff
+EXT_MASK = 0x1fffffff
+
+
+def parse(path):
+    rules = []
+    with open(path) as f:
+        for lineno, line in enumerate(f, 1):
+            words = line.split("#", 1)[0].split()
+            if not words:
+                continue
+            try:
+                if words[0] not in ("std", "ext") or len(words) < 2:
+                    raise ValueError
+                ext = words[0] == "ext"
+                first, _, last = words[1].partition("-")
+                first = int(first, 0)
+                last = int(last, 0) if last else first
+                fifo, port = 0, 0
+                for w in words[2:]:
+                    if w in ("fifo0", "fifo1"):
+                        fifo = int(w[4])
+                    elif w in ("can1", "can2"):
+                        port = int(w[3]) - 1
+                    else:
+                        raise ValueError
+                if first > last or last > (EXT_MASK if ext else STD_MASK):
+                    raise ValueError
+            except ValueError:
+                sys.exit("%s:%d: malformed rule" % (path, lineno))
+            rules.append((first, last, port << 2 | fifo << 1 | int(ext)))
+    return rules
+
+
+def expand(first, last, group):
+    """Split first..last into aligned power of two blocks"""
+    blocks = []
+    while first <= last:
+        size = (first & -first) if first else 1 << 29
+        while size > last - first + 1:
+            size >>= 1
+        blocks.append([group, first, size])
+        first += size
+    return blocks
+
+
+def std_banks(s, m):
+    """Banks and moved singles for s single IDs and m standard blocks"""
+    return min(((s - k + 3) // 4 + (m + k + 1) // 2, k)
+               for k in range(min(s, 3) + 1))
+
+
+def group_banks(group, s, m):
+    if group & 1:
+        return (s + 1) // 2 + m, 0
+    return std_banks(s, m)
+
+
+def count(blocks):
+    s, m = [0] * 8, [0] * 8
+    for g, _, size in blocks:
+        if size == 1:
+            s[g] += 1
+        else:
+            m[g] += 1
+    return s, m
+
+
+def total_banks(blocks):
+    s, m = count(blocks)
+    return sum(group_banks(g, s[g], m[g])[0] for g in range(8))
+
+
+def merge(e):
+    """Merge neighbours, preferring merges that free a bank"""
+    s, m = count(e)
+    best = None
+    for i in range(len(e) - 1):
+        g = e[i][0]
+        if g != e[i + 1][0]:
+            continue
+        size = 1 << (e[i][1] ^ (e[i + 1][1] + e[i + 1][2] - 1)).bit_length()
+        base = e[i][1] & ~(size - 1)
+        j0 = i
+        while j0 > 0 and e[j0 - 1][0] == g and e[j0 - 1][1] >= base:
+            j0 -= 1
+        j1 = i + 1
+        while j1 + 1 < len(e) and e[j1 + 1][0] == g and \
+                e[j1 + 1][1] - base < size:
+            j1 += 1
+        absorbed = e[j0:j1 + 1]
+        ns = s[g] - sum(1 for b in absorbed if b[2] == 1)
+        nm = m[g] + 1 - sum(1 for b in absorbed if b[2] > 1)
+        saves = group_banks(g, ns, nm)[0] < group_banks(g, s[g], m[g])[0]
+        cost = size - sum(b[2] for b in absorbed)
+        key = (not saves, cost, -(j1 - j0))
+        if best is None or key < best[0]:
+            best = (key, j0, j1, base, size)
+    if best is None:
+        return False
+    _, j0, j1, base, size = best
+    e[j0:j1 + 1] = [[e[j0][0], base, size]]
+    return True
+
+
+def f16_std(i):
+    return i << 5
+
+
+def f16_mask(size):
+    return ((~(size - 1) & STD_MASK) << 5) | (1 << 3)
+
+
+def f32_ext(i):
+    return (i << 3) | (1 << 2)
+
+
+def f32_mask(size):
+    return ((~(size - 1) & EXT_MASK) << 3) | (1 << 2)
+
+
+def emit(blocks, group):
+    """Banks of one group as (scale_32bit, id_list_mode, fifo, fr1, fr2)"""
+    fifo = (group >> 1) & 1
+    ext = group & 1
+    moved = 0 if ext else std_banks(*[c[group] for c in count(blocks)])[1]
+    out, singles, masks = [], [], []
+    for g, i, size in blocks:
+        if g != group:
+            continue
+        if ext and size > 1:
+            out.append((1, 0, fifo, f32_ext(i), f32_mask(size)))
+        elif ext:
+            singles.append(f32_ext(i))
+            if len(singles) == 2:
+                out.append((1, 1, fifo, singles[0], singles[1]))
+                singles = []
+        elif size == 1 and moved == 0:
+            singles.append(f16_std(i))
+            if len(singles) == 4:
+                q = singles
+                out.append((0, 1, fifo, q[0] << 16 | q[1], q[2] << 16 | q[3]))
+                singles = []
+        else:
+            if size == 1:
+                moved -= 1
+            masks.append(f16_mask(size) << 16 | f16_std(i))
+            if len(masks) == 2:
+                out.append((0, 0, fifo, masks[0], masks[1]))
+                masks = []
+    if singles and ext:
+        out.append((1, 1, fifo, singles[0], singles[0]))
+    elif singles:
+        q = singles + [singles[0]] * (4 - len(singles))
+        out.append((0, 1, fifo, q[0] << 16 | q[1], q[2] << 16 | q[3]))
+    if masks:
+        out.append((0, 0, fifo, masks[0], masks[0]))
+    return out
+
+
+def compile_rules(rules, max_banks):
+    blocks = []
+    for first, last, group in rules:
+        blocks += expand(first, last, group)
+    blocks.sort(key=lambda b: (b[0], b[1], -b[2]))
+    e = []
+    for b in blocks:
+        if e and e[-1][0] == b[0] and b[1] - e[-1][1] < e[-1][2]:
+            continue
+        e.append(b)
+    wanted = sum(b[2] for b in e)
+    while total_banks(e) > max_banks:
+        if not merge(e):
+            return None
+    banks, can2_start = [], max_banks
+    for g in range(8):
+        if g == 4 and any(b[0] >= 4 for b in e):
+            can2_start = len(banks)
+        banks += emit(e, g)
+    accepted = sum(b[2] for b in e)
+    return banks, can2_start, wanted, accepted
+
+
+def main(argv):
+    max_banks, name = 28, "can_filter_table"
+    while argv and argv[0].startswith("--"):
+        opt = argv.pop(0)
+        if opt == "--banks":
+            max_banks = int(argv.pop(0))
+        elif opt == "--name":
+            name = argv.pop(0)
+        else:
+            print(__doc__, file=sys.stderr)
+            return 1
+    if not argv:
+        print(__doc__, file=sys.stderr)
+        return 1
+
+    result = compile_rules(parse(argv[0]), max_banks)
+    if result is None:
+        print("%s: rules do not fit in %d banks" % (argv[0], max_banks),
+              file=sys.stderr)
+        return 1
+    banks, can2_start, wanted, accepted = result
+    permille = (accepted - wanted) * 1000 // accepted if accepted else 0
+
+    lines = [
+        "/* Generated by can_filter_compile.py from %s, do not edit */" %
+        argv[0],
+        "/* %d of %d banks, %d IDs wanted, %d accepted, "
+        "false accept %d.%d%% */" % (len(banks), max_banks, wanted,
+                                     accepted, permille // 10, permille % 10),
+        "",
+        "#define %s_COUNT\t%d" % (name.upper(), len(banks)),
+        "#define %s_CAN2_START\t%d" % (name.upper(), can2_start),
+        "",
+        "static const struct can_filter_bank %s[] = {" % name,
+    ]
+    for nr, (scale, listmode, fifo, fr1, fr2) in enumerate(banks):
+        lines.append("\t{ %d, %s, %s, %d, 0x%08x, 0x%08x }," %
+                     (nr, "true" if scale else "false",
+                      "true" if listmode else "false", fifo, fr1, fr2))
+    lines.append("};")
+    text = "\n".join(lines) + "\n"
+
+    if len(argv) > 1:
+        with open(argv[1], "w") as f:
+            f.write(text)
+    else:
+        sys.stdout.write(text)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
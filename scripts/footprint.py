@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+# This python program reports code size and worst case stack usage for a
+# library archive, and checks them against a budget file.
+
+# This file is part of the libopencm3 project.
+#
+# This library is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library. If not, see <http://www.gnu.org/licenses/>.
+"""
+Usage: footprint.py [--prefix arm-none-eabi-] [--budget file] [--top N]
+                    <archive.a> <object.su>...
+
+The .su files are produced by building with -fstack-usage (STACK_USAGE=1).
+The call graph is taken from the call/tail call relocations in the archive,
+so the worst case stack of a function is its own frame plus the deepest
+chain of callees inside the archive.  Indirect calls (callbacks) and
+recursion can not be bounded this way, such results are marked with '+'.
+
+The budget file has one rule per line, '#' starts a comment:
+    <archive glob> text <bytes>             total .text of the archive
+    <archive glob> size <function> <bytes>  code size of one function
+    <archive glob> stack <function> <bytes> worst case stack of a function
+Every 'stack' rule also makes its function show up in the report.
+"""
+
+import fnmatch
+import os
+import re
+import subprocess
+import sys
+
+FUNC_RE = re.compile(r"^[0-9a-f]+ <([^>]+)>:$")
+CALL_RE = re.compile(r"^\s+[0-9a-f]+: R_ARM_(?:THM_CALL|THM_JUMP24|CALL|JUMP24)\s+(\S+)")
+ICALL_RE = re.compile(r"^\s+[0-9a-f]+:\s+[0-9a-f ]+\s+blx\s+(r\d+|ip|lr)")
+
+
+def run(cmd):
+    return subprocess.check_output(cmd, universal_newlines=True)
+
+
+def read_su(files):
+    """name -> (bytes, bounded)"""
+    frames = {}
+    for path in files:
+        if not os.path.exists(path):
+            continue
+        with open(path) as f:
+            for line in f:
+                fields = line.rstrip("\n").split("\t")
+                if len(fields) != 3:
+                    continue
+                name = fields[0].split(":")[-1]
+                size = int(fields[1])
+                bounded = fields[2].startswith("static")
+                old = frames.get(name, (0, True))
+                frames[name] = (max(old[0], size), old[1] and bounded)
+    return frames
+
+
+def read_callgraph(prefix, archive):
+    """name -> (set of callees, has indirect calls)"""
+    graph = {}
+    func = None
+    for line in run([prefix + "objdump", "-dr", archive]).splitlines():
+        m = FUNC_RE.match(line)
+        if m:
+            func = m.group(1)
+            graph.setdefault(func, [set(), False])
+            continue
+        if func is None:
+            continue
+        m = CALL_RE.match(line)
+        if m:
+            graph[func][0].add(m.group(1))
+            continue
+        if ICALL_RE.match(line):
+            graph[func][1] = True
+    return graph
+
+
+def read_sizes(prefix, archive):
+    """(function sizes, {section: total})"""
+    sizes = {}
+    for line in run([prefix + "nm", "--size-sort", "-S", archive]).splitlines():
+        fields = line.split()
+        if len(fields) == 4 and fields[2] in "tTwW":
+            sizes[fields[3]] = int(fields[1], 16)
+
+    totals = {"text": 0, "data": 0, "bss": 0}
+    for line in run([prefix + "size", archive]).splitlines()[1:]:
+        fields = line.split()
+        if len(fields) >= 3 and fields[0].isdigit():
+            totals["text"] += int(fields[0])
+            totals["data"] += int(fields[1])
+            totals["bss"] += int(fields[2])
+    return sizes, totals
+
+
+def worst_stack(name, frames, graph, memo, path):
+    """(bytes, exact, chain)"""
+    if name in memo:
+        return memo[name]
+    if name in path:
+        # recursion, can't be bounded
+        return (0, False, [name + "(recursive)"])
+
+    own, exact = frames.get(name, (0, False))
+    callees, indirect = graph.get(name, (set(), False))
+    exact = exact and not indirect
+    deepest = (0, True, [])
+    path.add(name)
+    for callee in sorted(callees):
+        res = worst_stack(callee, frames, graph, memo, path)
+        exact = exact and res[1]
+        if res[0] > deepest[0]:
+            deepest = res
+    path.discard(name)
+
+    res = (own + deepest[0], exact, [name] + deepest[2])
+    memo[name] = res
+    return res
+
+
+def read_budget(path, libname):
+    rules = []
+    with open(path) as f:
+        for lineno, line in enumerate(f, 1):
+            fields = line.split("#", 1)[0].split()
+            if not fields:
+                continue
+            if not fnmatch.fnmatch(libname, fields[0]):
+                continue
+            if fields[1] == "text" and len(fields) == 3:
+                rules.append(("text", None, int(fields[2], 0)))
+            elif fields[1] in ("size", "stack") and len(fields) == 4:
+                rules.append((fields[1], fields[2], int(fields[3], 0)))
+            else:
+                sys.exit("%s:%d: malformed budget rule" % (path, lineno))
+    return rules
+
+
+def main(argv):
+    prefix = "arm-none-eabi-"
+    budget = None
+    top = 10
+    while argv and argv[0].startswith("--"):
+        opt = argv.pop(0)
+        if opt == "--prefix":
+            prefix = argv.pop(0)
+        elif opt == "--budget":
+            budget = argv.pop(0)
+        elif opt == "--top":
+            top = int(argv.pop(0))
+        else:
+            print(__doc__, file=sys.stderr)
+            return 1
+    if not argv:
+        print(__doc__, file=sys.stderr)
+        return 1
+
+    archive = argv[0]
+    libname = os.path.splitext(os.path.basename(archive))[0]
+    frames = read_su(argv[1:])
+    graph = read_callgraph(prefix, archive)
+    sizes, totals = read_sizes(prefix, archive)
+    rules = read_budget(budget, libname) if budget else []
+    memo = {}
+
+    print("%s: text %d data %d bss %d" %
+          (libname, totals["text"], totals["data"], totals["bss"]))
+
+    print("  largest functions:")
+    for name in sorted(sizes, key=sizes.get, reverse=True)[:top]:
+        print("    %6d  %s" % (sizes[name], name))
+
+    entries = set(r[1] for r in rules if r[0] == "stack")
+    stacks = dict((name, worst_stack(name, frames, graph, memo, set()))
+                  for name in graph)
+    entries.update(sorted(stacks, key=lambda n: stacks[n][0], reverse=True)[:top])
+    print("  worst case stack:")
+    for name in sorted(entries, key=lambda n: stacks.get(n, (0,))[0], reverse=True):
+        if name not in stacks:
+            print("    %6s   %s (not in archive)" % ("-", name))
+            continue
+        depth, exact, chain = stacks[name]
+        print("    %6d%s  %s" % (depth, " " if exact else "+", " > ".join(chain)))
+
+    failed = 0
+    for kind, name, limit in rules:
+        if kind == "text":
+            value, what = totals["text"], "text"
+        elif kind == "size":
+            value, what = sizes.get(name, 0), "size of %s" % name
+        else:
+            value, what = stacks.get(name, (0,))[0], "stack of %s" % name
+        if value > limit:
+            print("%s: %s is %d bytes, budget is %d" % (libname, what, value, limit),
+                  file=sys.stderr)
+            failed = 1
+    return failed
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
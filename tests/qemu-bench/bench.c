@@ -0,0 +1,168 @@
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Measurement core and target independent kernels for the qemu benchmark
+ * firmware.  Timing is done with SysTick, which qemu clocks from its
+ * virtual clock.  With "-icount shift=0" every executed instruction advances
+ * that clock by exactly 1ns, making the reported ticks a deterministic
+ * function of the instruction count.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/systick.h>
+#if defined(LM3S)
+#include <libopencm3/lm3s/usart.h>
+#else
+#include <libopencm3/stm32/usart.h>
+#endif
+
+#include "bench.h"
+
+#define BENCH_USART_BYTES	256
+#define BENCH_USB_PACKET	64
+#define BENCH_ETH_FRAME		1514
+#define BENCH_COPY_ROUNDS	16
+
+static volatile uint32_t bench_overflows;
+static uint32_t bench_usart;
+
+static uint8_t bench_src[BENCH_ETH_FRAME + 2];
+static uint8_t bench_dst[BENCH_ETH_FRAME + 2];
+
+void sys_tick_handler(void)
+{
+	bench_overflows++;
+}
+
+void bench_init(void)
+{
+	systick_set_clocksource(STK_CSR_CLKSOURCE_AHB);
+	systick_set_reload(STK_RVR_RELOAD);
+	systick_clear();
+	systick_interrupt_enable();
+	systick_counter_enable();
+}
+
+static uint64_t bench_now(void)
+{
+	uint32_t hi, lo;
+
+	/* Re-read if the counter wrapped between the two samples */
+	do {
+		hi = bench_overflows;
+		lo = systick_get_value();
+	} while (hi != bench_overflows);
+
+	return ((uint64_t)hi << 24) + (STK_RVR_RELOAD - lo);
+}
+
+static void bench_puts(const char *s)
+{
+	while (*s) {
+		bench_putc(*s++);
+	}
+}
+
+static void bench_putu(uint32_t v)
+{
+	char buf[11];
+	int i = sizeof(buf) - 1;
+
+	buf[i] = '\0';
+	do {
+		buf[--i] = '0' + (v % 10);
+		v /= 10;
+	} while (v);
+	bench_puts(&buf[i]);
+}
+
+void bench_run(const char *name, bench_fn fn)
+{
+	uint64_t start, end;
+
+	start = bench_now();
+	fn();
+	end = bench_now();
+
+	bench_puts("BENCH ");
+	bench_puts(name);
+	bench_putc(' ');
+	bench_putu((uint32_t)(end - start));
+	bench_puts("\r\n");
+}
+
+static void bench_usart_send_blocking(void)
+{
+	int i;
+
+	for (i = 0; i < BENCH_USART_BYTES; i++) {
+		usart_send_blocking(bench_usart, i & 0xff);
+	}
+}
+
+/* The shape of the descriptor/packet copies done by the usb fifo helpers */
+static void bench_copy_usb_packet(void)
+{
+	int i;
+
+	for (i = 0; i < BENCH_COPY_ROUNDS; i++) {
+		memcpy(bench_dst, bench_src, BENCH_USB_PACKET);
+	}
+}
+
+/* ... and by eth_tx/eth_rx, including the misaligned payload case */
+static void bench_copy_eth_frame(void)
+{
+	int i;
+
+	for (i = 0; i < BENCH_COPY_ROUNDS; i++) {
+		memcpy(bench_dst, bench_src, BENCH_ETH_FRAME);
+		memcpy(bench_dst + 2, bench_src, BENCH_ETH_FRAME);
+	}
+}
+
+void bench_run_common(uint32_t usart)
+{
+	unsigned i;
+
+	for (i = 0; i < sizeof(bench_src); i++) {
+		bench_src[i] = i;
+	}
+
+	bench_usart = usart;
+	bench_run("usart_send_blocking_256", bench_usart_send_blocking);
+	bench_run("memcpy_usb_packet", bench_copy_usb_packet);
+	bench_run("memcpy_eth_frame", bench_copy_eth_frame);
+}
+
+void bench_exit(int status)
+{
+	/* ADP_Stopped_ApplicationExit or ADP_Stopped_RunTimeErrorUnknown */
+	register uint32_t r0 __asm__("r0") = 0x18;
+	register uint32_t r1 __asm__("r1") = status ? 0x20023 : 0x20026;
+
+	bench_puts(status ? "BENCH-FAIL\r\n" : "BENCH-DONE\r\n");
+	__asm__ volatile ("bkpt 0xab" : : "r"(r0), "r"(r1) : "memory");
+
+	/* Not running under qemu, or semihosting not enabled */
+	while (1);
+}
@@ -0,0 +1,71 @@
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	/** A benchmark kernel, run once per measurement. */
+	typedef void (*bench_fn)(void);
+
+	/**
+	 * Provided by each board: write one character to the console port.
+	 * This must not be the port used by the usart benchmarks.
+	 */
+	void bench_putc(char c);
+
+	/**
+	 * Start the SysTick based measurement clock.
+	 * Under qemu -icount the tick count is proportional to the number
+	 * of executed instructions, so results are fully deterministic.
+	 */
+	void bench_init(void);
+
+	/**
+	 * Run a kernel and print "BENCH <name> <ticks>" on the console.
+	 * @param name name of the benchmark, as used in the baseline file
+	 * @param fn kernel to run
+	 */
+	void bench_run(const char *name, bench_fn fn);
+
+	/**
+	 * Run the benchmarks shared by all targets.
+	 * @param usart usart (not the console!) for the send loop benchmark
+	 */
+	void bench_run_common(uint32_t usart);
+
+	/**
+	 * Run the benchmarks over the stm32 register accessors and crc unit.
+	 * The peripheral clocks must be enabled already.
+	 * @param gpioport port toggled by the gpio benchmark (pin 5)
+	 * @param spi spi peripheral for the byte exchange benchmark
+	 */
+	void bench_run_stm32(uint32_t gpioport, uint32_t spi);
+
+	/**
+	 * Terminate qemu through semihosting.
+	 * @param status 0 for success, anything else is reported as failure.
+	 */
+	void bench_exit(int status) __attribute__((noreturn));
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,78 @@
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Kernels over the stm32 register accessors.  Building the firmware with
+ * INLINE=1 defines CM3_INLINE_ACCESSORS, comparing both runs shows the cost
+ * of calling gpio_set/gpio_clear and spi_send/spi_read out of the library.
+ */
+
+#include <libopencm3/stm32/crc.h>
+#include <libopencm3/stm32/gpio.h>
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/spi.h>
+
+#include "bench.h"
+
+#define BENCH_TOGGLES		1024
+#define BENCH_SPI_BYTES		256
+
+static uint32_t bench_gpioport;
+static uint32_t bench_spi;
+static uint32_t crc_buf[256];
+
+static void bench_gpio_toggle(void)
+{
+	int i;
+
+	for (i = 0; i < BENCH_TOGGLES; i++) {
+		gpio_set(bench_gpioport, GPIO5);
+		gpio_clear(bench_gpioport, GPIO5);
+	}
+}
+
+static void bench_spi_byte(void)
+{
+	int i;
+
+	for (i = 0; i < BENCH_SPI_BYTES; i++) {
+		spi_send(bench_spi, i & 0xff);
+		(void)spi_read(bench_spi);
+	}
+}
+
+static void bench_crc_block(void)
+{
+	crc_reset();
+	crc_calculate_block(crc_buf, sizeof(crc_buf) / sizeof(crc_buf[0]));
+}
+
+void bench_run_stm32(uint32_t gpioport, uint32_t spi)
+{
+	bench_gpioport = gpioport;
+	bench_spi = spi;
+
+	spi_set_master_mode(spi);
+	spi_set_baudrate_prescaler(spi, SPI_CR1_BR_FPCLK_DIV_2);
+	spi_enable_software_slave_management(spi);
+	spi_set_nss_high(spi);
+	spi_enable(spi);
+
+	bench_run("gpio_toggle_1k", bench_gpio_toggle);
+	bench_run("spi_byte_256", bench_spi_byte);
+	bench_run("crc_calculate_block_1k", bench_crc_block);
+}
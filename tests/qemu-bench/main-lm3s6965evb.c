@@ -0,0 +1,40 @@
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * qemu -M lm3s6965evb
+ * UART0 is the console (qemu -serial stdio), UART1 is used by the
+ * usart benchmarks and left unconnected.
+ * The clock tree is left at its reset values, qemu does not model the
+ * PLL lock time and the measurements are in SysTick ticks anyway.
+ */
+
+#include <libopencm3/lm3s/usart.h>
+
+#include "bench.h"
+
+void bench_putc(char c)
+{
+	usart_send_blocking(USART0_BASE, c);
+}
+
+int main(void)
+{
+	bench_init();
+	bench_run_common(USART1_BASE);
+	bench_exit(0);
+}
@@ -0,0 +1,79 @@
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * qemu -M netduinoplus2 (STM32F405RG)
+ * USART1 is the console (qemu -serial stdio), USART2 is used by the
+ * usart benchmarks and left unconnected.
+ * qemu does not model the RCC of this part, so no clock setup is done, and
+ * the CRC unit and GPIO are only placeholders, the benchmarks over them
+ * measure the library side of the accesses only.
+ */
+
+#include <libopencm3/ethernet/mac.h>
+#include <libopencm3/stm32/gpio.h>
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/spi.h>
+#include <libopencm3/stm32/usart.h>
+
+#include "bench.h"
+
+#define ETH_TX_BUF_SIZE	1520
+#define ETH_FRAME_SIZE	1514
+
+static uint8_t eth_frame[ETH_FRAME_SIZE];
+static uint8_t eth_descs[2 * (ETH_TX_BUF_SIZE + ETH_DES_STD_SIZE)];
+
+static void usart_setup(uint32_t usart)
+{
+	usart_set_baudrate(usart, 115200);
+	usart_set_databits(usart, 8);
+	usart_set_stopbits(usart, USART_STOPBITS_1);
+	usart_set_mode(usart, USART_MODE_TX);
+	usart_set_parity(usart, USART_PARITY_NONE);
+	usart_set_flow_control(usart, USART_FLOWCONTROL_NONE);
+	usart_enable(usart);
+}
+
+/* One descriptor, so every call copies the full frame into it. */
+static void bench_eth_tx(void)
+{
+	eth_desc_init(eth_descs, 1, 1, ETH_TX_BUF_SIZE, ETH_TX_BUF_SIZE, false);
+	eth_tx(eth_frame, sizeof(eth_frame));
+}
+
+void bench_putc(char c)
+{
+	usart_send_blocking(USART1, c);
+}
+
+int main(void)
+{
+	rcc_periph_clock_enable(RCC_USART1);
+	rcc_periph_clock_enable(RCC_USART2);
+	rcc_periph_clock_enable(RCC_CRC);
+	rcc_periph_clock_enable(RCC_GPIOA);
+	rcc_periph_clock_enable(RCC_SPI1);
+	usart_setup(USART1);
+	usart_setup(USART2);
+
+	bench_init();
+	bench_run_common(USART2);
+	bench_run_stm32(GPIOA, SPI1);
+	bench_run("eth_tx_frame", bench_eth_tx);
+	bench_exit(0);
+}
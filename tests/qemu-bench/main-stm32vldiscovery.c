@@ -0,0 +1,63 @@
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * qemu -M stm32vldiscovery (STM32F100RB)
+ * USART1 is the console (qemu -serial stdio), USART2 is used by the
+ * usart benchmarks and left unconnected.
+ * qemu does not model the RCC, CRC or GPIO units of this part, see
+ * main-netduinoplus2.c.
+ */
+
+#include <libopencm3/stm32/gpio.h>
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/spi.h>
+#include <libopencm3/stm32/usart.h>
+
+#include "bench.h"
+
+static void usart_setup(uint32_t usart)
+{
+	usart_set_baudrate(usart, 115200);
+	usart_set_databits(usart, 8);
+	usart_set_stopbits(usart, USART_STOPBITS_1);
+	usart_set_mode(usart, USART_MODE_TX);
+	usart_set_parity(usart, USART_PARITY_NONE);
+	usart_set_flow_control(usart, USART_FLOWCONTROL_NONE);
+	usart_enable(usart);
+}
+
+void bench_putc(char c)
+{
+	usart_send_blocking(USART1, c);
+}
+
+int main(void)
+{
+	rcc_periph_clock_enable(RCC_USART1);
+	rcc_periph_clock_enable(RCC_USART2);
+	rcc_periph_clock_enable(RCC_CRC);
+	rcc_periph_clock_enable(RCC_GPIOA);
+	rcc_periph_clock_enable(RCC_SPI1);
+	usart_setup(USART1);
+	usart_setup(USART2);
+
+	bench_init();
+	bench_run_common(USART2);
+	bench_run_stm32(GPIOA, SPI1);
+	bench_exit(0);
+}
@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+#
+# This file is part of the libopencm3 project.
+#
+# This library is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library.  If not, see <http://www.gnu.org/licenses/>.
+#
+"""
+Boots a qemu-bench firmware under qemu system emulation, collects the
+SysTick measurements it prints, the section sizes and the sizes of the
+library entry points of interest, and compares everything against the
+stored baseline for that machine.
+
+Exits non zero if the firmware failed or any value regressed by more than
+the allowed tolerance.
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+
+# Library symbols whose code size is tracked, when present in the image
+TRACKED_SYMBOLS = [
+    "reset_handler",
+    "usart_send_blocking",
+    "crc_calculate_block",
+    "gpio_set",
+    "gpio_clear",
+    "spi_send",
+    "spi_read",
+    "eth_desc_init",
+    "eth_tx",
+    "memcpy",
+]
+
+BENCH_RE = re.compile(r"^BENCH (\S+) (\d+)\s*$")
+INSNS_RE = re.compile(r"^(?:total )?insns: (\d+)")
+
+
+def run_qemu(args):
+    cmd = [args.qemu, "-M", args.machine, "-nographic", "-monitor", "none",
+           "-serial", "stdio",
+           "-semihosting-config", "enable=on,target=native",
+           "-icount", "shift=0",
+           "-kernel", args.elf]
+    if args.plugin:
+        cmd += ["-plugin", args.plugin, "-d", "plugin"]
+    try:
+        p = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                           timeout=args.timeout, universal_newlines=True)
+    except subprocess.TimeoutExpired:
+        sys.exit("%s: qemu timed out after %d seconds" % (args.elf, args.timeout))
+
+    results = {}
+    done = False
+    for line in p.stdout.splitlines():
+        m = BENCH_RE.match(line)
+        if m:
+            results["ticks." + m.group(1)] = int(m.group(2))
+            continue
+        m = INSNS_RE.match(line)
+        if m:
+            # Whole run, so this is where the startup code shows up
+            results["insns.total"] = int(m.group(1))
+            continue
+        if line.startswith("BENCH-DONE"):
+            done = True
+    if not done or p.returncode != 0:
+        print(p.stdout)
+        sys.exit("%s: firmware did not complete (exit code %d)" % (args.elf, p.returncode))
+    return results
+
+
+def collect_sizes(args):
+    results = {}
+    out = subprocess.check_output([args.prefix + "size", "-A", args.elf],
+                                  universal_newlines=True)
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0] in (".text", ".data", ".bss"):
+            results["size" + fields[0]] = int(fields[1])
+
+    out = subprocess.check_output([args.prefix + "nm", "--size-sort", "-S", args.elf],
+                                  universal_newlines=True)
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) == 4 and fields[3] in TRACKED_SYMBOLS:
+            results["size.sym." + fields[3]] = int(fields[1], 16)
+    return results
+
+
+def compare(results, baseline, tolerance):
+    failed = False
+    for key in sorted(results):
+        now = results[key]
+        old = baseline.get(key)
+        if old is None:
+            print("  %-40s %10d  (new)" % (key, now))
+            continue
+        delta = (now - old) * 100.0 / old if old else 0.0
+        bad = now > old * (1.0 + tolerance / 100.0)
+        print("  %-40s %10d  %+7.2f%%%s" % (key, now, delta, "  REGRESSION" if bad else ""))
+        failed |= bad
+    for key in sorted(set(baseline) - set(results)):
+        print("  %-40s    missing" % key)
+    return failed
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf", help="firmware image to run")
+    parser.add_argument("--machine", required=True, help="qemu machine, eg lm3s6965evb")
+    parser.add_argument("--prefix", default="arm-none-eabi-", help="binutils prefix")
+    parser.add_argument("--qemu", default="qemu-system-arm")
+    parser.add_argument("--plugin", default=os.environ.get("QEMU_INSN_PLUGIN"),
+                        help="path to qemu's libinsn.so, adds the total instruction count")
+    parser.add_argument("--baseline", help="defaults to baseline-<machine>.json")
+    parser.add_argument("--tolerance", type=float, default=0.0,
+                        help="allowed growth in percent before failing")
+    parser.add_argument("--update", action="store_true",
+                        help="store the results as the new baseline")
+    parser.add_argument("--timeout", type=int, default=60)
+    args = parser.parse_args()
+
+    baseline_file = args.baseline or os.path.join(
+        os.path.dirname(os.path.abspath(__file__)), "baseline-%s.json" % args.machine)
+
+    results = run_qemu(args)
+    results.update(collect_sizes(args))
+
+    if args.update or not os.path.exists(baseline_file):
+        with open(baseline_file, "w") as f:
+            json.dump(results, f, indent=4, sort_keys=True)
+            f.write("\n")
+        print("%s: baseline written to %s" % (args.machine, baseline_file))
+        return 0
+
+    with open(baseline_file) as f:
+        baseline = json.load(f)
+
+    print("%s:" % args.machine)
+    if compare(results, baseline, args.tolerance):
+        print("%s: regressions found, see above" % args.machine)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())